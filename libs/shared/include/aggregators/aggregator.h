@@ -1,35 +1,34 @@
 #pragma once
 #include "defs.h"
+#include <span>
 
 namespace LxGeo
 {
 	namespace GeometryFactoryShared
 	{
 
-		template<typename unit,
-			template<typename, typename> class Container = std::list,
-			template<typename> class Allocator = std::allocator>
+		// Aggregators reduce a contiguous view of pixel values (ex: PinnedPixels::view()) to a scalar
+		template<typename unit>
 		class Aggregator {
 		public:
-			typedef typename Container<unit, Allocator<unit>> container_t;
+			typedef std::span<const unit> values_view_t;
 			Aggregator() {};
-			virtual cv::Scalar operator()(container_t& container) = 0;
+			virtual cv::Scalar operator()(values_view_t values) = 0;
 		};
 
-		template<typename unit,
-			template<typename, typename> class Container = std::list,
-			template<typename> class Allocator = std::allocator>
-		class MeanAggregator : public Aggregator<unit, Container, Allocator> {
-			using Aggregator<unit, Container, Allocator>::Aggregator;
-			typedef typename Container<unit, Allocator<unit>> container_t;
+		template<typename unit>
+		class MeanAggregator : public Aggregator<unit> {
+		public:
+			using Aggregator<unit>::Aggregator;
+			typedef typename Aggregator<unit>::values_view_t values_view_t;
 
-			cv::Scalar operator()(container_t& container) override {
+			cv::Scalar operator()(values_view_t values) override {
 				auto init = cv::Vec<double, unit::channels>::zeros();
-				for (const auto& el : container) {
+				for (const auto& el : values) {
 					for (int c_ch = 0; c_ch < unit::channels; c_ch++)
 						init[c_ch] += el[c_ch];
 				}
-				return init / std::max(1.0, double(container.size()));
+				return init / std::max(1.0, double(values.size()));
 			}
 		};
 
@@ -43,27 +42,29 @@ namespace LxGeo
 		}
 
 
-		template<typename unit,
-			template<typename, typename> class Container = std::list,
-			template<typename> class Allocator = std::allocator>
-		class MedianAggregator : public Aggregator<unit, Container, Allocator> {
-			using Aggregator<unit, Container, Allocator>::Aggregator;
-			typedef typename Container<unit, Allocator<unit>> container_t;
-
+		template<typename unit>
+		class MedianAggregator : public Aggregator<unit> {
 		public:
-			cv::Scalar operator()(container_t& container) override {
+			using Aggregator<unit>::Aggregator;
+			typedef typename Aggregator<unit>::values_view_t values_view_t;
+
+			cv::Scalar operator()(values_view_t values) override {
 				auto init = cv::Vec<double, unit::channels>::zeros();
-				if (container.size() == 0)
+				if (values.size() == 0)
 					return init;
 
-				std::vector<unit> v_container(container.begin(), container.end());
+				// channel values are selected in a per thread buffer reused between calls (a shared aggregator stays reentrant)
+				thread_local std::vector<double> channel_values;
+				size_t n = values.size() / 2;
 				for (int c_ch = 0; c_ch < unit::channels; c_ch++) {
-					auto temp_getter = [&](const unit& el)->double {return el[c_ch]; };
-					init[c_ch] = median<double, unit>(v_container, temp_getter);
+					channel_values.resize(values.size());
+					for (size_t value_idx = 0; value_idx < values.size(); value_idx++)
+						channel_values[value_idx] = values[value_idx][c_ch];
+					std::nth_element(channel_values.begin(), channel_values.begin() + n, channel_values.end(), std::greater<double>());
+					init[c_ch] = channel_values[n];
 				}
 				return init;
 			}
-
 		};
 
 	}
@@ -0,0 +1,78 @@
+#pragma once
+#include "defs.h"
+#include <mutex>
+#include <condition_variable>
+
+namespace LxGeo
+{
+    namespace GeometryFactoryShared
+    {
+
+        /**
+        * Blocking FIFO queue with a fixed capacity shared between producer and consumer threads.
+        * push blocks while the queue is full (back-pressure) and pop blocks while it is empty.
+        * Once closed, push is rejected and pop drains the remaining elements before returning false.
+        */
+        template<typename T>
+        class BoundedQueue {
+        public:
+            BoundedQueue(size_t _capacity) : capacity(std::max<size_t>(_capacity, 1)), closed(false) {}
+
+            BoundedQueue(const BoundedQueue&) = delete;
+            BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+            // Returns false if the queue was closed before the element could be added.
+            bool push(T&& el) {
+                std::unique_lock<std::mutex> lock(mtx);
+                not_full.wait(lock, [this]() { return closed || elements.size() < capacity; });
+                if (closed)
+                    return false;
+                elements.push_back(std::move(el));
+                lock.unlock();
+                not_empty.notify_one();
+                return true;
+            }
+
+            // Returns false if the queue is closed and empty.
+            bool pop(T& el) {
+                std::unique_lock<std::mutex> lock(mtx);
+                not_empty.wait(lock, [this]() { return closed || !elements.empty(); });
+                if (elements.empty())
+                    return false;
+                el = std::move(elements.front());
+                elements.pop_front();
+                lock.unlock();
+                not_full.notify_one();
+                return true;
+            }
+
+            void close() {
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    closed = true;
+                }
+                not_full.notify_all();
+                not_empty.notify_all();
+            }
+
+            size_t size() const {
+                std::lock_guard<std::mutex> lock(mtx);
+                return elements.size();
+            }
+
+            bool is_closed() const {
+                std::lock_guard<std::mutex> lock(mtx);
+                return closed;
+            }
+
+        private:
+            mutable std::mutex mtx;
+            std::condition_variable not_full;
+            std::condition_variable not_empty;
+            std::deque<T> elements;
+            size_t capacity;
+            bool closed;
+        };
+
+    }
+}
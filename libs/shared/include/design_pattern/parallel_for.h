@@ -0,0 +1,55 @@
+#pragma once
+#include "defs.h"
+#include <thread>
+
+namespace LxGeo
+{
+    namespace GeometryFactoryShared
+    {
+
+        // Threads count used when n_threads is 0
+        inline size_t default_threads_count() {
+            return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        /**
+        * Splits [0, count) into n_threads contiguous chunks and calls chunk_fn(begin, end) for each chunk on its own thread.
+        * The last chunk runs on the caller thread. The first exception thrown by a chunk is rethrown once all chunks are done.
+        */
+        template<typename chunk_fn_type>
+            requires std::invocable<chunk_fn_type&, size_t, size_t>
+        void parallel_for_chunks(size_t count, size_t n_threads, chunk_fn_type&& chunk_fn) {
+            if (n_threads == 0)
+                n_threads = default_threads_count();
+            n_threads = std::min(n_threads, count);
+            if (n_threads <= 1) {
+                if (count > 0)
+                    chunk_fn(size_t(0), count);
+                return;
+            }
+
+            size_t chunk_size = count / n_threads, remainder = count % n_threads;
+            std::vector<std::exception_ptr> errors(n_threads);
+            std::vector<std::thread> threads; threads.reserve(n_threads - 1);
+            size_t begin = 0;
+            for (size_t thread_idx = 0; thread_idx < n_threads; thread_idx++) {
+                size_t end = begin + chunk_size + (thread_idx < remainder ? 1 : 0);
+                auto run_chunk = [&chunk_fn, &errors, thread_idx, begin, end]() {
+                    try { chunk_fn(begin, end); }
+                    catch (...) { errors[thread_idx] = std::current_exception(); }
+                };
+                if (thread_idx + 1 < n_threads)
+                    threads.emplace_back(run_chunk);
+                else
+                    run_chunk();
+                begin = end;
+            }
+            for (auto& c_thread : threads)
+                c_thread.join();
+            for (auto& c_error : errors)
+                if (c_error)
+                    std::rethrow_exception(c_error);
+        }
+
+    }
+}
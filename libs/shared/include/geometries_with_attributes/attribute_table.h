@@ -0,0 +1,365 @@
+#pragma once
+#include "defs.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+
+namespace LxGeo
+{
+	namespace GeometryFactoryShared
+	{
+		enum class AttributeType {
+			int64,
+			real,
+			string // dictionary encoded
+		};
+
+		typedef uint32_t field_id;
+
+		/**
+		Columnar storage of features attributes: one schema shared by all rows and one contiguous typed column per field.
+		Field names are interned once in the schema, fields are then accessed by id. Each type has its own names space
+		(an int and a string field may share a name). Unset values are tracked by a validity bitmap per column.
+		Row accessors may run concurrently: values are owned by their row and validity bits are set atomically, so distinct rows
+		are written without locking each other out. Adding a field, a string value to a dictionary or rows takes the table exclusively.
+		References returned by the column accessors are only valid while no rows or dictionary values are added.
+		*/
+		class AttributeTable {
+
+			struct column {
+				std::string name;
+				AttributeType type;
+				std::vector<int64_t> int_values;
+				std::vector<double> real_values;
+				std::vector<uint32_t> string_codes;
+				std::vector<std::string> dictionary;
+				std::unordered_map<std::string, uint32_t> dictionary_codes;
+				std::vector<uint64_t> valid_bits;
+			};
+
+		public:
+			AttributeTable() {};
+
+			AttributeTable(const AttributeTable& other) {
+				std::shared_lock other_lock(other.table_mutex);
+				columns = other.columns;
+				for (size_t type_idx = 0; type_idx < 3; type_idx++)
+					field_ids[type_idx] = other.field_ids[type_idx];
+				n_rows = other.n_rows;
+			}
+
+			AttributeTable& operator=(const AttributeTable& other) {
+				if (this != &other) {
+					std::unique_lock lock(table_mutex, std::defer_lock);
+					std::shared_lock other_lock(other.table_mutex, std::defer_lock);
+					std::lock(lock, other_lock);
+					columns = other.columns;
+					for (size_t type_idx = 0; type_idx < 3; type_idx++)
+						field_ids[type_idx] = other.field_ids[type_idx];
+					n_rows = other.n_rows;
+				}
+				return *this;
+			}
+
+			size_t rows_count() const {
+				std::shared_lock lock(table_mutex);
+				return n_rows;
+			}
+
+			size_t fields_count() const {
+				std::shared_lock lock(table_mutex);
+				return columns.size();
+			}
+
+			// columns are never removed nor moved (deque storage), names stay valid
+			const std::string& field_name(field_id fid) const {
+				std::shared_lock lock(table_mutex);
+				return columns[fid].name;
+			}
+
+			AttributeType field_type(field_id fid) const {
+				std::shared_lock lock(table_mutex);
+				return columns[fid].type;
+			}
+
+			// Returns the id of an existing field or adds it (with null values for existing rows)
+			field_id add_field(const std::string& name, AttributeType type) {
+				{
+					std::shared_lock lock(table_mutex);
+					if (auto fid = find_field_id(name, type))
+						return *fid;
+				}
+				std::unique_lock lock(table_mutex);
+				return insert_field(name, type);
+			}
+
+			std::optional<field_id> find_field(const std::string& name, AttributeType type) const {
+				std::shared_lock lock(table_mutex);
+				return find_field_id(name, type);
+			}
+
+			// Fields of the given type in schema order
+			std::vector<field_id> fields_of_type(AttributeType type) const {
+				std::shared_lock lock(table_mutex);
+				std::vector<field_id> fids;
+				for (field_id fid = 0; fid < columns.size(); fid++)
+					if (columns[fid].type == type)
+						fids.push_back(fid);
+				return fids;
+			}
+
+			// Appends a row with null values and returns its index
+			size_t add_row() {
+				std::unique_lock lock(table_mutex);
+				resize_rows(n_rows + 1);
+				return n_rows - 1;
+			}
+
+			// Appends count rows with null values
+			void add_rows(size_t count) {
+				std::unique_lock lock(table_mutex);
+				resize_rows(n_rows + count);
+			}
+
+			void reserve(size_t rows) {
+				std::unique_lock lock(table_mutex);
+				for (auto& c_column : columns) {
+					switch (c_column.type) {
+					case AttributeType::int64: c_column.int_values.reserve(rows); break;
+					case AttributeType::real: c_column.real_values.reserve(rows); break;
+					case AttributeType::string: c_column.string_codes.reserve(rows); break;
+					}
+					c_column.valid_bits.reserve((rows + 63) / 64);
+				}
+			}
+
+			/**
+			Appends the rows of other (fields are matched by name and type, missing ones are added).
+			Returns the index of the first appended row.
+			*/
+			size_t append_rows(const AttributeTable& other) {
+				std::unique_lock lock(table_mutex, std::defer_lock);
+				std::shared_lock other_lock(other.table_mutex, std::defer_lock);
+				std::lock(lock, other_lock);
+				size_t rows_offset = n_rows;
+				resize_rows(n_rows + other.n_rows);
+
+				for (const column& other_column : other.columns) {
+					field_id fid = insert_field(other_column.name, other_column.type);
+					column& c_column = columns[fid];
+					switch (c_column.type) {
+					case AttributeType::int64:
+						std::copy(other_column.int_values.begin(), other_column.int_values.end(), c_column.int_values.begin() + rows_offset);
+						break;
+					case AttributeType::real:
+						std::copy(other_column.real_values.begin(), other_column.real_values.end(), c_column.real_values.begin() + rows_offset);
+						break;
+					case AttributeType::string: {
+						// dictionary codes of other to codes of this table
+						std::vector<uint32_t> codes_map(other_column.dictionary.size());
+						for (uint32_t other_code = 0; other_code < other_column.dictionary.size(); other_code++) {
+							const std::string& value = other_column.dictionary[other_code];
+							auto code_it = c_column.dictionary_codes.find(value);
+							if (code_it != c_column.dictionary_codes.end())
+								codes_map[other_code] = code_it->second;
+							else {
+								codes_map[other_code] = static_cast<uint32_t>(c_column.dictionary.size());
+								c_column.dictionary.push_back(value);
+								c_column.dictionary_codes.emplace(value, codes_map[other_code]);
+							}
+						}
+						for (size_t row = 0; row < other.n_rows; row++)
+							if (other_column.valid_bits[row / 64] & (uint64_t(1) << (row % 64)))
+								c_column.string_codes[rows_offset + row] = codes_map[other_column.string_codes[row]];
+						break;
+					}
+					}
+					for (size_t row = 0; row < other.n_rows; row++)
+						if (other_column.valid_bits[row / 64] & (uint64_t(1) << (row % 64)))
+							set_valid(rows_offset + row, fid);
+				}
+				return rows_offset;
+			}
+
+			/**
+			Bulk column assignment: rows_count() values and a validity bitmap of (rows_count() + 63) / 64 words.
+			String columns take their codes with the dictionary they refer to.
+			*/
+			void assign_int_column(field_id fid, const int64_t* values, const uint64_t* valid_bits) {
+				std::unique_lock lock(table_mutex);
+				column& c_column = checked_column(fid, AttributeType::int64);
+				std::copy(values, values + n_rows, c_column.int_values.begin());
+				std::copy(valid_bits, valid_bits + c_column.valid_bits.size(), c_column.valid_bits.begin());
+			}
+
+			void assign_double_column(field_id fid, const double* values, const uint64_t* valid_bits) {
+				std::unique_lock lock(table_mutex);
+				column& c_column = checked_column(fid, AttributeType::real);
+				std::copy(values, values + n_rows, c_column.real_values.begin());
+				std::copy(valid_bits, valid_bits + c_column.valid_bits.size(), c_column.valid_bits.begin());
+			}
+
+			void assign_string_column(field_id fid, const uint32_t* codes, std::vector<std::string> dictionary, const uint64_t* valid_bits) {
+				std::unique_lock lock(table_mutex);
+				column& c_column = checked_column(fid, AttributeType::string);
+				std::copy(codes, codes + n_rows, c_column.string_codes.begin());
+				c_column.dictionary = std::move(dictionary);
+				c_column.dictionary_codes.clear();
+				for (uint32_t code = 0; code < c_column.dictionary.size(); code++)
+					c_column.dictionary_codes.emplace(c_column.dictionary[code], code);
+				std::copy(valid_bits, valid_bits + c_column.valid_bits.size(), c_column.valid_bits.begin());
+			}
+
+			// Sets all values of a row to null (rows are never reused)
+			void clear_row(size_t row) {
+				std::shared_lock lock(table_mutex);
+				for (field_id fid = 0; fid < columns.size(); fid++)
+					reset_valid(row, fid);
+			}
+
+			bool is_null(size_t row, field_id fid) const {
+				std::shared_lock lock(table_mutex);
+				return !is_valid(row, fid);
+			}
+
+			void set_null(size_t row, field_id fid) {
+				std::shared_lock lock(table_mutex);
+				reset_valid(row, fid);
+			}
+
+			void set_int(size_t row, field_id fid, int64_t value) {
+				std::shared_lock lock(table_mutex);
+				checked_column(fid, AttributeType::int64).int_values[row] = value;
+				set_valid(row, fid);
+			}
+
+			int64_t get_int(size_t row, field_id fid) const {
+				std::shared_lock lock(table_mutex);
+				return checked_value_column(row, fid, AttributeType::int64).int_values[row];
+			}
+
+			void set_double(size_t row, field_id fid, double value) {
+				std::shared_lock lock(table_mutex);
+				checked_column(fid, AttributeType::real).real_values[row] = value;
+				set_valid(row, fid);
+			}
+
+			double get_double(size_t row, field_id fid) const {
+				std::shared_lock lock(table_mutex);
+				return checked_value_column(row, fid, AttributeType::real).real_values[row];
+			}
+
+			// Values already in the dictionary are set under the shared lock, new values take the table exclusively
+			void set_string(size_t row, field_id fid, const std::string& value) {
+				{
+					std::shared_lock lock(table_mutex);
+					column& c_column = checked_column(fid, AttributeType::string);
+					auto code_it = c_column.dictionary_codes.find(value);
+					if (code_it != c_column.dictionary_codes.end()) {
+						c_column.string_codes[row] = code_it->second;
+						set_valid(row, fid);
+						return;
+					}
+				}
+				std::unique_lock lock(table_mutex);
+				column& c_column = checked_column(fid, AttributeType::string);
+				auto code_it = c_column.dictionary_codes.try_emplace(value, static_cast<uint32_t>(c_column.dictionary.size())).first;
+				if (code_it->second == c_column.dictionary.size())
+					c_column.dictionary.push_back(value);
+				c_column.string_codes[row] = code_it->second;
+				set_valid(row, fid);
+			}
+
+			// Returned by value: the dictionary may grow concurrently
+			std::string get_string(size_t row, field_id fid) const {
+				std::shared_lock lock(table_mutex);
+				const column& c_column = checked_value_column(row, fid, AttributeType::string);
+				return c_column.dictionary[c_column.string_codes[row]];
+			}
+
+			// Contiguous columns (values of null rows are unspecified)
+			const std::vector<int64_t>& int_column(field_id fid) const { std::shared_lock lock(table_mutex); return checked_column(fid, AttributeType::int64).int_values; }
+			const std::vector<double>& double_column(field_id fid) const { std::shared_lock lock(table_mutex); return checked_column(fid, AttributeType::real).real_values; }
+			const std::vector<uint32_t>& string_codes_column(field_id fid) const { std::shared_lock lock(table_mutex); return checked_column(fid, AttributeType::string).string_codes; }
+			const std::vector<std::string>& string_dictionary(field_id fid) const { std::shared_lock lock(table_mutex); return checked_column(fid, AttributeType::string).dictionary; }
+			const std::vector<uint64_t>& validity_bitmap(field_id fid) const { std::shared_lock lock(table_mutex); return columns[fid].valid_bits; }
+
+		private:
+			std::optional<field_id> find_field_id(const std::string& name, AttributeType type) const {
+				const auto& type_ids = field_ids[static_cast<size_t>(type)];
+				auto id_it = type_ids.find(name);
+				if (id_it == type_ids.end())
+					return std::nullopt;
+				return id_it->second;
+			}
+
+			// Requires the exclusive lock
+			field_id insert_field(const std::string& name, AttributeType type) {
+				if (auto fid = find_field_id(name, type))
+					return *fid;
+				column& new_column = columns.emplace_back();
+				new_column.name = name;
+				new_column.type = type;
+				resize_column(new_column, n_rows);
+				field_id fid = static_cast<field_id>(columns.size() - 1);
+				field_ids[static_cast<size_t>(type)][name] = fid;
+				return fid;
+			}
+
+			// Requires the exclusive lock
+			void resize_rows(size_t rows) {
+				n_rows = rows;
+				for (auto& c_column : columns)
+					resize_column(c_column, n_rows);
+			}
+
+			static void resize_column(column& c_column, size_t rows) {
+				switch (c_column.type) {
+				case AttributeType::int64: c_column.int_values.resize(rows); break;
+				case AttributeType::real: c_column.real_values.resize(rows); break;
+				case AttributeType::string: c_column.string_codes.resize(rows); break;
+				}
+				c_column.valid_bits.resize((rows + 63) / 64, 0);
+			}
+
+			// validity words span 64 rows: bits are updated atomically so that rows sharing a word are set concurrently
+			void set_valid(size_t row, field_id fid) {
+				std::atomic_ref<uint64_t>(columns[fid].valid_bits[row / 64]).fetch_or(uint64_t(1) << (row % 64), std::memory_order_relaxed);
+			}
+
+			void reset_valid(size_t row, field_id fid) {
+				std::atomic_ref<uint64_t>(columns[fid].valid_bits[row / 64]).fetch_and(~(uint64_t(1) << (row % 64)), std::memory_order_relaxed);
+			}
+
+			bool is_valid(size_t row, field_id fid) const {
+				uint64_t& valid_word = const_cast<uint64_t&>(columns[fid].valid_bits[row / 64]);
+				return (std::atomic_ref<uint64_t>(valid_word).load(std::memory_order_relaxed) & (uint64_t(1) << (row % 64))) != 0;
+			}
+
+			column& checked_column(field_id fid, AttributeType type) {
+				if (fid >= columns.size() || columns[fid].type != type)
+					throw std::runtime_error("Attribute field id does not match the requested type!");
+				return columns[fid];
+			}
+
+			const column& checked_column(field_id fid, AttributeType type) const {
+				return const_cast<AttributeTable*>(this)->checked_column(fid, type);
+			}
+
+			const column& checked_value_column(size_t row, field_id fid, AttributeType type) const {
+				const column& c_column = checked_column(fid, type);
+				if (!is_valid(row, fid))
+					throw std::runtime_error("Error : couldn't find attribute.");
+				return c_column;
+			}
+
+		private:
+			std::deque<column> columns;
+			std::unordered_map<std::string, field_id> field_ids[3]; // by AttributeType
+			size_t n_rows = 0;
+			mutable std::shared_mutex table_mutex; // exclusive for schema, dictionaries and rows count changes
+		};
+
+	}
+}
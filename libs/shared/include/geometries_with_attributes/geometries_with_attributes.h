@@ -1,62 +1,105 @@
 #pragma once
 #include "defs.h"
 #include "defs_boost.h"
+#include "geometries_with_attributes/attribute_table.h"
 
 namespace LxGeo
 {
 	namespace GeometryFactoryShared
 	{
 		namespace bg = boost::geometry;
+
+		/**
+		Attributes are either stored in the geometry itself (standalone geometries) or in a row of an AttributeTable
+		shared by a GeoVector (bound geometries), the accessors below being the same in both cases.
+		Copies are standalone while moves keep the binding.
+		Accessors of distinct bound geometries may run concurrently (see AttributeTable), accessors of one geometry may not.
+		*/
 		template <typename T>
 		class Geometries_with_attributes
 		{
+			struct local_attributes_storage {
+				std::map<std::string, double> double_attributes;
+				std::map<std::string, int> int_attributes;
+				std::map<std::string, std::string> string_attributes;
+			};
+
 		public:
 			Geometries_with_attributes() {};
 			Geometries_with_attributes(const T& _definition);
 			Geometries_with_attributes(const Geometries_with_attributes<T>& ref_geom_wa) { // This new constructor may generate problems
 				bg::assign(get_definition(), ref_geom_wa.get_definition());
-				double_attributes.insert(ref_geom_wa.double_attributes.begin(), ref_geom_wa.double_attributes.end());
-				int_attributes.insert(ref_geom_wa.int_attributes.begin(), ref_geom_wa.int_attributes.end());
-				string_attributes.insert(ref_geom_wa.string_attributes.begin(), ref_geom_wa.string_attributes.end());
+				copy_attributes(ref_geom_wa);
 			}
+			Geometries_with_attributes(Geometries_with_attributes<T>&& ref_geom_wa) noexcept = default;
 			template <typename ref_T>
 			Geometries_with_attributes(const Geometries_with_attributes<ref_T>& ref_geom_wa) { // This new constructor may generate problems
-				std::list<std::string> int_attributes, double_attributes, string_attributes;
-				ref_geom_wa.get_list_of_double_attributes(double_attributes);
-				ref_geom_wa.get_list_of_int_attributes(int_attributes);
-				ref_geom_wa.get_list_of_string_attributes(string_attributes);
-
-				for (const std::string& field_name : double_attributes)
-					set_double_attribute(field_name, ref_geom_wa.get_double_attribute(field_name));
-				for (const std::string& field_name : int_attributes)
-					set_int_attribute(field_name, ref_geom_wa.get_int_attribute(field_name));
-				for (const std::string& field_name : string_attributes)
-					set_string_attribute(field_name, ref_geom_wa.get_string_attribute(field_name));
+				copy_attributes(ref_geom_wa);
 			}
 			~Geometries_with_attributes() { }
 
+			Geometries_with_attributes& operator=(const Geometries_with_attributes<T>& ref_geom_wa) {
+				if (this != &ref_geom_wa) {
+					definition = ref_geom_wa.definition;
+					attributes_table.reset();
+					local_attributes.reset();
+					copy_attributes(ref_geom_wa);
+				}
+				return *this;
+			}
+			Geometries_with_attributes& operator=(Geometries_with_attributes<T>&& ref_geom_wa) noexcept = default;
+
 			void set_definition(const T& _definition) { definition = _definition; }
 			const T& get_definition() const { return definition; }
 			T& get_definition() { return definition; }
 
-			void set_double_attribute(const std::string& name, const double& val) { double_attributes[name] = val; }
+			void set_double_attribute(const std::string& name, const double& val);
 			double get_double_attribute(const std::string& name) const;
 
-			void set_int_attribute(const std::string& name, const int& val) { int_attributes[name] = val; }
+			void set_int_attribute(const std::string& name, const int& val);
 			int get_int_attribute(const std::string& name) const;
 
-			void set_string_attribute(const std::string& name, const std::string& val) { string_attributes[name] = val; }
+			void set_string_attribute(const std::string& name, const std::string& val);
 			std::string get_string_attribute(const std::string& name) const;
 
 			void get_list_of_double_attributes(std::list<std::string>& A) const;
 			void get_list_of_int_attributes(std::list<std::string>& A) const;
 			void get_list_of_string_attributes(std::list<std::string>& A) const;
 
+			/**
+			Moves the current attributes into a row of table. Following accessors read and write that row.
+			*/
+			void bind_attributes(const std::shared_ptr<AttributeTable>& table, size_t row);
+
+			/**
+			Refers to a row of table already holding the attributes of this geometry (no attribute is moved).
+			*/
+			void attach_attributes_row(const std::shared_ptr<AttributeTable>& table, size_t row) {
+				attributes_table = table;
+				attributes_row = row;
+				local_attributes.reset();
+			}
+
+			const std::shared_ptr<AttributeTable>& get_attributes_table() const { return attributes_table; }
+			size_t get_attributes_row() const { return attributes_row; }
+
+		protected:
+			template <typename ref_T>
+			void copy_attributes(const Geometries_with_attributes<ref_T>& ref_geom_wa);
+
+			local_attributes_storage& local() {
+				if (!local_attributes)
+					local_attributes = std::make_unique<local_attributes_storage>();
+				return *local_attributes;
+			}
+
 		protected:
 			T definition;
-			std::map<std::string, double> double_attributes;
-			std::map<std::string, int> int_attributes;
-			std::map<std::string, std::string> string_attributes;
+			std::unique_ptr<local_attributes_storage> local_attributes; // standalone attributes (allocated on first set)
+			std::shared_ptr<AttributeTable> attributes_table; // set for bound geometries
+			size_t attributes_row = 0;
+
+			template <typename other_T> friend class Geometries_with_attributes;
 		};
 
 		template <typename geometry_type>
@@ -1,5 +1,4 @@
-
-namespace LxGeo 
+namespace LxGeo
 {
 	namespace GeometryFactoryShared
 	{
@@ -9,11 +8,46 @@ namespace LxGeo
 			set_definition(_definition);
 		}
 
+		template <typename T>
+		void Geometries_with_attributes<T>::set_int_attribute(const std::string & name, const int & val)
+		{
+			if (attributes_table)
+				attributes_table->set_int(attributes_row, attributes_table->add_field(name, AttributeType::int64), val);
+			else
+				local().int_attributes[name] = val;
+		}
+
+		template <typename T>
+		void Geometries_with_attributes<T>::set_double_attribute(const std::string & name, const double & val)
+		{
+			if (attributes_table)
+				attributes_table->set_double(attributes_row, attributes_table->add_field(name, AttributeType::real), val);
+			else
+				local().double_attributes[name] = val;
+		}
+
+		template <typename T>
+		void Geometries_with_attributes<T>::set_string_attribute(const std::string & name, const std::string & val)
+		{
+			if (attributes_table)
+				attributes_table->set_string(attributes_row, attributes_table->add_field(name, AttributeType::string), val);
+			else
+				local().string_attributes[name] = val;
+		}
+
 		template <typename T>
 		int Geometries_with_attributes<T>::get_int_attribute(const std::string & name) const
 		{
-			auto it = int_attributes.find(name);
-			if (it == int_attributes.cend()) {
+			if (attributes_table) {
+				auto fid = attributes_table->find_field(name, AttributeType::int64);
+				if (!fid)
+					throw std::exception("Error : couldn't find attribute.");
+				return static_cast<int>(attributes_table->get_int(attributes_row, *fid));
+			}
+			if (!local_attributes)
+				throw std::exception("Error : couldn't find attribute.");
+			auto it = local_attributes->int_attributes.find(name);
+			if (it == local_attributes->int_attributes.cend()) {
 				throw std::exception("Error : couldn't find attribute.");
 			}
 
@@ -23,8 +57,16 @@ namespace LxGeo
 		template <typename T>
 		double Geometries_with_attributes<T>::get_double_attribute(const std::string & name) const
 		{
-			auto it = double_attributes.find(name);
-			if (it == double_attributes.cend()) {
+			if (attributes_table) {
+				auto fid = attributes_table->find_field(name, AttributeType::real);
+				if (!fid)
+					throw std::exception("Error : couldn't find attribute.");
+				return attributes_table->get_double(attributes_row, *fid);
+			}
+			if (!local_attributes)
+				throw std::exception("Error : couldn't find attribute.");
+			auto it = local_attributes->double_attributes.find(name);
+			if (it == local_attributes->double_attributes.cend()) {
 				throw std::exception("Error : couldn't find attribute.");
 			}
 
@@ -34,18 +76,39 @@ namespace LxGeo
 		template <typename T>
 		std::string Geometries_with_attributes<T>::get_string_attribute(const std::string & name) const
 		{
-			auto it = string_attributes.find(name);
-			if (it == string_attributes.cend()) {
+			if (attributes_table) {
+				auto fid = attributes_table->find_field(name, AttributeType::string);
+				if (!fid)
+					throw std::exception("Error : couldn't find attribute.");
+				return attributes_table->get_string(attributes_row, *fid);
+			}
+			if (!local_attributes)
+				throw std::exception("Error : couldn't find attribute.");
+			auto it = local_attributes->string_attributes.find(name);
+			if (it == local_attributes->string_attributes.cend()) {
 				throw std::exception("Error : couldn't find attribute.");
 			}
 
 			return it->second;
 		}
 
+		// Names of the non null fields of type in the bound row
+		static inline void list_table_row_fields(const AttributeTable& table, size_t row, AttributeType type, std::list<std::string>& A)
+		{
+			for (field_id fid : table.fields_of_type(type)) {
+				if (!table.is_null(row, fid))
+					A.push_back(table.field_name(fid));
+			}
+		}
+
 		template <typename T>
 		void Geometries_with_attributes<T>::get_list_of_int_attributes(std::list<std::string> & A) const
 		{
-			for (auto it = int_attributes.cbegin(); it != int_attributes.cend(); ++it) {
+			if (attributes_table)
+				return list_table_row_fields(*attributes_table, attributes_row, AttributeType::int64, A);
+			if (!local_attributes)
+				return;
+			for (auto it = local_attributes->int_attributes.cbegin(); it != local_attributes->int_attributes.cend(); ++it) {
 				A.push_back(it->first);
 			}
 		}
@@ -53,7 +116,11 @@ namespace LxGeo
 		template <typename T>
 		void Geometries_with_attributes<T>::get_list_of_double_attributes(std::list<std::string> & A) const
 		{
-			for (auto it = double_attributes.cbegin(); it != double_attributes.cend(); ++it) {
+			if (attributes_table)
+				return list_table_row_fields(*attributes_table, attributes_row, AttributeType::real, A);
+			if (!local_attributes)
+				return;
+			for (auto it = local_attributes->double_attributes.cbegin(); it != local_attributes->double_attributes.cend(); ++it) {
 				A.push_back(it->first);
 			}
 		}
@@ -61,10 +128,54 @@ namespace LxGeo
 		template <typename T>
 		void Geometries_with_attributes<T>::get_list_of_string_attributes(std::list<std::string> & A) const
 		{
-			for (auto it = string_attributes.cbegin(); it != string_attributes.cend(); ++it) {
+			if (attributes_table)
+				return list_table_row_fields(*attributes_table, attributes_row, AttributeType::string, A);
+			if (!local_attributes)
+				return;
+			for (auto it = local_attributes->string_attributes.cbegin(); it != local_attributes->string_attributes.cend(); ++it) {
 				A.push_back(it->first);
 			}
 		}
 
+		template <typename T>
+		template <typename ref_T>
+		void Geometries_with_attributes<T>::copy_attributes(const Geometries_with_attributes<ref_T>& ref_geom_wa)
+		{
+			if (!ref_geom_wa.attributes_table && !attributes_table) {
+				if (ref_geom_wa.local_attributes)
+					local_attributes = std::make_unique<local_attributes_storage>(
+						local_attributes_storage{ ref_geom_wa.local_attributes->double_attributes, ref_geom_wa.local_attributes->int_attributes, ref_geom_wa.local_attributes->string_attributes }
+					);
+				return;
+			}
+
+			std::list<std::string> int_attributes, double_attributes, string_attributes;
+			ref_geom_wa.get_list_of_double_attributes(double_attributes);
+			ref_geom_wa.get_list_of_int_attributes(int_attributes);
+			ref_geom_wa.get_list_of_string_attributes(string_attributes);
+
+			for (const std::string& field_name : double_attributes)
+				set_double_attribute(field_name, ref_geom_wa.get_double_attribute(field_name));
+			for (const std::string& field_name : int_attributes)
+				set_int_attribute(field_name, ref_geom_wa.get_int_attribute(field_name));
+			for (const std::string& field_name : string_attributes)
+				set_string_attribute(field_name, ref_geom_wa.get_string_attribute(field_name));
+		}
+
+		template <typename T>
+		void Geometries_with_attributes<T>::bind_attributes(const std::shared_ptr<AttributeTable>& table, size_t row)
+		{
+			if (table == attributes_table && row == attributes_row)
+				return;
+			Geometries_with_attributes<T> previous_attributes;
+			if (attributes_table)
+				previous_attributes.copy_attributes(*this);
+			else
+				previous_attributes.local_attributes = std::move(local_attributes);
+
+			attach_attributes_row(table, row);
+			copy_attributes(previous_attributes);
+		}
+
 	}
-}
\ No newline at end of file
+}
@@ -21,21 +21,19 @@ namespace LxGeo
 			std::vector<GeoImage<cv_mat_type>> output_masks; output_masks.reserve(gvector.length());
 
 			// map of rasterization label for each geoemetry (labels are of type 2**i)
-			std::vector<size_t> geometries_labels_vector;
+			std::vector<size_t> geometries_labels_vector(gvector.length());
 
 			// since labels count should not be high (limited by the value type) \\ for example; for 64 geometries we will need 2**64 labels
 			// we reset labels for every connected component
-			std::unordered_map<size_t, size_t> in_component_labels;			
 			SpatialWeights<geometry_type> PSW = SpatialWeights<geometry_type>(gvector.geometries_container, gvector.rtree);
 			WeightsDistanceBandParams wdbp = { 0, true, -1, [](double x)->double { return x; } };
 			PSW.fill_distance_band_graph(wdbp);
 			PSW.run_labeling();
 
-			for (size_t geometry_idx = 0; geometry_idx < gvector.length(); geometry_idx++) {
-				size_t label_value = 1 << in_component_labels[PSW.component_labels[geometry_idx]];
-				geometries_labels_vector.push_back(label_value);
-				in_component_labels[PSW.component_labels[geometry_idx]] += 1;
-			}
+			PSW.for_each_component([&geometries_labels_vector](size_t, std::span<const size_t> members) {
+				for (size_t in_component_label = 0; in_component_label < members.size(); in_component_label++)
+					geometries_labels_vector[members[in_component_label]] = size_t(1) << in_component_label;
+				});
 
 
 			//***************** Create memory shapefile ******************//
@@ -0,0 +1,29 @@
+#pragma once
+#include "defs.h"
+#include "defs_boost.h"
+#include "export_shared.h"
+
+namespace LxGeo
+{
+	namespace GeometryFactoryShared
+	{
+
+		// Pixels [col_begin, col_end) of a raster row
+		struct PixelRun {
+			int row;
+			int col_begin;
+			int col_end;
+
+			int length() const { return col_end - col_begin; }
+		};
+
+		/**
+		Scanline rasterization of a polygon given in continuous pixel coordinates (pixel (col, row) covers [col, col + 1) x [row, row + 1)).
+		Edges crossings of every row center line are computed once, pixels whose center lies inside the polygon (even-odd rule,
+		holes excluded) are returned as runs clipped to the rows x cols raster. With all_touched, pixels crossed by the polygon
+		boundary are added. Runs are sorted by row then column and do not overlap. out_runs is cleared first.
+		*/
+		LX_GEO_FACTORY_SHARED_API void polygon_pixel_runs(const Boost_Polygon_2& pixel_polygon, int rows, int cols, bool all_touched, std::vector<PixelRun>& out_runs);
+
+	}
+}
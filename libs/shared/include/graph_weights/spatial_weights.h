@@ -2,11 +2,13 @@
 #include "defs.h"
 #include <boost/graph/graph_traits.hpp>
 #include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/connected_components.hpp>
 #include "geometries_with_attributes/geometries_with_attributes.h"
 #include "geometries_with_attributes/linestring_with_attributes.h"
 #include "spatial_index/spatial_indexed_geometry_container.h"
 #include "lightweight/geovector.h"
+#include "graph_weights/weights_csr.h"
+#include "design_pattern/parallel_for.h"
+#include <atomic>
 
 
 namespace LxGeo
@@ -38,11 +40,18 @@ namespace LxGeo
 			double threshold; // distance threshold
 			bool binary = false; // If true w_{ij}=1 if d_{i,j}<=threshold, otherwise w_{i,j}=0
 			double alpha = -1.0f;  // distance decay parameter for weight
-			std::function<double(double)> distance_kernel;
+			std::function<double(double)> distance_kernel; // called concurrently by the graph builder threads
+			size_t n_threads = 0; // graph builder threads (0: hardware concurrency)
 		};
 
 		struct WeightsKNNParams {
 			size_t K; // number of nearest neighbors
+			size_t n_threads = 0; // graph builder threads (0: hardware concurrency)
+		};
+
+		struct WeightsContiguityParams {
+			double snap_tolerance = 1e-9; // vertices are matched on a grid of this step
+			size_t n_threads = 0; // graph builder threads (0: hardware concurrency)
 		};
 
 		template <typename geom_type>
@@ -64,10 +73,10 @@ namespace LxGeo
 			};
 
 			SpatialWeights(const std::vector<geom_type>& input_geometries) : SpatialIndexedGeometryContainer<geom_type>() {
-				_reset();
 				geometries_container.reserve(input_geometries.size());
 				for (auto& c_geom : input_geometries)
 					geometries_container.push_back(Geometries_with_attributes<geom_type>(c_geom));
+				_reset();
 				init_rtree();
 			};
 
@@ -88,11 +97,13 @@ namespace LxGeo
 
 			~SpatialWeights() {};
 
+			// Empty graph of length() rows (rows_count() matches the geometries before any fill_*)
 			void _reset() {
-				weights_graph.clear();
-				weights_graph = WeightsGraph(length());
+				weights_csr = weights_csr_from_edges(length(), {});
 				component_labels.clear();
 				component_labels.reserve(length());
+				component_offsets.assign(1, 0);
+				component_members.clear();
 				max_neighbors = NULL;
 				min_neighbors = NULL;
 				mean_neighbors = NULL;
@@ -100,85 +111,197 @@ namespace LxGeo
 				islands = NULL;
 			}
 
+			/**
+			Links geometries within threshold distance. Each thread collects the (i, j, w) edges (i < j) of a range of geometries,
+			edges are then gathered in geometries order into weights_csr.
+			*/
 			void fill_distance_band_graph(WeightsDistanceBandParams& wdbp) {
 
 				_reset();
-				double& threshold_value = wdbp.threshold;
-				std::function<double(double)>& distance_kernel = wdbp.distance_kernel;
+				const double threshold_value = wdbp.threshold;
+				const std::function<double(double)>& distance_kernel = wdbp.distance_kernel;
 
-				for (size_t c_geom_idx = 0; c_geom_idx < length(); ++c_geom_idx) {
-
-					geom_type& c_geom = this->operator[](c_geom_idx);
+				std::vector<WeightedEdge> edges = collect_ranges_edges(wdbp.n_threads, [&](size_t c_geom_idx, std::vector<WeightedEdge>& c_edges, std::vector<Boost_Value>& candidates) {
+					const geom_type& c_geom = geometries_container[c_geom_idx].get_definition();
 					Boost_Box_2 c_geom_envelop;
 					boost::geometry::envelope(c_geom, c_geom_envelop);
 					Boost_Box_2 c_geom_envelop_buffered = box_buffer(c_geom_envelop, threshold_value);
 
 					// filtter polygons within buffered envelop
-					std::list<Boost_Value> candidates;
+					candidates.clear();
 					rtree.query(bgi::intersects(c_geom_envelop_buffered), std::back_inserter(candidates));
-					// search for polygons meeting threshomd critirea
+					// search for polygons meeting threshomd critirea (each pair is visited from its lowest index)
 					for (auto& c_candidate : candidates) {
 						size_t c_candidate_idx = c_candidate.second;
-						geom_type& c_candidate_geom = this->operator[](c_candidate_idx);
+						if (c_candidate_idx <= c_geom_idx)
+							continue;
+						const geom_type& c_candidate_geom = geometries_container[c_candidate_idx].get_definition();
 						double inter_distance = boost::geometry::distance(c_geom, c_candidate_geom);
 						if (inter_distance > threshold_value)
 							continue;
-						else {
-							// adding edge
-							double edge_weight = !wdbp.binary ? distance_kernel(inter_distance) : 1;
-							if (!boost::edge(c_candidate_idx, c_geom_idx, weights_graph).second)
-								boost::add_edge(c_geom_idx, c_candidate_idx, EdgeWeightProperty{ edge_weight }, weights_graph);
-						}
+						double edge_weight = !wdbp.binary ? distance_kernel(inter_distance) : 1;
+						c_edges.push_back({ c_geom_idx, c_candidate_idx, edge_weight });
 					}
+					});
+				set_edges(edges);
+			}
 
-				}
+			/**
+			Links each geometry to its K nearest geometries (binary weights). The graph is symmetrized: i and j are neighbors if
+			either is among the K nearest of the other, degrees may then exceed K.
+			The K + 1 nearest envelopes give an upper bound of the K-th exact distance, every geometry whose envelope lies within
+			that bound is then refined by exact distance. Ties are broken by lowest index.
+			*/
+			void fill_knn_graph(WeightsKNNParams& wknnp) {
+
+				_reset();
+				const size_t K = std::min(wknnp.K, length() > 0 ? length() - 1 : 0);
+				if (K == 0)
+					return;
+
+				std::vector<WeightedEdge> edges = collect_ranges_edges(wknnp.n_threads, [&](size_t c_geom_idx, std::vector<WeightedEdge>& c_edges, std::vector<Boost_Value>& candidates) {
+					const geom_type& c_geom = geometries_container[c_geom_idx].get_definition();
+					Boost_Box_2 c_geom_envelop;
+					boost::geometry::envelope(c_geom, c_geom_envelop);
+
+					std::vector<std::pair<double, size_t>> c_neighbors;
+					auto exact_neighbors = [&]() {
+						c_neighbors.clear();
+						for (auto& c_candidate : candidates)
+							if (c_candidate.second != c_geom_idx)
+								c_neighbors.emplace_back(boost::geometry::distance(c_geom, geometries_container[c_candidate.second].get_definition()), c_candidate.second);
+						std::nth_element(c_neighbors.begin(), c_neighbors.begin() + (K - 1), c_neighbors.end());
+					};
+
+					// envelopes distances are lower bounds of the exact distances
+					candidates.clear();
+					rtree.query(bgi::nearest(c_geom_envelop, K + 1), std::back_inserter(candidates));
+					exact_neighbors();
+					double kth_distance = c_neighbors[K - 1].first;
+
+					candidates.clear();
+					rtree.query(bgi::intersects(box_buffer(c_geom_envelop, kth_distance)), std::back_inserter(candidates));
+					exact_neighbors();
+					for (size_t neighbor_idx = 0; neighbor_idx < K; neighbor_idx++) {
+						size_t c_neighbor_idx = c_neighbors[neighbor_idx].second;
+						c_edges.push_back({ std::min(c_geom_idx, c_neighbor_idx), std::max(c_geom_idx, c_neighbor_idx), 1 });
+					}
+					});
+				set_edges(unique_edges(edges));
+			}
+
+			// Links polygons sharing at least one vertex (binary weights)
+			void fill_queen_graph(WeightsContiguityParams& wcp) {
+				fill_contiguity_graph(wcp, false);
 			}
 
+			// Links polygons sharing at least one edge (binary weights)
+			void fill_rook_graph(WeightsContiguityParams& wcp) {
+				fill_contiguity_graph(wcp, true);
+			}
+
+			// Rebuilds weights_csr without the edges whose weight satisfies diconnection_lambda
 			void disconnect_edges(const std::function< bool(double)>& diconnection_lambda) {
-				auto edge_weight_map = boost::get(boost::edge_weight, weights_graph);
-				
-				edge_iterator vi, vi_end, next;
-				boost::tie(vi, vi_end) = boost::edges(weights_graph);
-				for (next = vi; vi != vi_end; vi = next) {
-					++next;
-					if (diconnection_lambda(edge_weight_map[*vi]))
-					{
-						boost::remove_edge(*vi, weights_graph);
-					}
-				}
+				std::vector<WeightedEdge> edges = csr_edges();
+				std::erase_if(edges, [&diconnection_lambda](const WeightedEdge& c_edge) { return diconnection_lambda(c_edge.weight); });
+				set_edges(edges);
 			};
 
-			void run_labeling(){
+			// Replaces weights_csr by its row standardized copy (w_{i,j} / sum_j w_{i,j}), the matrix is no longer symmetric: call last
+			void standardize_rows() {
+				weights_csr = row_standardized(weights_csr);
+			}
+
+			/**
+			Spatial lag of columns_count attributes at once: values is a row major matrix (one row of columns_count values per geometry).
+			Returns the row major matrix W.X
+			*/
+			std::vector<double> spatial_lag(const std::vector<double>& values, size_t columns_count = 1, size_t n_threads = 0) const {
+				std::vector<double> out_lag(values.size());
+				GeometryFactoryShared::spatial_lag(weights_csr, values, columns_count, out_lag, n_threads);
+				return out_lag;
+			}
+
+			// Spatial lag of the geometries double attributes (one column per attribute name)
+			std::vector<double> spatial_lag(const std::vector<std::string>& double_attributes_names, size_t n_threads = 0) const {
+				size_t columns_count = double_attributes_names.size();
+				std::vector<double> values(length() * columns_count);
+				for (size_t c_geom_idx = 0; c_geom_idx < length(); c_geom_idx++)
+					for (size_t column = 0; column < columns_count; column++)
+						values[c_geom_idx * columns_count + column] = geometries_container[c_geom_idx].get_double_attribute(double_attributes_names[column]);
+				return spatial_lag(values, columns_count, n_threads);
+			}
+
+			void run_labeling(size_t n_threads = 0){
 				//connected component
-				component_labels = std::vector<size_t>(boost::num_vertices(weights_graph));
-				n_components = boost::connected_components(weights_graph, &component_labels[0]);
+				n_components = connected_components(weights_csr, component_labels, n_threads);
+
+				// component index: members grouped by component (counting sort, ascending geometries indices)
+				component_offsets.assign(n_components + 1, 0);
+				for (size_t c_label : component_labels)
+					component_offsets[c_label + 1]++;
+				for (size_t c_label = 0; c_label < n_components; c_label++)
+					component_offsets[c_label + 1] += component_offsets[c_label];
+				component_members.resize(component_labels.size());
+				std::vector<size_t> next_position(component_offsets.begin(), component_offsets.end() - 1);
+				for (size_t c_geom_idx = 0; c_geom_idx < component_labels.size(); c_geom_idx++)
+					component_members[next_position[component_labels[c_geom_idx]]++] = c_geom_idx;
 
 				size_t sum_degrees = 0;
-				vertex_iterator v, vend;
-				for (boost::tie(v, vend) = boost::vertices(weights_graph); v != vend; ++v) {
-					size_t c_v_degrees = boost::degree(*v, weights_graph);
+				max_neighbors = 0;
+				min_neighbors = length() > 0 ? std::numeric_limits<size_t>::max() : 0;
+				islands = 0;
+				for (size_t c_geom_idx = 0; c_geom_idx < weights_csr.rows_count(); c_geom_idx++) {
+					size_t c_v_degrees = weights_csr.degree(c_geom_idx);
 					sum_degrees += c_v_degrees;
 					if (c_v_degrees > max_neighbors) max_neighbors = c_v_degrees;
 					if (c_v_degrees < min_neighbors) min_neighbors = c_v_degrees;
 					if (c_v_degrees == 0) islands+=1;
 				}
-				mean_neighbors = double(sum_degrees) / boost::num_vertices(weights_graph);
+				mean_neighbors = length() > 0 ? double(sum_degrees) / length() : 0;
+			}
+
+			// Geometries indices of a component (ascending), available after run_labeling
+			std::span<const size_t> component(size_t label) const {
+				return { component_members.data() + component_offsets[label], component_offsets[label + 1] - component_offsets[label] };
+			}
+
+			/**
+			Calls component_fn(label, members) for each component found by run_labeling. Components share no edge, they are
+			processed concurrently by n_threads threads (0: hardware concurrency) pulling the next component from a shared counter.
+			component_fn must only write state owned by the component members.
+			*/
+			template <typename component_fn_type>
+				requires std::invocable<component_fn_type&, size_t, std::span<const size_t>>
+			void for_each_component(component_fn_type&& component_fn, size_t n_threads = 0) const {
+				std::atomic<size_t> next_label = 0;
+				size_t n_workers = n_threads == 0 ? default_threads_count() : n_threads;
+				parallel_for_chunks(std::min(n_workers, n_components), n_workers, [&](size_t, size_t) {
+					for (size_t c_label = next_label++; c_label < n_components; c_label = next_label++)
+						component_fn(c_label, component(c_label));
+					});
+			}
+
+			// Copy of the weights as a boost graph (for boost graph algorithms)
+			WeightsGraph to_boost_graph() const {
+				WeightsGraph out_graph(length());
+				for (const WeightedEdge& c_edge : csr_edges())
+					boost::add_edge(c_edge.source, c_edge.target, EdgeWeightProperty{ c_edge.weight }, out_graph);
+				return out_graph;
 			}
 
 			std::vector<LineString_with_attributes> export_edge_graph_as_LSwithAttr() {
 				std::vector<LineString_with_attributes> edges_linestrings;
 				edges_linestrings.reserve(length());
-				auto es = boost::edges(weights_graph);
-				for (auto eit = es.first; eit != es.second; ++eit) {
-					vertex_descriptor source_ = boost::source(*eit, weights_graph) , target_ = boost::target(*eit, weights_graph);
+				for (const WeightedEdge& c_edge : csr_edges()) {
+					size_t source_ = c_edge.source, target_ = c_edge.target;
 					Boost_Point_2 source_rep_pt,target_rep_pt;
 					boost::geometry::centroid(this->operator[](source_), source_rep_pt);
 					boost::geometry::centroid(this->operator[](target_), target_rep_pt);
 
 					LineString_with_attributes c_edge_container(Boost_LineString_2({source_rep_pt, target_rep_pt}));
-					double edge_weight = boost::get(boost::edge_weight_t(), weights_graph, *eit);
 					size_t c_label = component_labels[source_];
-					c_edge_container.set_double_attribute("weight", edge_weight);
+					c_edge_container.set_double_attribute("weight", c_edge.weight);
 					c_edge_container.set_int_attribute("component", static_cast<int>(c_label));
 					edges_linestrings.push_back(c_edge_container);
 				}
@@ -191,15 +314,168 @@ namespace LxGeo
 			}
 
 		private:
+			/**
+			Calls geometry_edges_fn(geom_idx, range_edges, candidates_buffer) for every geometry: each thread handles a range of
+			geometries with its own edges buffer, buffers are then gathered in ranges order (edges order does not depend on threads).
+			*/
+			template <typename geometry_edges_fn_type>
+			std::vector<WeightedEdge> collect_ranges_edges(size_t n_threads, geometry_edges_fn_type&& geometry_edges_fn) const {
+				size_t n_ranges = std::min(n_threads == 0 ? default_threads_count() : n_threads, std::max<size_t>(length(), 1));
+				size_t range_size = (length() + n_ranges - 1) / n_ranges;
+				std::vector<std::vector<WeightedEdge>> ranges_edges(n_ranges);
+				parallel_for_chunks(n_ranges, n_ranges, [&](size_t ranges_begin, size_t ranges_end) {
+					std::vector<Boost_Value> candidates;
+					for (size_t range_idx = ranges_begin; range_idx < ranges_end; range_idx++) {
+						size_t geom_end = std::min(length(), (range_idx + 1) * range_size);
+						for (size_t c_geom_idx = range_idx * range_size; c_geom_idx < geom_end; ++c_geom_idx)
+							geometry_edges_fn(c_geom_idx, ranges_edges[range_idx], candidates);
+					}
+					});
+				return merge_edges(ranges_edges);
+			}
+
+			static std::vector<WeightedEdge> merge_edges(std::vector<std::vector<WeightedEdge>>& edges_buffers) {
+				std::vector<WeightedEdge> edges;
+				size_t edges_count = 0;
+				for (const auto& c_edges : edges_buffers) edges_count += c_edges.size();
+				edges.reserve(edges_count);
+				for (auto& c_edges : edges_buffers) {
+					edges.insert(edges.end(), c_edges.begin(), c_edges.end());
+					std::vector<WeightedEdge>().swap(c_edges);
+				}
+				return edges;
+			}
+
+			// Sorts edges (source < target) and removes duplicated pairs
+			static std::vector<WeightedEdge> unique_edges(std::vector<WeightedEdge> edges) {
+				auto pair_less = [](const WeightedEdge& a, const WeightedEdge& b) { return std::tie(a.source, a.target) < std::tie(b.source, b.target); };
+				auto pair_equal = [](const WeightedEdge& a, const WeightedEdge& b) { return a.source == b.source && a.target == b.target; };
+				std::sort(edges.begin(), edges.end(), pair_less);
+				edges.erase(std::unique(edges.begin(), edges.end(), pair_equal), edges.end());
+				return edges;
+			}
+
+			// Snapped vertex (x, y, 0, 0) or edge (ordered end points) of a geometry
+			struct ContiguityKey {
+				std::array<int64_t, 4> coords;
+				size_t geom_idx;
+				bool operator<(const ContiguityKey& other) const { return std::tie(coords, geom_idx) < std::tie(other.coords, other.geom_idx); }
+				bool operator==(const ContiguityKey& other) const = default;
+			};
+
+			/**
+			Contiguity graph from a hash partitioned index of snapped vertices (queen) or edges (rook): each thread emits the keys of a
+			range of polygons into hash buckets, each bucket is then sorted and scanned in parallel and every run of equal keys links its
+			polygons. No pairwise geometry test is made.
+			*/
+			void fill_contiguity_graph(const WeightsContiguityParams& wcp, bool shared_edges) {
+				if constexpr (!std::is_same_v<geom_type, Boost_Polygon_2>)
+					throw std::runtime_error("Contiguity weights are only defined for polygons!");
+				else {
+					_reset();
+					if (wcp.snap_tolerance <= 0)
+						throw std::runtime_error("Contiguity snap tolerance must be positive!");
+					const double snap_scale = 1.0 / wcp.snap_tolerance;
+					size_t n_ranges = std::min(wcp.n_threads == 0 ? default_threads_count() : wcp.n_threads, std::max<size_t>(length(), 1));
+					size_t range_size = (length() + n_ranges - 1) / n_ranges;
+					size_t n_buckets = 4 * n_ranges;
+
+					auto key_bucket = [n_buckets](const std::array<int64_t, 4>& coords) {
+						uint64_t hash = 0;
+						for (int64_t c_coord : coords) {
+							hash = (hash ^ uint64_t(c_coord)) * 0x9E3779B97F4A7C15ull;
+							hash ^= hash >> 29;
+						}
+						return size_t(hash % n_buckets);
+					};
+
+					// ranges_buckets[range][bucket]
+					std::vector<std::vector<std::vector<ContiguityKey>>> ranges_buckets(n_ranges, std::vector<std::vector<ContiguityKey>>(n_buckets));
+					parallel_for_chunks(n_ranges, n_ranges, [&](size_t ranges_begin, size_t ranges_end) {
+						for (size_t range_idx = ranges_begin; range_idx < ranges_end; range_idx++) {
+							auto& c_buckets = ranges_buckets[range_idx];
+							auto add_ring_keys = [&](const Boost_Ring_2& c_ring, size_t c_geom_idx) {
+								// rings are closed: the last point repeats the first one
+								for (size_t point_idx = 0; point_idx + 1 < c_ring.size(); point_idx++) {
+									std::array<int64_t, 2> c_start = { std::llround(bg::get<0>(c_ring[point_idx]) * snap_scale), std::llround(bg::get<1>(c_ring[point_idx]) * snap_scale) };
+									std::array<int64_t, 4> c_coords;
+									if (!shared_edges)
+										c_coords = { c_start[0], c_start[1], 0, 0 };
+									else {
+										std::array<int64_t, 2> c_end = { std::llround(bg::get<0>(c_ring[point_idx + 1]) * snap_scale), std::llround(bg::get<1>(c_ring[point_idx + 1]) * snap_scale) };
+										if (c_start == c_end)
+											continue;
+										if (c_end < c_start)
+											std::swap(c_start, c_end);
+										c_coords = { c_start[0], c_start[1], c_end[0], c_end[1] };
+									}
+									c_buckets[key_bucket(c_coords)].push_back({ c_coords, c_geom_idx });
+								}
+							};
+							size_t geom_end = std::min(length(), (range_idx + 1) * range_size);
+							for (size_t c_geom_idx = range_idx * range_size; c_geom_idx < geom_end; ++c_geom_idx) {
+								const Boost_Polygon_2& c_polygon = geometries_container[c_geom_idx].get_definition();
+								add_ring_keys(c_polygon.outer(), c_geom_idx);
+								for (const auto& c_inner : c_polygon.inners())
+									add_ring_keys(c_inner, c_geom_idx);
+							}
+						}
+						});
+
+					std::vector<std::vector<WeightedEdge>> buckets_edges(n_buckets);
+					parallel_for_chunks(n_buckets, n_ranges, [&](size_t buckets_begin, size_t buckets_end) {
+						std::vector<ContiguityKey> c_keys;
+						for (size_t bucket_idx = buckets_begin; bucket_idx < buckets_end; bucket_idx++) {
+							c_keys.clear();
+							for (auto& c_buckets : ranges_buckets) {
+								c_keys.insert(c_keys.end(), c_buckets[bucket_idx].begin(), c_buckets[bucket_idx].end());
+								std::vector<ContiguityKey>().swap(c_buckets[bucket_idx]);
+							}
+							std::sort(c_keys.begin(), c_keys.end());
+							c_keys.erase(std::unique(c_keys.begin(), c_keys.end()), c_keys.end());
+							// runs of equal coords are sorted by polygon index
+							for (size_t run_begin = 0, run_end; run_begin < c_keys.size(); run_begin = run_end) {
+								for (run_end = run_begin + 1; run_end < c_keys.size() && c_keys[run_end].coords == c_keys[run_begin].coords; run_end++);
+								for (size_t first = run_begin; first < run_end; first++)
+									for (size_t second = first + 1; second < run_end; second++)
+										buckets_edges[bucket_idx].push_back({ c_keys[first].geom_idx, c_keys[second].geom_idx, 1 });
+							}
+						}
+						});
+					set_edges(unique_edges(merge_edges(buckets_edges)));
+				}
+			}
+
+			// Sets the unique edges of the graph
+			void set_edges(const std::vector<WeightedEdge>& edges) {
+				weights_csr = weights_csr_from_edges(length(), edges);
+			}
+
+			// Upper triangle entries of weights_csr (source < target)
+			std::vector<WeightedEdge> csr_edges() const {
+				std::vector<WeightedEdge> edges;
+				edges.reserve(weights_csr.non_zeros_count() / 2);
+				for (size_t row = 0; row < weights_csr.rows_count(); row++) {
+					auto c_neighbors = weights_csr.neighbors(row);
+					auto c_weights = weights_csr.row_weights(row);
+					for (size_t position = 0; position < c_neighbors.size(); position++)
+						if (c_neighbors[position] > row)
+							edges.push_back({ row, c_neighbors[position], c_weights[position] });
+				}
+				return edges;
+			}
+
 			size_t length() const override { return geometries_container.size(); }
 			geom_type& operator[](int offset) override { return geometries_container[offset].get_definition(); }
 			const geom_type& operator[](int offset) const override { return geometries_container[offset].get_definition(); }
 			
 		public:			
 			std::vector<Geometries_with_attributes<geom_type>> geometries_container;
-			WeightsGraph weights_graph;
+			WeightsCSR weights_csr; // built by fill_* and replaced as a whole (disconnect_edges, standardize_rows)
 			std::vector<size_t> component_labels;
 			size_t n_components=0;
+			std::vector<size_t> component_offsets = { 0 }; // n_components + 1 offsets in component_members
+			std::vector<size_t> component_members; // geometries indices grouped by component
 		private:
 			size_t max_neighbors=0;
 			size_t min_neighbors=0;
@@ -0,0 +1,61 @@
+#pragma once
+#include "defs.h"
+#include <span>
+
+namespace LxGeo
+{
+	namespace GeometryFactoryShared
+	{
+
+		// Undirected weighted edge (source < target for spatial weights edges)
+		struct WeightedEdge {
+			size_t source;
+			size_t target;
+			double weight;
+		};
+
+		/**
+		Compressed sparse row storage of a weights matrix: the neighbors of row i are
+		columns[row_offsets[i] : row_offsets[i + 1]] (sorted) with the matching weights.
+		Matrices built from edges are symmetric (until rows are standardized).
+		*/
+		struct WeightsCSR {
+			std::vector<size_t> row_offsets = { 0 };
+			std::vector<size_t> columns;
+			std::vector<double> weights;
+
+			size_t rows_count() const { return row_offsets.size() - 1; }
+
+			size_t non_zeros_count() const { return columns.size(); }
+
+			size_t degree(size_t row) const { return row_offsets[row + 1] - row_offsets[row]; }
+
+			std::span<const size_t> neighbors(size_t row) const {
+				return { columns.data() + row_offsets[row], degree(row) };
+			}
+
+			std::span<const double> row_weights(size_t row) const {
+				return { weights.data() + row_offsets[row], degree(row) };
+			}
+		};
+
+		// Builds the symmetric matrix of n_rows rows holding each undirected edge in both rows (edges must be unique)
+		LX_GEO_FACTORY_SHARED_API WeightsCSR weights_csr_from_edges(size_t n_rows, const std::vector<WeightedEdge>& edges);
+
+		// Copy of weights where each row sums to 1 (rows without neighbors or with a null sum are kept)
+		LX_GEO_FACTORY_SHARED_API WeightsCSR row_standardized(const WeightsCSR& weights);
+
+		/**
+		Spatial lag W.X of columns_count attributes at once: values and out_lag are row major matrices of
+		rows_count() x columns_count (one row per geometry). Rows are computed by n_threads threads (0: hardware concurrency).
+		*/
+		LX_GEO_FACTORY_SHARED_API void spatial_lag(const WeightsCSR& weights, std::span<const double> values, size_t columns_count, std::span<double> out_lag, size_t n_threads = 0);
+
+		/**
+		Labels connected components of a symmetric matrix (concurrent union find over rows ranges).
+		Labels are numbered by first vertex, as boost::connected_components. Returns the components count.
+		*/
+		LX_GEO_FACTORY_SHARED_API size_t connected_components(const WeightsCSR& weights, std::vector<size_t>& labels, size_t n_threads = 0);
+
+	}
+}
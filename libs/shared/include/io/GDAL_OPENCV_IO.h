@@ -15,6 +15,9 @@ public:
 	IO_DATA_API cv::Mat ImgReadByGDAL(cv::String, bool = true);
 	IO_DATA_API cv::Mat PaddedImgReadByGDAL(cv::String filename, int xStart, int yStart, int xWidth, int yWidth);
 	IO_DATA_API cv::Mat ImgReadByGDAL(cv::String, int, int, int, int, bool = true);
+	IO_DATA_API cv::Mat ImgReadByGDAL(GDALDataset*, bool = true);
+	IO_DATA_API cv::Mat PaddedImgReadByGDAL(GDALDataset*, int xStart, int yStart, int xWidth, int yWidth);
+	IO_DATA_API cv::Mat ImgReadByGDAL(GDALDataset*, int, int, int, int, bool = true);
 	IO_DATA_API cv::Mat ImgReadByGDAL(GDALRasterBand*, int, int, int, int);
 	IO_DATA_API cv::Mat ImgReadByGDAL(GDALRasterBand*);
 	IO_DATA_API int gdal2opencv(const GDALDataType&, const int& channels);
@@ -25,6 +28,7 @@ private:
 	cv::String m_filename;
 	GDALDriver* m_driver;
 	bool hasColorTable;
+	bool m_ownsDataset;
 
 	int m_width;
 	int m_height;
@@ -33,7 +37,16 @@ private:
 	int m_nBand;
 
 	bool readHeader();
+	bool readHeader(GDALDataset*, bool);
+	cv::Mat readDatasetWindow(int, int, int, int, bool);
+	cv::Mat readPaddedDatasetWindow(int, int, int, int);
+	cv::Mat readDataset(bool);
 	bool readData(cv::Mat img);
+	bool isDirectReadable(const GDALDataType&, const int&, const cv::Mat&);
+	bool isDirectReadable(GDALDataset*, const cv::Mat&);
+	bool readBandConverted(GDALRasterBand*, cv::Mat&, int, int, int);
+	bool readDirect(GDALDataset*, cv::Mat&, int, int);
+	bool readDirect(GDALRasterBand*, cv::Mat&, int, int);
 	int gdalPaletteInterpretation2OpenCV(GDALPaletteInterp const&, GDALDataType const&);
 	void write_ctable_pixel(const double&, const GDALDataType&, GDALColorTable const*, cv::Mat&, const int&, const int&, const int&);
 	void write_pixel(const double&, const GDALDataType&, const int&, cv::Mat&, const int&, const int&, const int&);
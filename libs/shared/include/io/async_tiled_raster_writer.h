@@ -0,0 +1,119 @@
+#pragma once
+#include "defs.h"
+#include <gdal_priv.h>
+#include <opencv2/core/core.hpp>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include "design_pattern/bounded_queue.h"
+#include "export_io_data.h"
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+
+		enum class OverlapPolicy {
+			last_wins, // the latest submitted patch overrides previous ones
+			average, // mean of the overlapping patches
+			max // per pixel maximum of the overlapping patches
+		};
+
+		struct AsyncWriteOptions {
+			size_t queue_capacity = 16; // patches waiting for the writer thread (submit blocks when full)
+			size_t cache_size_mb = 256; // in memory tiles budget before the least recently used tile is written
+			OverlapPolicy overlap_policy = OverlapPolicy::last_wins;
+			std::string spill_directory; // sidecar of written tiles counts and sums (system temporary directory when empty)
+		};
+
+		/**
+		* Writes image patches into a GDAL dataset from a dedicated thread.
+		* Patches are composited into tiles aligned on the dataset blocks and kept in memory. Each tile is written with a
+		* single RasterIO call when evicted from the cache or on flush. A tile touching an already written area is read back
+		* first, thus overlapping patches are merged following the overlap policy whatever the eviction order.
+		* With average and max policies, the per pixel patch counts (8 bits) and sums (CV_64F, average policy) of written tiles are
+		* spilled to a sidecar file, removed on close, and read back with the tile: means are always computed from the exact sums.
+		* The dataset must not be used by other threads until close.
+		*/
+		class AsyncTiledRasterWriter {
+
+			struct write_request {
+				int col_start = 0, row_start = 0;
+				cv::Mat image;
+				std::shared_ptr<std::promise<void>> flushed; // set for flush requests
+			};
+
+			struct tile {
+				cv::Mat values; // dataset content (dataset type)
+				cv::Mat sums; // CV_64F sums of the patches (average policy)
+				cv::Mat counts; // CV_8U number of patches per pixel (average and max policies)
+				std::list<std::pair<int, int>>::iterator lru_it;
+			};
+
+			typedef std::pair<int, int> tile_key; // (tile column, tile row)
+
+		public:
+			IO_DATA_API AsyncTiledRasterWriter(std::shared_ptr<GDALDataset> dataset, const AsyncWriteOptions& options = AsyncWriteOptions());
+			IO_DATA_API ~AsyncTiledRasterWriter();
+
+			AsyncTiledRasterWriter(const AsyncTiledRasterWriter&) = delete;
+			AsyncTiledRasterWriter& operator=(const AsyncTiledRasterWriter&) = delete;
+
+			/**
+			* Queues a patch whose top left pixel is (col_start, row_start) in the dataset. Pixels outside the dataset are cropped
+			* and extra channels are ignored. The patch is copied, thus the caller may reuse image.
+			* Blocks while the queue is full and rethrows a previous writer thread error.
+			*/
+			IO_DATA_API void submit(int col_start, int row_start, const cv::Mat& image);
+
+			/**
+			* Waits until all submitted patches are written to the dataset.
+			*/
+			IO_DATA_API void flush();
+
+			/**
+			* Flushes and stops the writer thread. Further submissions throw.
+			*/
+			IO_DATA_API void close();
+
+		private:
+			void writer_loop();
+			void composite(const write_request& request);
+			tile& get_tile(const tile_key& key);
+			void write_tile(const tile_key& key, tile& c_tile);
+			void write_all_tiles();
+			void spill_tile_state(const tile_key& key, const tile& c_tile);
+			void load_tile_state(const tile_key& key, tile& c_tile);
+			std::streamoff tile_slot_offset(const tile_key& key) const;
+			cv::Rect tile_rect(const tile_key& key) const;
+			size_t tile_bytes(const tile& c_tile) const;
+			void rethrow_writer_error();
+
+		private:
+			std::shared_ptr<GDALDataset> dataset;
+			AsyncWriteOptions options;
+			int width, height, band_count;
+			int tile_width, tile_height;
+			int value_type; // cv type matching the dataset data type and bands count
+			GDALDataType buffer_type;
+
+			GeometryFactoryShared::BoundedQueue<write_request> requests;
+			std::thread writer_thread;
+			std::atomic<bool> closed;
+
+			std::mutex error_mtx;
+			std::exception_ptr writer_error;
+
+			// writer thread state
+			std::map<tile_key, tile> tiles;
+			std::list<tile_key> tiles_lru; // front is the most recently used tile
+			size_t cached_bytes;
+			// one fixed size slot per tile (counts then sums) in the sidecar file, slots of written tiles only are filled
+			std::string spill_path;
+			std::fstream spill_file;
+			std::set<tile_key> spilled_tiles;
+		};
+
+	}
+}
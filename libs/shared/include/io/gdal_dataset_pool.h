@@ -0,0 +1,90 @@
+#pragma once
+#include "defs.h"
+#include <gdal_priv.h>
+#include <mutex>
+#include "export_io_data.h"
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+
+		struct GDALDatasetPoolStats {
+			size_t hits = 0; // acquisitions served by an idle pooled handle
+			size_t misses = 0; // acquisitions that required a GDALOpen
+			size_t evictions = 0; // idle handles closed to respect the open handles cap
+			size_t open_handles = 0; // handles currently opened (idle + acquired)
+			size_t idle_handles = 0; // handles waiting in the pool
+			double open_time = 0.0; // cumulative time (seconds) spent in GDALOpen
+		};
+
+		/**
+		* Process-wide pool of opened GDAL datasets keyed by file path and access mode.
+		* A GDALDataset is not safe for concurrent use, thus an acquired handle is exclusive to its holder
+		* and goes back to the pool (instead of being closed) when its last shared_ptr copy is released.
+		* Idle handles are evicted in least recently used order once the open handles cap is reached.
+		*/
+		class GDALDatasetPool {
+
+			typedef std::pair<std::string, GDALAccess> pool_key;
+
+			struct idle_entry {
+				pool_key key;
+				GDALDataset* dataset;
+			};
+
+			typedef std::list<idle_entry> lru_list;
+
+			struct pool_state {
+				mutable std::mutex mtx;
+				size_t max_open_handles;
+				lru_list idle_lru; // front is the most recently released handle
+				std::map<pool_key, std::vector<lru_list::iterator>> idle_index;
+				std::map<std::string, size_t> eviction_generations; // bumped by evict, handles acquired under an older generation are closed when released
+				GDALDatasetPoolStats stats;
+			};
+
+		public:
+			IO_DATA_API static GDALDatasetPool& instance();
+
+			/**
+			* Returns an exclusive handle on the dataset at file_path opened with the requested access mode.
+			* Throws a runtime_error when the dataset cannot be opened.
+			*/
+			IO_DATA_API std::shared_ptr<GDALDataset> acquire(const std::string& file_path, GDALAccess access = GA_ReadOnly);
+
+			IO_DATA_API void set_max_open_handles(size_t max_open_handles);
+			IO_DATA_API size_t get_max_open_handles() const;
+
+			/**
+			* Closes idle handles of file_path (required before overwriting or deleting the file).
+			* Handles currently acquired are closed when released instead of going back to the pool.
+			*/
+			IO_DATA_API void evict(const std::string& file_path);
+
+			/**
+			* Closes all idle handles.
+			*/
+			IO_DATA_API void clear();
+
+			IO_DATA_API GDALDatasetPoolStats stats() const;
+			IO_DATA_API void reset_stats();
+
+			GDALDatasetPool(const GDALDatasetPool&) = delete;
+			GDALDatasetPool& operator=(const GDALDatasetPool&) = delete;
+			~GDALDatasetPool();
+
+		private:
+			GDALDatasetPool(size_t max_open_handles = 64);
+
+			static void release(const std::weak_ptr<pool_state>& weak_state, const pool_key& key, size_t generation, GDALDataset* dataset);
+			static size_t eviction_generation(const pool_state& state, const std::string& file_path);
+			static void remove_idle(pool_state& state, lru_list::iterator lru_it);
+
+		private:
+			std::shared_ptr<pool_state> state;
+		};
+
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "defs.h"
+#include "export_io_data.h"
+#include <fstream>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+
+		/**
+		* Binary cache files of GeoVectors (see GeoVectorCache and GeoVector::to_cache).
+		* Sections are 8 bytes aligned arrays referenced by offsets from the start of the file, in native byte order:
+		* geometries first ring offsets, rings first point offsets, points (x, y), geometries envelopes (rtree packing input),
+		* attribute fields descriptors with their names, values, validity bitmaps and strings dictionaries.
+		*/
+		namespace geovector_cache
+		{
+			inline constexpr char MAGIC[8] = { 'L', 'X', 'G', 'V', 'C', 'A', 'C', 'H' };
+			inline constexpr uint32_t VERSION = 1;
+			inline constexpr const char* FILE_EXTENSION = ".lxgvc";
+
+			enum class GeometryKind : uint32_t { point = 1, linestring = 2, polygon = 3 };
+
+			template <typename geom_type>
+			constexpr GeometryKind geometry_kind() {
+				if constexpr (std::is_same_v<geom_type, Boost_Point_2>) return GeometryKind::point;
+				else if constexpr (std::is_same_v<geom_type, Boost_LineString_2>) return GeometryKind::linestring;
+				else return GeometryKind::polygon;
+			}
+
+			// Identifies the source files state and the loading parameters a cache was built from
+			struct SourceKey {
+				uint64_t mtime = 0; // latest modification time of the source files
+				uint64_t size = 0; // total size of the source files
+				uint64_t content_hash = 0;
+				uint64_t load_hash = 0; // layer, spatial filter and fields lists
+				bool operator==(const SourceKey& other) const = default;
+			};
+
+			struct FileHeader {
+				char magic[8];
+				uint32_t version;
+				uint32_t geometry_kind;
+				SourceKey source_key;
+				uint64_t geometries_count;
+				uint64_t rings_count;
+				uint64_t points_count;
+				uint64_t crs_offset, crs_size;
+				uint64_t geometry_rings_offset; // geometries_count + 1 uint64
+				uint64_t ring_points_offset; // rings_count + 1 uint64
+				uint64_t points_offset; // points_count * 2 doubles
+				uint64_t envelopes_offset; // geometries_count * 4 doubles (min x, min y, max x, max y)
+				uint64_t fields_count;
+				uint64_t fields_offset; // fields_count FieldHeader
+			};
+
+			struct FieldHeader {
+				uint32_t type; // AttributeType
+				uint32_t name_size;
+				uint64_t name_offset;
+				uint64_t values_offset; // geometries_count int64, double or uint32 dictionary codes
+				uint64_t validity_offset; // (geometries_count + 63) / 64 uint64
+				uint64_t dictionary_count;
+				uint64_t dictionary_offsets_offset; // dictionary_count + 1 uint64 in dictionary bytes
+				uint64_t dictionary_bytes_offset;
+			};
+
+			IO_DATA_API uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0);
+
+			inline constexpr size_t SOURCE_SAMPLE_BYTES = 64 * 1024;
+
+			/**
+			* Files of the vector dataset at path, found without opening it: path itself and its existing companions
+			* (shapefile components, SQLite journals). Empty when path is not a regular file (databases, services, virtual paths).
+			*/
+			IO_DATA_API std::vector<std::string> source_files(const std::string& path);
+
+			/**
+			* Modification time and size of the files with a hash of their paths and of their first and last SOURCE_SAMPLE_BYTES bytes
+			* (of their whole content when full_content is set).
+			*/
+			IO_DATA_API SourceKey source_files_key(const std::vector<std::string>& files_paths, bool full_content = false);
+
+			// Read only memory mapping of a whole file
+			class IO_DATA_API MappedFile {
+			public:
+				MappedFile(const std::string& file_path);
+				const unsigned char* data() const { return static_cast<const unsigned char*>(region.get_address()); }
+				size_t size() const { return region.get_size(); }
+			private:
+				boost::interprocess::file_mapping mapping;
+				boost::interprocess::mapped_region region;
+			};
+
+			// Sequential writer of 8 bytes aligned sections, the header is written last at the start of the file
+			class IO_DATA_API FileWriter {
+			public:
+				FileWriter(const std::string& file_path);
+
+				// Writes a section and returns its offset
+				uint64_t write(const void* data, size_t size);
+
+				template <typename T>
+				uint64_t write_array(const std::vector<T>& values) {
+					return write(values.data(), values.size() * sizeof(T));
+				}
+
+				void write_header(const FileHeader& header);
+
+			private:
+				std::ofstream out_stream;
+				uint64_t position;
+			};
+
+		}
+	}
+}
@@ -4,6 +4,7 @@
 #include "defs_opencv.h"
 #include "export_io_data.h"
 #include "GDAL_OPENCV_IO.h"
+#include "gdal_dataset_pool.h"
 #include "coords.h"
 #include "lightweight/geoimage.h"
 
@@ -152,8 +153,11 @@ namespace LxGeo
 			}
 
 			IO_DATA_API void close() {
-				if (raster_dataset)
+				if (pooled_raster_dataset)
+					pooled_raster_dataset.reset();
+				else if (raster_dataset)
 					GDALClose((GDALDatasetH)raster_dataset);
+				raster_dataset = NULL;
 			}
 
 			IO_DATA_API ~RasterIO() {
@@ -270,7 +274,10 @@ namespace LxGeo
 				}
 				else {
 					// May be corrected due wrong values defintion below (check geoimage read padded)
-					non_padded_data = kgdal2cv.ImgReadByGDAL(raster_path, xStart + left_pad, yStart + top_pad, xSize - right_pad, ySize - down_pad);
+					if (raster_dataset)
+						non_padded_data = kgdal2cv.ImgReadByGDAL(raster_dataset, xStart + left_pad, yStart + top_pad, xSize - right_pad, ySize - down_pad);
+					else
+						non_padded_data = kgdal2cv.ImgReadByGDAL(raster_path, xStart + left_pad, yStart + top_pad, xSize - right_pad, ySize - down_pad);
 				}
 				matrix padded_data;
 				if (left_pad || right_pad || top_pad || down_pad)
@@ -309,6 +316,7 @@ namespace LxGeo
 			size_t raster_size;
 			size_t band_count;
 			GDALDataset* raster_dataset;
+			std::shared_ptr<GDALDataset> pooled_raster_dataset; // owner of raster_dataset when acquired from GDALDatasetPool
 			OGRSpatialReference* spatial_refrence;
 			double geotransform[6]; // xoff, a, b, yoff, d, e = geotransform
 			GDALDataType raster_data_type;
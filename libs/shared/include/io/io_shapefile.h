@@ -4,6 +4,7 @@
 #include "defs_ogr.h"
 #include "defs_common.h"
 #include "export_io_data.h"
+#include "gdal_dataset_pool.h"
 #include "geometries_with_attributes/geometries_with_attributes.h"
 #include "geometries_with_attributes/point_with_attribute.h"
 #include "geometries_with_attributes/linestring_with_attributes.h"
@@ -40,8 +41,8 @@ namespace LxGeo
 					}
 
 					// Step 1.
-					// Writes target file
-
+					// Writes target file (pooled handles on a previous file at the same path are stale)
+					GDALDatasetPool::instance().evict(out_path);
 					vector_dataset = driver->Create(out_path.c_str(), 0, 0, 0, GDT_Unknown, NULL);
 					if (vector_dataset == NULL) {
 						throw std::logic_error("Error : creation of output file failed.");
@@ -4,6 +4,7 @@
 #include "lightweight/raster_profile.h"
 #include "export_io_data.h"
 #include "GDAL_OPENCV_IO.h"
+#include "gdal_dataset_pool.h"
 #include "coords.h"
 #include "spatial_coord_transformer.h"
 
@@ -245,8 +246,12 @@ namespace LxGeo
 
 			template <typename envelope_type>
 			static GeoImage<cv_mat_type> from_file(const std::string& in_file, const envelope_type& spatial_envelope) {
+				return from_dataset(GDALDatasetPool::instance().acquire(in_file), spatial_envelope);
+			}
+
+			template <typename envelope_type>
+			static GeoImage<cv_mat_type> from_dataset(std::shared_ptr<GDALDataset> raster_dataset, const envelope_type& spatial_envelope) {
 				GeoImage<cv_mat_type> loaded_gimg;
-				GDALDataset* raster_dataset = (GDALDataset*)GDALOpen(in_file.c_str(), GA_ReadOnly);
 				if (raster_dataset->GetGeoTransform(loaded_gimg.geotransform) != CE_None) {
 					// temporary fix for the north facing rasters
 					loaded_gimg.geotransform[5] = -1.0;
@@ -255,7 +260,6 @@ namespace LxGeo
 				double nodata_value = raster_dataset->GetRasterBand(1)->GetNoDataValue(&raster_has_nodata);
 				std::optional<double> nodata; if (raster_has_nodata) nodata= nodata_value;
 				loaded_gimg.no_data = nodata;
-				GDALClose((GDALDatasetH)raster_dataset);
 				int col_start_pixel, col_end_pixel, row_start_pixel, row_end_pixel;
 
 				/**/
@@ -282,7 +286,7 @@ namespace LxGeo
 				loaded_gimg.geotransform[3] = (y_direction_sign == 1) ? MinY : MaxY;
 				
 				KGDAL2CV kgdal2cv;
-				cv::Mat loaded_image = kgdal2cv.PaddedImgReadByGDAL(in_file, col_start_pixel, row_start_pixel, col_end_pixel - col_start_pixel, row_end_pixel - row_start_pixel);
+				cv::Mat loaded_image = kgdal2cv.PaddedImgReadByGDAL(raster_dataset.get(), col_start_pixel, row_start_pixel, col_end_pixel - col_start_pixel, row_end_pixel - row_start_pixel);
 				loaded_gimg.set_image(loaded_image);
 				// fix geotransform because of padding
 				
@@ -290,21 +294,7 @@ namespace LxGeo
 			}
 
 			static GeoImage<cv_mat_type> from_file(const std::string& in_file) {
-				GeoImage<cv_mat_type> loaded_gimg;
-				GDALDataset* raster_dataset = (GDALDataset*)GDALOpen(in_file.c_str(), GA_ReadOnly);
-				if (raster_dataset->GetGeoTransform(loaded_gimg.geotransform) != CE_None) {
-					// temporary fix for the north facing rasters
-					loaded_gimg.geotransform[5] = -1.0;
-				}
-				int raster_has_nodata;
-				double nodata_value = raster_dataset->GetRasterBand(1)->GetNoDataValue(&raster_has_nodata);
-				std::optional<double> nodata; if (raster_has_nodata) nodata= nodata_value;
-				loaded_gimg.no_data = nodata;
-				GDALClose((GDALDatasetH)raster_dataset);
-				KGDAL2CV kgdal2cv;
-				cv::Mat loaded_image = kgdal2cv.ImgReadByGDAL(in_file);
-				loaded_gimg.set_image(loaded_image);
-				return loaded_gimg;
+				return from_dataset(GDALDatasetPool::instance().acquire(in_file));
 			}
 
 			static GeoImage<cv_mat_type> from_dataset(std::shared_ptr<GDALDataset> raster_dataset) {
@@ -318,9 +308,7 @@ namespace LxGeo
 				std::optional<double> nodata; if (raster_has_nodata) nodata= nodata_value;
 				loaded_gimg.no_data = nodata;
 				KGDAL2CV kgdal2cv;
-				// TODO: this should be changed by adding a method in kgdal to load from dataset
-				std::string file_name(raster_dataset->GetFileList()[0]);
-				cv::Mat loaded_image = kgdal2cv.ImgReadByGDAL(file_name);
+				cv::Mat loaded_image = kgdal2cv.ImgReadByGDAL(raster_dataset.get());
 				loaded_gimg.set_image(loaded_image);
 				return loaded_gimg;
 			}
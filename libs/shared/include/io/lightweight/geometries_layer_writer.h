@@ -0,0 +1,163 @@
+#pragma once
+#include "defs.h"
+#include "geometries_with_attributes/geometries_with_attributes.h"
+#include "wkb_codec.h"
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+
+		// Features written per transaction by default (GeoPackage, SQLite, PostGIS ... outputs)
+		inline constexpr size_t DEFAULT_TRANSACTION_BATCH_SIZE = 100000;
+
+		/**
+		Writes geometries with attributes to a layer.
+		Features are grouped in dataset transactions of transaction_batch_size features (0: no transaction). Drivers without
+		transactions write features one by one as before. New features are filled in a single reused OGRFeature and
+		layer field indices are resolved once per attribute (per field id for geometries bound to an attribute table).
+		The last transaction is committed by finish() or on destruction.
+		*/
+		template <typename geom_type>
+		class GeometriesLayerWriter {
+
+		public:
+			GeometriesLayerWriter(GDALDataset* _dataset, OGRLayer* _layer, WriteMode _wm, const std::string& _id_field_name,
+				size_t _transaction_batch_size = DEFAULT_TRANSACTION_BATCH_SIZE) :
+				dataset(_dataset), layer(_layer), wm(_wm), id_field_name(_id_field_name), transaction_batch_size(_transaction_batch_size),
+				reused_feature(OGRFeature::CreateFeature(_layer->GetLayerDefn())) {};
+
+			~GeometriesLayerWriter() {
+				finish();
+			}
+
+			GeometriesLayerWriter(const GeometriesLayerWriter&) = delete;
+			GeometriesLayerWriter& operator=(const GeometriesLayerWriter&) = delete;
+
+			/**
+			This will check if a feature with the same id already exists (update mode), else create a new one
+			*/
+			void write(const Geometries_with_attributes<geom_type>& gwa) {
+				if (transaction_batch_size > 0 && transactions_supported && !in_transaction) {
+					in_transaction = dataset->StartTransaction() == OGRERR_NONE;
+					transactions_supported = in_transaction;
+				}
+
+				OGRFeatureUniquePtr existing_feature;
+				if (wm == WriteMode::update)
+					existing_feature.reset(layer->GetFeature(gwa.get_int_attribute(id_field_name)));
+				OGRFeature* feature = existing_feature ? existing_feature.get() : reset_reused_feature();
+
+				feature->SetGeometryDirectly(wkb::to_ogr_geometry(gwa.get_definition()));
+				set_feature_fields(gwa, feature);
+
+				if (!existing_feature) {
+					// Writes new feature
+					OGRErr error = layer->CreateFeature(feature);
+					if (error != OGRERR_NONE) std::cout << "Error code : " << int(error) << std::endl;
+				}
+				else {
+					layer->SetFeature(feature);
+				}
+
+				if (in_transaction && ++transaction_features_count >= transaction_batch_size) {
+					commit_transaction();
+				}
+			}
+
+			void finish() {
+				if (in_transaction)
+					commit_transaction();
+			}
+
+		private:
+			OGRFeature* reset_reused_feature() {
+				reused_feature->SetFID(OGRNullFID);
+				for (int field_idx = 0; field_idx < reused_feature->GetFieldCount(); field_idx++)
+					if (reused_feature->IsFieldSet(field_idx))
+						reused_feature->UnsetField(field_idx);
+				return reused_feature.get();
+			}
+
+			void commit_transaction() {
+				OGRErr error = dataset->CommitTransaction();
+				if (error != OGRERR_NONE) std::cout << "Transaction commit error code : " << int(error) << std::endl;
+				in_transaction = false;
+				transaction_features_count = 0;
+			}
+
+			int field_index(const std::string& name) {
+				auto index_it = name_field_indices.find(name);
+				if (index_it != name_field_indices.end())
+					return index_it->second;
+				int field_idx = layer->GetLayerDefn()->GetFieldIndex(name.c_str());
+				name_field_indices.emplace(name, field_idx);
+				return field_idx;
+			}
+
+			void set_feature_fields(const Geometries_with_attributes<geom_type>& gwa, OGRFeature* feature) {
+				const auto& table = gwa.get_attributes_table();
+				if (!table) {
+					std::list<std::string> int_attributes, double_attributes, string_attributes;
+					gwa.get_list_of_int_attributes(int_attributes);
+					gwa.get_list_of_double_attributes(double_attributes);
+					gwa.get_list_of_string_attributes(string_attributes);
+					for (const std::string& name : int_attributes)
+						if (int field_idx = field_index(name); field_idx >= 0)
+							feature->SetField(field_idx, gwa.get_int_attribute(name));
+					for (const std::string& name : double_attributes)
+						if (int field_idx = field_index(name); field_idx >= 0)
+							feature->SetField(field_idx, gwa.get_double_attribute(name));
+					for (const std::string& name : string_attributes)
+						if (int field_idx = field_index(name); field_idx >= 0)
+							feature->SetField(field_idx, gwa.get_string_attribute(name).c_str());
+					return;
+				}
+
+				// table columns are read directly, layer indices are cached by field id
+				if (table.get() != indexed_table) {
+					indexed_table = table.get();
+					table_field_indices.clear();
+				}
+				for (field_id fid = static_cast<field_id>(table_field_indices.size()); fid < table->fields_count(); fid++)
+					table_field_indices.push_back(field_index(table->field_name(fid)));
+
+				size_t row = gwa.get_attributes_row();
+				for (field_id fid = 0; fid < table->fields_count(); fid++) {
+					int field_idx = table_field_indices[fid];
+					if (field_idx < 0 || table->is_null(row, fid))
+						continue;
+					switch (table->field_type(fid)) {
+					case AttributeType::int64:
+						feature->SetField(field_idx, static_cast<int>(table->get_int(row, fid)));
+						break;
+					case AttributeType::real:
+						feature->SetField(field_idx, table->get_double(row, fid));
+						break;
+					case AttributeType::string:
+						feature->SetField(field_idx, table->get_string(row, fid).c_str());
+						break;
+					}
+				}
+			}
+
+		private:
+			GDALDataset* dataset;
+			OGRLayer* layer;
+			WriteMode wm;
+			std::string id_field_name;
+			size_t transaction_batch_size;
+			OGRFeatureUniquePtr reused_feature;
+
+			bool transactions_supported = true;
+			bool in_transaction = false;
+			size_t transaction_features_count = 0;
+
+			std::unordered_map<std::string, int> name_field_indices;
+			const AttributeTable* indexed_table = nullptr;
+			std::vector<int> table_field_indices;
+		};
+
+	}
+}
@@ -1,5 +1,8 @@
 #pragma once
 #include "defs.h"
+#include <array>
+#include <sstream>
+#include <boost/filesystem.hpp>
 #include "export_io_data.h"
 #include "GDAL_OPENCV_IO.h"
 #include "coords.h"
@@ -7,23 +10,29 @@
 #include "geometries_with_attributes/geometries_with_attributes.h"
 #include "lightweight/vector_profile.h"
 #include "spatial_index/spatial_indexed_geometry_container.h"
+#include "lightweight/geometries_layer_writer.h"
+#include "lightweight/geovector_cache.h"
 
 namespace LxGeo
 {
 
 	namespace IO_DATA
 	{
+		template <typename geom_type, typename rtree_parameters>
+		class GeoVectorStream;
+
 		/**
 		A struct modeling a set of geometries with attributes.
+		rtree_parameters selects the spatial index balancing policy and node capacity (see SpatialIndexedGeometryContainer).
 		*/
-		template <typename geom_type>
-		struct GeoVector :public SpatialIndexedGeometryContainer<geom_type> {
+		template <typename geom_type, typename rtree_parameters = bgi::quadratic<16>>
+		struct GeoVector :public SpatialIndexedGeometryContainer<geom_type, rtree_parameters> {
 
-			using Boost_Value = typename SpatialIndexedGeometryContainer<geom_type>::Boost_Value;
-			using Boost_RTree = typename SpatialIndexedGeometryContainer<geom_type>::Boost_RTree;
+			using Boost_Value = typename SpatialIndexedGeometryContainer<geom_type, rtree_parameters>::Boost_Value;
+			using Boost_RTree = typename SpatialIndexedGeometryContainer<geom_type, rtree_parameters>::Boost_RTree;
 
-			using SpatialIndexedGeometryContainer<geom_type>::rtree;
-			using SpatialIndexedGeometryContainer<geom_type>::init_rtree;
+			using SpatialIndexedGeometryContainer<geom_type, rtree_parameters>::rtree;
+			using SpatialIndexedGeometryContainer<geom_type, rtree_parameters>::init_rtree;
 
 			using ogr_geom_type = std::conditional_t<
 				std::is_same_v<geom_type, Boost_Point_2>,
@@ -31,41 +40,70 @@ namespace LxGeo
 				std::is_same_v<geom_type, Boost_LineString_2>,
 				OGRLineString, OGRPolygon>>;
 
+			friend class GeoVectorStream<geom_type, rtree_parameters>;
+
 		public:
+			/**
+			Stable feature identifier: the FID of features read from a dataset, a new identifier for geometries added through add_geometry.
+			It is not a container index (remove_geometry moves geometries) and is the FID used by to_dataset in update mode.
+			*/
 			inline static const std::string ID_FIELD_NAME = "__ID";
 
 			GeoVector() {};
 
-			GeoVector(const std::vector<Geometries_with_attributes<geom_type>>& _geometries_container) :SpatialIndexedGeometryContainer<geom_type>() {
+			GeoVector(const std::vector<Geometries_with_attributes<geom_type>>& _geometries_container) :SpatialIndexedGeometryContainer<geom_type, rtree_parameters>() {
 				geometries_container.reserve(_geometries_container.size());
 				std::copy(_geometries_container.begin(), _geometries_container.end(), std::back_inserter(geometries_container));
+				compact_attributes();
+				seed_next_feature_id();
 				init_rtree();
 			}
 
-			GeoVector(std::vector<Geometries_with_attributes<geom_type>>&& _geometries_container) :SpatialIndexedGeometryContainer<geom_type>() {
+			GeoVector(std::vector<Geometries_with_attributes<geom_type>>&& _geometries_container) :SpatialIndexedGeometryContainer<geom_type, rtree_parameters>() {
 				geometries_container = std::move(_geometries_container);
+				compact_attributes();
+				seed_next_feature_id();
 				init_rtree();
 			}
 
-			GeoVector(const std::vector<geom_type>& _geometries_container) :SpatialIndexedGeometryContainer<geom_type>() {
+			GeoVector(const std::vector<geom_type>& _geometries_container) :SpatialIndexedGeometryContainer<geom_type, rtree_parameters>() {
 				geometries_container.reserve(_geometries_container.size());
+				auto deferred_index = this->defer_rtree_updates();
 				for (const auto& c_geom : _geometries_container) {
 					add_geometry(c_geom);
 				}
-				init_rtree();
 			}
 
-			GeoVector(GeoVector&& other) noexcept : SpatialIndexedGeometryContainer<geom_type>(std::move(other))  {
+			GeoVector(GeoVector&& other) noexcept : SpatialIndexedGeometryContainer<geom_type, rtree_parameters>(std::move(other))  {
 				geometries_container = std::move(other.geometries_container);				
+				attribute_table = std::move(other.attribute_table);
+				crs_wkt = std::move(other.crs_wkt);
+				next_feature_id = other.next_feature_id;
 			}
 
-			GeoVector(const GeoVector& other) : SpatialIndexedGeometryContainer<geom_type>(other) {
-				geometries_container = other.geometries_container;
+			GeoVector(const GeoVector& other) : SpatialIndexedGeometryContainer<geom_type, rtree_parameters>(other) {
+				// the attribute table is copied at once, geometries refer to the same rows of the copy
+				attribute_table = other.attribute_table ? std::make_shared<AttributeTable>(*other.attribute_table) : std::make_shared<AttributeTable>();
+				geometries_container.reserve(other.geometries_container.size());
+				for (const auto& c_gwa : other.geometries_container) {
+					if (c_gwa.get_attributes_table() == other.attribute_table) {
+						geometries_container.push_back(Geometries_with_attributes<geom_type>(c_gwa.get_definition()));
+						geometries_container.back().attach_attributes_row(attribute_table, c_gwa.get_attributes_row());
+					}
+					else
+						geometries_container.push_back(c_gwa);
+				}
+				crs_wkt = other.crs_wkt;
+				next_feature_id = other.next_feature_id;
 			}
 
 			GeoVector& operator=(GeoVector&& other) noexcept {
 				if (this != &other) {
+					SpatialIndexedGeometryContainer<geom_type, rtree_parameters>::operator=(std::move(other));
 					geometries_container = std::move(other.geometries_container);
+					attribute_table = std::move(other.attribute_table);
+					crs_wkt = std::move(other.crs_wkt);
+					next_feature_id = other.next_feature_id;
 				}
 				return *this;
 			}
@@ -93,15 +131,88 @@ namespace LxGeo
 				return bounds;
 			}
 
+			/**
+			Geometries edits below keep the rtree in sync (see defer_rtree_updates to batch many edits).
+			Direct edits of geometries_container require init_rtree.
+			*/
 			void add_geometry(geom_type in_geometry) {
+				auto deferred_index = this->defer_rtree_updates();
 				geometries_container.push_back(Geometries_with_attributes<geom_type>(in_geometry));
 				int c_idx = geometries_container.size() - 1;
-				geometries_container[c_idx].set_int_attribute(ID_FIELD_NAME, c_idx);
+				bind_attributes(c_idx);
+				// after every loaded or added identifier (identifiers of removed geometries are not reused)
+				size_t c_id = std::max<size_t>(next_feature_id, c_idx);
+				geometries_container[c_idx].set_int_attribute(ID_FIELD_NAME, c_id);
+				next_feature_id = c_id + 1;
+				this->rtree_index(c_idx);
 			}
 
 			void add_geometry(Geometries_with_attributes<geom_type> in_geometry_wa) {
-				geometries_container.push_back(in_geometry_wa);
-				// check if current index in tree else add Boost value to tree
+				auto deferred_index = this->defer_rtree_updates();
+				geometries_container.push_back(std::move(in_geometry_wa));
+				bind_attributes(geometries_container.size() - 1);
+				// a geometry carrying an identifier (merged from another GeoVector) pushes the next identifier after it
+				seed_next_feature_id(geometries_container.back().get_attributes_row());
+				this->rtree_index(geometries_container.size() - 1);
+			}
+
+			void set_geometry(size_t idx, const geom_type& in_geometry) {
+				auto deferred_index = this->defer_rtree_updates();
+				this->rtree_unindex(idx);
+				geometries_container[idx].set_definition(in_geometry);
+				this->rtree_index(idx);
+			}
+
+			/**
+			Removes the geometry at idx. The last geometry takes its place (order is not preserved) and keeps its ID_FIELD_NAME identifier.
+			*/
+			void remove_geometry(size_t idx) {
+				auto deferred_index = this->defer_rtree_updates();
+				size_t last_idx = geometries_container.size() - 1;
+				this->rtree_unindex(idx);
+				if (geometries_container[idx].get_attributes_table() == attribute_table)
+					attribute_table->clear_row(geometries_container[idx].get_attributes_row());
+				if (idx != last_idx) {
+					this->rtree_unindex(last_idx);
+					geometries_container[idx] = std::move(geometries_container[last_idx]);
+					this->rtree_index(idx);
+				}
+				geometries_container.pop_back();
+			}
+
+			/**
+			Columnar attributes of the geometries added through add_geometry (see AttributeTable).
+			Per geometry accessors of Geometries_with_attributes read and write the same rows.
+			*/
+			const std::shared_ptr<AttributeTable>& attributes() const {
+				return attribute_table;
+			}
+
+			// Moves the attributes of the geometry at idx into a new row of the attribute table
+			void bind_attributes(size_t idx) {
+				if (!attribute_table)
+					attribute_table = std::make_shared<AttributeTable>();
+				if (geometries_container[idx].get_attributes_table() != attribute_table)
+					geometries_container[idx].bind_attributes(attribute_table, attribute_table->add_row());
+			}
+
+			// Binds all geometries to the attribute table (geometries pushed directly into geometries_container)
+			void compact_attributes() {
+				for (size_t idx = 0; idx < geometries_container.size(); idx++)
+					bind_attributes(idx);
+			}
+
+		private:
+			// Moves the next identifier given by add_geometry after the ID_FIELD_NAME values of the attribute table rows from first_row
+			void seed_next_feature_id(size_t first_row = 0) {
+				if (!attribute_table)
+					return;
+				auto id_field = attribute_table->find_field(ID_FIELD_NAME, AttributeType::int64);
+				if (!id_field)
+					return;
+				for (size_t row = first_row; row < attribute_table->rows_count(); row++)
+					if (!attribute_table->is_null(row, *id_field))
+						next_feature_id = std::max<int64_t>(next_feature_id, attribute_table->get_int(row, *id_field) + 1);
 			}
 
 		public:
@@ -120,14 +231,20 @@ namespace LxGeo
 				std::list<Boost_Value> candidates;
 				rtree.query(bgi::intersects(search_envelope), std::back_inserter(candidates));
 
+				// the view index is packed from the parent index values (no envelope computation)
+				std::vector<Boost_Value> view_values; view_values.reserve(candidates.size());
 				for (auto& c_candidate : candidates) {
 					size_t c_candidate_idx = c_candidate.second;
 					const auto& c_candidate_geometry = geometries_container[c_candidate_idx];
 					bool is_within = boost::geometry::intersects(search_envelope, c_candidate_geometry.get_definition());
-					if (is_within)
-						out_geovector.add_geometry(c_candidate_geometry);
+					if (is_within) {
+						out_geovector.geometries_container.push_back(c_candidate_geometry);
+						out_geovector.bind_attributes(out_geovector.geometries_container.size() - 1);
+						view_values.push_back(std::make_pair(c_candidate.first, out_geovector.geometries_container.size() - 1));
+					}
 				}
-				out_geovector.init_rtree();
+				out_geovector.rtree = Boost_RTree(view_values.begin(), view_values.end());
+				out_geovector.next_feature_id = next_feature_id;
 
 				return std::move(out_geovector);
 			}
@@ -159,10 +276,321 @@ namespace LxGeo
 				assert(included_fields.empty() | excluded_fields.empty() && "Both inculde and exclude fields are provided!");
 
 				GeoVector loaded_gvec;
+
+				// cache of the same files state and loading parameters, checked before opening the dataset
+				std::string cache_path;
+				geovector_cache::SourceKey source_key;
+				if (!cache_directory.empty() && cache_source_key(in_file, layer_name, spatial_filter, included_fields, excluded_fields, _field_rename, source_key)) {
+					cache_path = (boost::filesystem::path(cache_directory) / fmt::format("{:016x}{}", source_key.load_hash, geovector_cache::FILE_EXTENSION)).string();
+					if (boost::filesystem::exists(cache_path)) {
+						try {
+							GeoVectorCache<geom_type> cache(cache_path);
+							if (cache.source_key() == source_key)
+								return from_cache(cache);
+						}
+						catch (std::exception& e) {
+							BOOST_LOG_TRIVIAL(warning) << "GeoVector cache ignored: " << e.what();
+						}
+					}
+				}
+
 				auto vector_dataset = load_gdal_vector_dataset_shared_ptr(in_file);
 				VProfile vector_dataset_profile = VProfile::from_gdal_dataset(vector_dataset);
 				loaded_gvec.crs_wkt = vector_dataset_profile.s_crs_wkt;
 
+				OGRLayer* to_load_layer = get_layer_to_load(vector_dataset.get(), layer_name, in_file);
+				OGRPolygon spatial_filter_ogr = transform_B2OGR_Polygon(spatial_filter);
+				if (!spatial_filter_ogr.IsEmpty())
+					to_load_layer->SetSpatialFilter(&spatial_filter_ogr);
+
+				std::unordered_set<std::string> to_load_fields;
+				std::unordered_map<std::string, std::string> field_rename;
+				resolve_fields_to_load(to_load_layer, included_fields, excluded_fields, _field_rename, to_load_fields, field_rename);
+
+				loaded_gvec.geometries_container.reserve(to_load_layer->GetFeatureCount());
+				to_load_layer->ResetReading();
+				load_layer_features(to_load_layer, loaded_gvec, spatial_filter, to_load_fields, field_rename);
+				loaded_gvec.geometries_container.shrink_to_fit();
+				loaded_gvec.init_rtree();
+
+				if (!cache_path.empty()) {
+					// written aside then renamed: concurrent runs never read a partial cache
+					try {
+						boost::filesystem::create_directories(cache_directory);
+						std::string tmp_cache_path = cache_path + fmt::format(".{}.tmp", boost::filesystem::unique_path().string());
+						loaded_gvec.to_cache(tmp_cache_path, source_key);
+						boost::filesystem::rename(tmp_cache_path, cache_path);
+					}
+					catch (std::exception& e) {
+						BOOST_LOG_TRIVIAL(warning) << "GeoVector cache not written: " << e.what();
+					}
+				}
+				return loaded_gvec;
+			}
+
+			/**
+			Loads a cache file written by to_cache: geometries are copied from the mapped file, the rtree is packed from the stored envelopes.
+			*/
+			static GeoVector from_cache(const std::string& cache_path) {
+				return from_cache(GeoVectorCache<geom_type>(cache_path));
+			}
+
+			static GeoVector from_cache(const GeoVectorCache<geom_type>& cache) {
+				GeoVector loaded_gvec;
+				loaded_gvec.crs_wkt = std::string(cache.crs_wkt());
+				loaded_gvec.attribute_table = cache.load_attributes();
+				loaded_gvec.geometries_container.reserve(cache.length());
+				std::vector<Boost_Value> rtree_values(cache.length());
+				for (size_t idx = 0; idx < cache.length(); idx++) {
+					loaded_gvec.geometries_container.push_back(Geometries_with_attributes<geom_type>(cache.geometry(idx)));
+					loaded_gvec.geometries_container.back().attach_attributes_row(loaded_gvec.attribute_table, idx);
+					if constexpr (std::is_same_v<geom_type, Boost_Point_2>)
+						rtree_values[idx] = std::make_pair(loaded_gvec.geometries_container.back().get_definition(), idx);
+					else
+						rtree_values[idx] = std::make_pair(cache.envelope(idx), idx);
+				}
+				loaded_gvec.seed_next_feature_id();
+				loaded_gvec.init_rtree(std::move(rtree_values));
+				return loaded_gvec;
+			}
+
+			/**
+			Writes geometries, attributes (one row per geometry, in geometries order), envelopes and crs to a cache file
+			(see GeoVectorCache for in place access). source_key identifies the source the geometries were loaded from.
+			*/
+			void to_cache(const std::string& cache_path, const geovector_cache::SourceKey& source_key = {}) const {
+				// geometries not bound to the attribute table are written from a compacted copy
+				for (const auto& c_gwa : geometries_container) {
+					if (c_gwa.get_attributes_table() != attribute_table) {
+						GeoVector compacted_gvec(*this);
+						compacted_gvec.compact_attributes();
+						return compacted_gvec.to_cache(cache_path, source_key);
+					}
+				}
+
+				size_t geometries_count = geometries_container.size();
+				std::vector<uint64_t> geometry_rings, ring_points;
+				std::vector<double> coordinates, envelopes;
+				geometry_rings.reserve(geometries_count + 1); geometry_rings.push_back(0);
+				ring_points.reserve(geometries_count + 1); ring_points.push_back(0);
+				envelopes.reserve(4 * geometries_count);
+				auto add_ring = [&](const auto& ring_points_range) {
+					for (const Boost_Point_2& c_point : ring_points_range) {
+						coordinates.push_back(c_point.get<0>());
+						coordinates.push_back(c_point.get<1>());
+					}
+					ring_points.push_back(coordinates.size() / 2);
+				};
+				for (const auto& c_gwa : geometries_container) {
+					const geom_type& c_geometry = c_gwa.get_definition();
+					if constexpr (std::is_same_v<geom_type, Boost_Point_2>)
+						add_ring(std::array<Boost_Point_2, 1>{ c_geometry });
+					else if constexpr (std::is_same_v<geom_type, Boost_LineString_2>)
+						add_ring(c_geometry);
+					else if (!c_geometry.outer().empty()) {
+						add_ring(c_geometry.outer());
+						for (const auto& c_inner : c_geometry.inners())
+							add_ring(c_inner);
+					}
+					geometry_rings.push_back(ring_points.size() - 1);
+					Boost_Box_2 c_envelope; bg::envelope(c_geometry, c_envelope);
+					envelopes.insert(envelopes.end(), { c_envelope.min_corner().get<0>(), c_envelope.min_corner().get<1>(), c_envelope.max_corner().get<0>(), c_envelope.max_corner().get<1>() });
+				}
+
+				geovector_cache::FileWriter cache_writer(cache_path);
+				geovector_cache::FileHeader header{};
+				std::copy(std::begin(geovector_cache::MAGIC), std::end(geovector_cache::MAGIC), header.magic);
+				header.version = geovector_cache::VERSION;
+				header.geometry_kind = static_cast<uint32_t>(geovector_cache::geometry_kind<geom_type>());
+				header.source_key = source_key;
+				header.geometries_count = geometries_count;
+				header.rings_count = ring_points.size() - 1;
+				header.points_count = coordinates.size() / 2;
+				header.crs_offset = cache_writer.write(crs_wkt.data(), crs_wkt.size());
+				header.crs_size = crs_wkt.size();
+				header.geometry_rings_offset = cache_writer.write_array(geometry_rings);
+				header.ring_points_offset = cache_writer.write_array(ring_points);
+				header.points_offset = cache_writer.write_array(coordinates);
+				header.envelopes_offset = cache_writer.write_array(envelopes);
+
+				// attribute columns gathered in geometries order
+				std::vector<geovector_cache::FieldHeader> fields_headers(attribute_table->fields_count());
+				for (field_id fid = 0; fid < attribute_table->fields_count(); fid++) {
+					geovector_cache::FieldHeader& c_field = fields_headers[fid];
+					const std::string& c_name = attribute_table->field_name(fid);
+					c_field.type = static_cast<uint32_t>(attribute_table->field_type(fid));
+					c_field.name_size = static_cast<uint32_t>(c_name.size());
+					c_field.name_offset = cache_writer.write(c_name.data(), c_name.size());
+
+					std::vector<uint64_t> valid_bits((geometries_count + 63) / 64, 0);
+					for (size_t idx = 0; idx < geometries_count; idx++)
+						if (!attribute_table->is_null(geometries_container[idx].get_attributes_row(), fid))
+							valid_bits[idx / 64] |= uint64_t(1) << (idx % 64);
+					c_field.validity_offset = cache_writer.write_array(valid_bits);
+
+					auto gather_rows = [&](const auto& column_values) {
+						std::vector<std::decay_t<decltype(column_values[0])>> gathered_values(geometries_count);
+						for (size_t idx = 0; idx < geometries_count; idx++)
+							gathered_values[idx] = column_values[geometries_container[idx].get_attributes_row()];
+						return cache_writer.write_array(gathered_values);
+					};
+					switch (attribute_table->field_type(fid)) {
+					case AttributeType::int64:
+						c_field.values_offset = gather_rows(attribute_table->int_column(fid));
+						break;
+					case AttributeType::real:
+						c_field.values_offset = gather_rows(attribute_table->double_column(fid));
+						break;
+					case AttributeType::string: {
+						c_field.values_offset = gather_rows(attribute_table->string_codes_column(fid));
+						const auto& dictionary = attribute_table->string_dictionary(fid);
+						std::vector<uint64_t> string_offsets; string_offsets.reserve(dictionary.size() + 1);
+						std::string string_bytes;
+						for (const std::string& c_string : dictionary) {
+							string_offsets.push_back(string_bytes.size());
+							string_bytes += c_string;
+						}
+						string_offsets.push_back(string_bytes.size());
+						c_field.dictionary_count = dictionary.size();
+						c_field.dictionary_offsets_offset = cache_writer.write_array(string_offsets);
+						c_field.dictionary_bytes_offset = cache_writer.write(string_bytes.data(), string_bytes.size());
+						break;
+					}
+					}
+				}
+				header.fields_count = fields_headers.size();
+				header.fields_offset = cache_writer.write_array(fields_headers);
+				cache_writer.write_header(header);
+			}
+
+		private:
+			/**
+			Key of the dataset files state (see geovector_cache::source_files) and of the loading parameters.
+			Returns false for datasets without files (databases, services).
+			*/
+			static bool cache_source_key(const std::string& in_file, const std::string& layer_name, const Boost_Polygon_2& spatial_filter,
+				const std::unordered_set<std::string>& included_fields, const std::unordered_set<std::string>& excluded_fields,
+				const std::unordered_map<std::string, std::string>& field_rename, geovector_cache::SourceKey& source_key) {
+
+				std::vector<std::string> files_paths = geovector_cache::source_files(in_file);
+				if (files_paths.empty())
+					return false;
+				source_key = geovector_cache::source_files_key(files_paths, cache_hash_full_content);
+
+				// unordered containers are sorted for a stable key
+				std::ostringstream load_parameters;
+				load_parameters << boost::filesystem::absolute(in_file).string() << '\n' << layer_name << '\n' << bg::wkt(spatial_filter) << '\n'
+					<< static_cast<uint32_t>(geovector_cache::geometry_kind<geom_type>()) << '\n';
+				std::set<std::string> sorted_included(included_fields.begin(), included_fields.end()), sorted_excluded(excluded_fields.begin(), excluded_fields.end());
+				std::map<std::string, std::string> sorted_rename(field_rename.begin(), field_rename.end());
+				for (const auto& c_field : sorted_included) load_parameters << "+" << c_field << '\n';
+				for (const auto& c_field : sorted_excluded) load_parameters << "-" << c_field << '\n';
+				for (const auto& [c_field, c_name] : sorted_rename) load_parameters << c_field << "=" << c_name << '\n';
+				std::string load_parameters_str = load_parameters.str();
+				source_key.load_hash = geovector_cache::hash_bytes(load_parameters_str.data(), load_parameters_str.size());
+				return true;
+			}
+
+		public:
+			// When set, from_file reuses (or writes) a cache of each loaded layer in this directory (see to_cache)
+			inline static std::string cache_directory;
+			// Cache keys hash the whole source files instead of their first and last bytes (detects edits keeping files size and modification time)
+			inline static bool cache_hash_full_content = false;
+
+			/**
+			Loads the layer with n_threads workers (0: hardware concurrency), each reading a range of features through its own dataset handle.
+			Ranges are features indices when the layer supports fast random access (shapefiles), FID ranges otherwise
+			(layers with a FID column such as GeoPackages). Other layers are loaded sequentially.
+			Geometries and attributes are the same as from_file, in the same (FID) order.
+			*/
+			static GeoVector from_file_parallel(const std::string& in_file, size_t n_threads = 0, std::string layer_name = "", const Boost_Polygon_2& spatial_filter = Boost_Polygon_2(),
+				const std::unordered_set<std::string>& included_fields = {}, const std::unordered_set<std::string>& excluded_fields = {}, const std::unordered_map<std::string, std::string>& _field_rename = {}) {
+
+				assert(included_fields.empty() | excluded_fields.empty() && "Both inculde and exclude fields are provided!");
+				if (n_threads == 0)
+					n_threads = default_threads_count();
+
+				auto vector_dataset = load_gdal_vector_dataset_shared_ptr(in_file);
+				OGRLayer* to_load_layer = get_layer_to_load(vector_dataset.get(), layer_name, in_file);
+				std::string loaded_layer_name = to_load_layer->GetName();
+
+				// features ranges: (first feature index, features count) or FID attribute filters
+				std::vector<std::pair<GIntBig, GIntBig>> index_ranges;
+				std::vector<std::string> fid_filters;
+				GIntBig features_count = to_load_layer->GetFeatureCount();
+				if (to_load_layer->TestCapability(OLCFastSetNextByIndex)) {
+					GIntBig range_size = (features_count + n_threads - 1) / n_threads;
+					for (GIntBig range_start = 0; range_start < features_count; range_start += range_size)
+						index_ranges.push_back({ range_start, std::min(range_size, features_count - range_start) });
+				}
+				else if (!std::string(to_load_layer->GetFIDColumn()).empty()) {
+					std::string fid_column = to_load_layer->GetFIDColumn();
+					std::string bounds_query = "SELECT MIN(\"" + fid_column + "\"), MAX(\"" + fid_column + "\") FROM \"" + loaded_layer_name + "\"";
+					OGRLayer* bounds_layer = vector_dataset->ExecuteSQL(bounds_query.c_str(), nullptr, nullptr);
+					if (bounds_layer) {
+						OGRFeatureUniquePtr bounds_feature(bounds_layer->GetNextFeature());
+						if (bounds_feature && bounds_feature->IsFieldSetAndNotNull(0)) {
+							GIntBig min_fid = bounds_feature->GetFieldAsInteger64(0), max_fid = bounds_feature->GetFieldAsInteger64(1);
+							GIntBig range_size = (max_fid - min_fid + n_threads) / n_threads;
+							for (GIntBig range_start = min_fid; range_start <= max_fid; range_start += range_size)
+								fid_filters.push_back(fmt::format("\"{}\" >= {} AND \"{}\" < {}", fid_column, range_start, fid_column, range_start + range_size));
+						}
+						vector_dataset->ReleaseResultSet(bounds_layer);
+					}
+				}
+				size_t ranges_count = std::max(index_ranges.size(), fid_filters.size());
+				if (n_threads == 1 || ranges_count <= 1)
+					return from_file(in_file, layer_name, spatial_filter, included_fields, excluded_fields, _field_rename);
+
+				std::unordered_set<std::string> to_load_fields;
+				std::unordered_map<std::string, std::string> field_rename;
+				resolve_fields_to_load(to_load_layer, included_fields, excluded_fields, _field_rename, to_load_fields, field_rename);
+
+				std::vector<GeoVector> loaded_chunks(ranges_count);
+				parallel_for_chunks(ranges_count, ranges_count, [&](size_t range_begin, size_t range_end) {
+					for (size_t range_idx = range_begin; range_idx < range_end; range_idx++) {
+						auto worker_dataset = load_gdal_vector_dataset_shared_ptr(in_file);
+						OGRLayer* worker_layer = worker_dataset->GetLayerByName(loaded_layer_name.c_str());
+						auto worker_field_rename = field_rename;
+						worker_layer->ResetReading();
+						if (!fid_filters.empty()) {
+							OGRPolygon spatial_filter_ogr = transform_B2OGR_Polygon(spatial_filter);
+							if (!spatial_filter_ogr.IsEmpty())
+								worker_layer->SetSpatialFilter(&spatial_filter_ogr);
+							worker_layer->SetAttributeFilter(fid_filters[range_idx].c_str());
+							load_layer_features(worker_layer, loaded_chunks[range_idx], spatial_filter, to_load_fields, worker_field_rename);
+						}
+						else {
+							// indices refer to unfiltered features, the spatial filter is applied on loaded geometries
+							worker_layer->SetNextByIndex(index_ranges[range_idx].first);
+							load_layer_features(worker_layer, loaded_chunks[range_idx], spatial_filter, to_load_fields, worker_field_rename, index_ranges[range_idx].second);
+						}
+					}
+					});
+
+				// chunks are merged in ranges order, attribute columns are appended at once
+				GeoVector loaded_gvec;
+				loaded_gvec.crs_wkt = VProfile::from_gdal_dataset(vector_dataset).s_crs_wkt;
+				size_t loaded_count = 0;
+				for (const auto& c_chunk : loaded_chunks)
+					loaded_count += c_chunk.length();
+				loaded_gvec.geometries_container.reserve(loaded_count);
+				for (auto& c_chunk : loaded_chunks) {
+					size_t rows_offset = loaded_gvec.attribute_table->append_rows(*c_chunk.attribute_table);
+					for (auto& c_gwa : c_chunk.geometries_container) {
+						size_t c_row = rows_offset + c_gwa.get_attributes_row();
+						loaded_gvec.geometries_container.push_back(Geometries_with_attributes<geom_type>(std::move(c_gwa.get_definition())));
+						loaded_gvec.geometries_container.back().attach_attributes_row(loaded_gvec.attribute_table, c_row);
+					}
+					loaded_gvec.next_feature_id = std::max(loaded_gvec.next_feature_id, c_chunk.next_feature_id);
+					c_chunk = GeoVector();
+				}
+				loaded_gvec.init_rtree({ true, n_threads });
+				return loaded_gvec;
+			}
+
+		private:
+			static OGRLayer* get_layer_to_load(GDALDataset* vector_dataset, const std::string& layer_name, const std::string& in_file) {
 				OGRLayer* to_load_layer;
 				if (!layer_name.empty()) {
 					to_load_layer = vector_dataset->GetLayerByName(layer_name.c_str());
@@ -178,16 +606,15 @@ namespace LxGeo
 						throw std::exception("Missing Layer");
 					}
 				}
+				return to_load_layer;
+			}
+
+			static void resolve_fields_to_load(OGRLayer* to_load_layer, const std::unordered_set<std::string>& included_fields, const std::unordered_set<std::string>& excluded_fields,
+				const std::unordered_map<std::string, std::string>& _field_rename, std::unordered_set<std::string>& to_load_fields, std::unordered_map<std::string, std::string>& field_rename) {
 
 				// TODO: code uncesseray below as layer def is already loaded using VPROFILE
 				LayerDef layer_definition = LayerDef::from_ogr_layer(to_load_layer);
-				OGRPolygon spatial_filter_ogr = transform_B2OGR_Polygon(spatial_filter);
-				if (!spatial_filter_ogr.IsEmpty())
-					to_load_layer->SetSpatialFilter(&spatial_filter_ogr);
-
-
 				auto layer_fields_names = layer_definition.get_fields_names();
-				std::unordered_set<std::string> to_load_fields;
 				if (!included_fields.empty()) {
 					std::set_intersection(layer_fields_names.begin(), layer_fields_names.end(), included_fields.begin(), included_fields.begin(), std::inserter(to_load_fields, to_load_fields.begin()));
 				}
@@ -197,16 +624,24 @@ namespace LxGeo
 				else {
 					to_load_fields = layer_fields_names;
 				}
-				auto field_rename = _field_rename;
+				field_rename = _field_rename;
 				for (auto& field_name : to_load_fields) {
 					if (field_rename.find(field_name) == field_rename.end())
 						field_rename[field_name] = field_name;
 				}
+			}
 
-				loaded_gvec.geometries_container.reserve(to_load_layer->GetFeatureCount());
-				//vector_layer->ResetReading();
-				for (auto& c_feature : to_load_layer) {
-					if (c_feature == NULL) continue;
+			/**
+			Reads up to max_features features (all if negative) from the current reading position of layer into out_gvec.
+			Returns the count of features read (skipped features included).
+			*/
+			static GIntBig load_layer_features(OGRLayer* layer, GeoVector& out_gvec, const Boost_Polygon_2& spatial_filter,
+				const std::unordered_set<std::string>& to_load_fields, std::unordered_map<std::string, std::string>& field_rename, GIntBig max_features = -1) {
+
+				GIntBig read_count = 0;
+				for (; max_features < 0 || read_count < max_features; read_count++) {
+					OGRFeatureUniquePtr c_feature(layer->GetNextFeature());
+					if (!c_feature) break;
 					OGRGeometry* geom = c_feature->GetGeometryRef();
 					if (ogr_geom_type* ogr_in_geometry = dynamic_cast<ogr_geom_type*>(geom))
 					{
@@ -215,8 +650,12 @@ namespace LxGeo
 						geom_type c_geometry = transform_OGR2B_geometry<ogr_geom_type,geom_type>(ogr_in_geometry);
 						if (!spatial_filter.outer().empty() & !bg::intersects(c_geometry, spatial_filter))
 							continue;
-						Geometries_with_attributes<geom_type> c_geometry_wa(c_geometry);
+						// attributes are written directly into the attribute table columns
+						out_gvec.geometries_container.push_back(Geometries_with_attributes<geom_type>(c_geometry));
+						out_gvec.bind_attributes(out_gvec.geometries_container.size() - 1);
+						Geometries_with_attributes<geom_type>& c_geometry_wa = out_gvec.geometries_container.back();
 						c_geometry_wa.set_int_attribute(ID_FIELD_NAME, c_feature->GetFID());
+						out_gvec.next_feature_id = std::max<GIntBig>(out_gvec.next_feature_id, c_feature->GetFID() + 1);
 
 						for (auto&& c_field : *c_feature)
 						{
@@ -249,18 +688,21 @@ namespace LxGeo
 								break;
 							}
 						}
-						loaded_gvec.add_geometry(c_geometry_wa);
 					}
 				}
-				loaded_gvec.geometries_container.shrink_to_fit();
-				loaded_gvec.init_rtree();
-				return loaded_gvec;
+				return read_count;
 			}
 
+		public:
 
+			/**
+			Writes the geometries accepted by filter_fn to the layer out_layer_name (first layer if empty).
+			Features are committed by transactions of transaction_batch_size features (0: no transaction, see GeometriesLayerWriter).
+			*/
 			void to_dataset(
 				GDALDataset* vector_dataset, WriteMode wm ,std::string out_layer_name = "",
-				const std::function<bool(const Geometries_with_attributes<geom_type>&)>& filter_fn = [](const Geometries_with_attributes<geom_type>& _) {return true; }
+				const std::function<bool(const Geometries_with_attributes<geom_type>&)>& filter_fn = [](const Geometries_with_attributes<geom_type>& _) {return true; },
+				size_t transaction_batch_size = DEFAULT_TRANSACTION_BATCH_SIZE
 			) const {
 
 				OGRLayer* out_layer;
@@ -269,62 +711,27 @@ namespace LxGeo
 				else
 					out_layer = vector_dataset->GetLayerByName(out_layer_name.c_str());
 
+				GeometriesLayerWriter<geom_type> layer_writer(vector_dataset, out_layer, wm, ID_FIELD_NAME, transaction_batch_size);
 				for (size_t i = 0; i < geometries_container.size(); ++i) {
 					const Geometries_with_attributes<geom_type>& gwa = geometries_container[i];
 					if (filter_fn(gwa))
-						save_geometry_wa_in_layer(gwa, wm, out_layer);
+						layer_writer.write(gwa);
 				}
+				layer_writer.finish();
 				out_layer->SyncToDisk();
 
 			}
 
 			/**
 			This will check if a feature with the same id already exists, else create a new one
+			(single feature without transaction, use to_dataset or a GeometriesLayerWriter for many features)
 			*/
 			void save_geometry_wa_in_layer(const Geometries_with_attributes<geom_type>& gwa, WriteMode wm, OGRLayer* out_layer) const {
-				OGRFeature* feature;
-				bool new_feature_to_create=true;
-				if (wm == WriteMode::update) {
-					feature = out_layer->GetFeature(gwa.get_int_attribute(GeoVector<geom_type>::ID_FIELD_NAME));
-					new_feature_to_create = (feature == NULL);
-					if (new_feature_to_create)
-						feature = OGRFeature::CreateFeature(out_layer->GetLayerDefn());
-				}else{
-					feature = OGRFeature::CreateFeature(out_layer->GetLayerDefn());
-				}
-				ogr_geom_type ogr_geometry = transform_B2OGR_geometry<geom_type, ogr_geom_type>(gwa.get_definition());
-				feature->SetGeometry(&ogr_geometry);
-
-				std::list<std::string> int_attributes, double_attributes, string_attributes;
-				gwa.get_list_of_int_attributes(int_attributes);
-				gwa.get_list_of_double_attributes(double_attributes);
-				gwa.get_list_of_string_attributes(string_attributes);
-				for (const std::string& name : int_attributes) {
-					int x = gwa.get_int_attribute(name);
-					feature->SetField(name.c_str(), x);
-				}
-				for (const std::string& name : double_attributes) {
-					double x = gwa.get_double_attribute(name);
-					feature->SetField(name.c_str(), x);
-				}
-				for (const std::string& name : string_attributes) {
-					std::string x = gwa.get_string_attribute(name);
-					feature->SetField(name.c_str(), x.c_str());
-				}
-
-				if (new_feature_to_create) {
-					// Writes new feature
-					OGRErr error = out_layer->CreateFeature(feature);
-					if (error != OGRERR_NONE) std::cout << "Error code : " << int(error) << std::endl;
-					OGRFeature::DestroyFeature(feature);
-				}
-				else {
-					out_layer->SetFeature(feature);
-				}
-
+				GeometriesLayerWriter<geom_type> layer_writer(nullptr, out_layer, wm, ID_FIELD_NAME, 0);
+				layer_writer.write(gwa);
 			}
 
-			void to_file(const std::string& out_file, const OGRSpatialReference* enforce_spatial_refrence = nullptr) {
+			void to_file(const std::string& out_file, const OGRSpatialReference* enforce_spatial_refrence = nullptr, size_t transaction_batch_size = DEFAULT_TRANSACTION_BATCH_SIZE) {
 				if (geometries_container.empty()) {
 					std::cout << "Empty Geovector! No file saved!" << std::endl;
 					return;
@@ -344,10 +751,10 @@ namespace LxGeo
 				else
 					out_layer = vector_dataset->GetLayerByName(out_layer_name.c_str());
 
-				for (size_t i = 0; i < geometries_container.size(); ++i) {
-					Geometries_with_attributes<geom_type>& gwa = geometries_container[i];
-					save_geometry_wa_in_layer(gwa, WriteMode::create, out_layer);
-				}
+				GeometriesLayerWriter<geom_type> layer_writer(vector_dataset.get(), out_layer, WriteMode::create, ID_FIELD_NAME, transaction_batch_size);
+				for (size_t i = 0; i < geometries_container.size(); ++i)
+					layer_writer.write(geometries_container[i]);
+				layer_writer.finish();
 				out_layer->SyncToDisk();
 
 			};
@@ -364,40 +771,45 @@ namespace LxGeo
 				for (Geometries_with_attributes<geom_type>& c_gwa : geometries_container) {
 					c_gwa.set_definition(geom_transformer(c_gwa.get_definition()));
 				}
+				// every envelope may change, a packed rebuild is cheaper than per geometry updates
 				init_rtree();
 			}
 
 		public:
 			std::vector<Geometries_with_attributes<geom_type>> geometries_container;
 			std::string crs_wkt;
+			std::shared_ptr<AttributeTable> attribute_table = std::make_shared<AttributeTable>();
 
+		private:
+			size_t next_feature_id = 0; // lower bound of the identifier given by add_geometry (after loaded FIDs, see seed_next_feature_id)
 		};
 
 		template <typename in_geom_type, typename out_geom_type>
 		void transform_geovector(const GeoVector<in_geom_type>& in_geovector, GeoVector<out_geom_type>& out_geovector,
 			const std::function<Geometries_with_attributes<out_geom_type>(const Geometries_with_attributes<in_geom_type>&)>& transformer_fn) {
+			auto deferred_index = out_geovector.defer_rtree_updates();
 			for (const Geometries_with_attributes<in_geom_type>& gwa : in_geovector.geometries_container) {
 				out_geovector.add_geometry(transformer_fn(gwa));
 			}
-			out_geovector.init_rtree();
 		}
 
 		template <typename in_geom_type, typename out_geom_type>
 		void unpool_geovector(const GeoVector<in_geom_type>& in_geovector, GeoVector<out_geom_type>& out_geovector,
 			const std::function<std::list<Geometries_with_attributes<out_geom_type>>(const Geometries_with_attributes<in_geom_type>&)>& transformer_fn) {
+			auto deferred_index = out_geovector.defer_rtree_updates();
 			for (const Geometries_with_attributes<in_geom_type>& gwa : in_geovector.geometries_container) {
 				auto children_geoms = transformer_fn(gwa);
 				for (const auto& child: children_geoms)
 					out_geovector.add_geometry(child);
 			}
 			out_geovector.crs_wkt = in_geovector.crs_wkt;
-			out_geovector.init_rtree();
 		}
 
 		template <typename in_geom_type, typename out_geom_type>
 		void pool_geovector(const GeoVector<in_geom_type>& in_geovector, GeoVector<out_geom_type>& out_geovector,
 			std::function<Geometries_with_attributes<out_geom_type> (std::list<Geometries_with_attributes<in_geom_type>>&)> transformer_fn) {
 			
+			auto deferred_index = out_geovector.defer_rtree_updates();
 			// map of parent idx and value as a list of children
 			std::map<size_t, std::list<Geometries_with_attributes<out_geom_type>>> hierarchy_map;
 
@@ -414,7 +826,6 @@ namespace LxGeo
 				out_geovector.add_geometry(pooled_geom);
 			}
 			out_geovector.crs_wkt = in_geovector.crs_wkt;
-			out_geovector.init_rtree();
 		}
 
 	}
@@ -0,0 +1,165 @@
+#pragma once
+#include "defs.h"
+#include "geovector_cache_file.h"
+#include "geometries_with_attributes/attribute_table.h"
+#include <span>
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+		/**
+		Read only, memory mapped GeoVector cache file (written by GeoVector::to_cache).
+		Opening only maps and checks the file, geometries points and attribute columns are read in place.
+		Rows of the attribute columns are the geometries indices.
+		*/
+		template <typename geom_type>
+		class GeoVectorCache {
+
+			static_assert(sizeof(Boost_Point_2) == 2 * sizeof(double), "Boost points are not stored as coordinates pairs");
+
+		public:
+			GeoVectorCache(const std::string& cache_path) : mapped_file(std::make_shared<geovector_cache::MappedFile>(cache_path)) {
+				if (mapped_file->size() < sizeof(geovector_cache::FileHeader))
+					throw std::runtime_error("Invalid GeoVector cache file: " + cache_path);
+				header = reinterpret_cast<const geovector_cache::FileHeader*>(mapped_file->data());
+				if (std::memcmp(header->magic, geovector_cache::MAGIC, sizeof(geovector_cache::MAGIC)) != 0 || header->version != geovector_cache::VERSION)
+					throw std::runtime_error("Invalid GeoVector cache file: " + cache_path);
+				if (header->geometry_kind != static_cast<uint32_t>(geovector_cache::geometry_kind<geom_type>()))
+					throw std::runtime_error("GeoVector cache geometry type mismatch: " + cache_path);
+
+				geometry_rings = section<uint64_t>(header->geometry_rings_offset, header->geometries_count + 1);
+				ring_points = section<uint64_t>(header->ring_points_offset, header->rings_count + 1);
+				points = section<Boost_Point_2>(header->points_offset, header->points_count);
+				envelopes = section<double>(header->envelopes_offset, header->geometries_count * 4);
+				fields = section<geovector_cache::FieldHeader>(header->fields_offset, header->fields_count);
+				crs = std::string_view(section<char>(header->crs_offset, header->crs_size), header->crs_size);
+				if (geometry_rings[header->geometries_count] != header->rings_count || ring_points[header->rings_count] != header->points_count)
+					throw std::runtime_error("Invalid GeoVector cache file: " + cache_path);
+			}
+
+			size_t length() const { return header->geometries_count; }
+
+			std::string_view crs_wkt() const { return crs; }
+
+			const geovector_cache::SourceKey& source_key() const { return header->source_key; }
+
+			// Rings of the geometry at idx (polygons: exterior ring first)
+			size_t rings_count(size_t idx) const { return geometry_rings[idx + 1] - geometry_rings[idx]; }
+
+			std::span<const Boost_Point_2> ring(size_t idx, size_t ring_idx) const {
+				size_t c_ring = geometry_rings[idx] + ring_idx;
+				return std::span<const Boost_Point_2>(points + ring_points[c_ring], points + ring_points[c_ring + 1]);
+			}
+
+			Boost_Box_2 envelope(size_t idx) const {
+				const double* c_envelope = envelopes + 4 * idx;
+				return Boost_Box_2({ c_envelope[0], c_envelope[1] }, { c_envelope[2], c_envelope[3] });
+			}
+
+			// Copy of the geometry at idx (each ring allocated once)
+			geom_type geometry(size_t idx) const {
+				geom_type out_geometry;
+				if constexpr (std::is_same_v<geom_type, Boost_Point_2>)
+					out_geometry = ring(idx, 0)[0];
+				else if constexpr (std::is_same_v<geom_type, Boost_LineString_2>) {
+					auto c_points = ring(idx, 0);
+					out_geometry.assign(c_points.begin(), c_points.end());
+				}
+				else {
+					size_t c_rings_count = rings_count(idx);
+					if (c_rings_count == 0)
+						return out_geometry;
+					auto c_points = ring(idx, 0);
+					out_geometry.outer().assign(c_points.begin(), c_points.end());
+					out_geometry.inners().resize(c_rings_count - 1);
+					for (size_t ring_idx = 1; ring_idx < c_rings_count; ring_idx++) {
+						c_points = ring(idx, ring_idx);
+						out_geometry.inners()[ring_idx - 1].assign(c_points.begin(), c_points.end());
+					}
+				}
+				return out_geometry;
+			}
+
+			size_t fields_count() const { return header->fields_count; }
+
+			std::string_view field_name(field_id fid) const { return std::string_view(section<char>(fields[fid].name_offset, fields[fid].name_size), fields[fid].name_size); }
+
+			AttributeType field_type(field_id fid) const { return static_cast<AttributeType>(fields[fid].type); }
+
+			bool is_null(size_t idx, field_id fid) const {
+				return (validity_bitmap(fid)[idx / 64] & (uint64_t(1) << (idx % 64))) == 0;
+			}
+
+			// Columns in place (values of null rows are unspecified)
+			std::span<const int64_t> int_column(field_id fid) const { return { section<int64_t>(checked_field(fid, AttributeType::int64).values_offset, length()), length() }; }
+			std::span<const double> double_column(field_id fid) const { return { section<double>(checked_field(fid, AttributeType::real).values_offset, length()), length() }; }
+			std::span<const uint32_t> string_codes_column(field_id fid) const { return { section<uint32_t>(checked_field(fid, AttributeType::string).values_offset, length()), length() }; }
+
+			std::string_view dictionary_string(field_id fid, uint32_t code) const {
+				const auto& c_field = checked_field(fid, AttributeType::string);
+				const uint64_t* string_offsets = section<uint64_t>(c_field.dictionary_offsets_offset, c_field.dictionary_count + 1);
+				const char* string_bytes = section<char>(c_field.dictionary_bytes_offset, string_offsets[c_field.dictionary_count]);
+				return std::string_view(string_bytes + string_offsets[code], string_offsets[code + 1] - string_offsets[code]);
+			}
+
+			std::span<const uint64_t> validity_bitmap(field_id fid) const {
+				size_t words_count = (length() + 63) / 64;
+				return { section<uint64_t>(fields[fid].validity_offset, words_count), words_count };
+			}
+
+			// Copies the attribute columns into a new table (rows are the geometries indices)
+			std::shared_ptr<AttributeTable> load_attributes() const {
+				auto table = std::make_shared<AttributeTable>();
+				table->add_rows(length());
+				for (field_id c_field = 0; c_field < fields_count(); c_field++) {
+					field_id fid = table->add_field(std::string(field_name(c_field)), field_type(c_field));
+					const uint64_t* valid_bits = validity_bitmap(c_field).data();
+					switch (field_type(c_field)) {
+					case AttributeType::int64:
+						table->assign_int_column(fid, int_column(c_field).data(), valid_bits);
+						break;
+					case AttributeType::real:
+						table->assign_double_column(fid, double_column(c_field).data(), valid_bits);
+						break;
+					case AttributeType::string: {
+						std::vector<std::string> dictionary(fields[c_field].dictionary_count);
+						for (uint32_t code = 0; code < dictionary.size(); code++)
+							dictionary[code] = std::string(dictionary_string(c_field, code));
+						table->assign_string_column(fid, string_codes_column(c_field).data(), std::move(dictionary), valid_bits);
+						break;
+					}
+					}
+				}
+				return table;
+			}
+
+		private:
+			// Pointer to count elements at offset, checked against the file size
+			template <typename T>
+			const T* section(uint64_t offset, uint64_t count) const {
+				if (offset > mapped_file->size() || count > (mapped_file->size() - offset) / std::max<size_t>(sizeof(T), 1))
+					throw std::runtime_error("Truncated GeoVector cache file!");
+				return reinterpret_cast<const T*>(mapped_file->data() + offset);
+			}
+
+			const geovector_cache::FieldHeader& checked_field(field_id fid, AttributeType type) const {
+				if (fid >= fields_count() || field_type(fid) != type)
+					throw std::runtime_error("Attribute field id does not match the requested type!");
+				return fields[fid];
+			}
+
+		private:
+			std::shared_ptr<geovector_cache::MappedFile> mapped_file;
+			const geovector_cache::FileHeader* header;
+			const uint64_t* geometry_rings;
+			const uint64_t* ring_points;
+			const Boost_Point_2* points;
+			const double* envelopes;
+			const geovector_cache::FieldHeader* fields;
+			std::string_view crs;
+		};
+
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include "defs.h"
+#include "lightweight/geovector.h"
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+		/**
+		Pull based reader of a vector layer: features are loaded by chunks of chunk_size features into GeoVectors,
+		only the current chunk is held in memory. Geometries and attributes are the same as GeoVector::from_file with the same
+		spatial filter and fields lists. Chunks may hold less than chunk_size geometries (invalid or filtered features).
+		*/
+		template <typename geom_type, typename rtree_parameters = bgi::quadratic<16>>
+		class GeoVectorStream {
+
+		public:
+			using chunk_type = GeoVector<geom_type, rtree_parameters>;
+
+			GeoVectorStream(const std::string& in_file, size_t _chunk_size = 10000, std::string layer_name = "", const Boost_Polygon_2& _spatial_filter = Boost_Polygon_2(),
+				const std::unordered_set<std::string>& included_fields = {}, const std::unordered_set<std::string>& excluded_fields = {}, const std::unordered_map<std::string, std::string>& _field_rename = {}) :
+				chunk_size(_chunk_size), spatial_filter(_spatial_filter) {
+
+				assert(included_fields.empty() | excluded_fields.empty() && "Both inculde and exclude fields are provided!");
+				assert(chunk_size > 0 && "Chunk size must be positive!");
+
+				vector_dataset = load_gdal_vector_dataset_shared_ptr(in_file);
+				crs_wkt = VProfile::from_gdal_dataset(vector_dataset).s_crs_wkt;
+				layer = chunk_type::get_layer_to_load(vector_dataset.get(), layer_name, in_file);
+				OGRPolygon spatial_filter_ogr = transform_B2OGR_Polygon(spatial_filter);
+				if (!spatial_filter_ogr.IsEmpty())
+					layer->SetSpatialFilter(&spatial_filter_ogr);
+				chunk_type::resolve_fields_to_load(layer, included_fields, excluded_fields, _field_rename, to_load_fields, field_rename);
+				layer->ResetReading();
+			}
+
+			/**
+			Loads the next non empty chunk into chunk (previous content is discarded).
+			Returns false once the layer is exhausted.
+			*/
+			bool next_chunk(chunk_type& chunk) {
+				chunk = chunk_type();
+				chunk.crs_wkt = crs_wkt;
+				chunk.geometries_container.reserve(chunk_size);
+				while (!exhausted && chunk.geometries_container.empty()) {
+					GIntBig read_count = chunk_type::load_layer_features(layer, chunk, spatial_filter, to_load_fields, field_rename, chunk_size);
+					exhausted = read_count < GIntBig(chunk_size);
+				}
+				if (chunk.geometries_container.empty())
+					return false;
+				if (index_chunks)
+					chunk.init_rtree();
+				return true;
+			}
+
+			// Calls chunk_fn(chunk) for each remaining chunk
+			template <typename chunk_fn_type>
+				requires std::invocable<chunk_fn_type&, chunk_type&>
+			void for_each_chunk(chunk_fn_type&& chunk_fn) {
+				chunk_type chunk;
+				while (next_chunk(chunk))
+					chunk_fn(chunk);
+			}
+
+			// Restarts reading from the first feature
+			void reset() {
+				layer->ResetReading();
+				exhausted = false;
+			}
+
+			// Features count of the layer (with the spatial filter applied by the driver)
+			GIntBig features_count() const { return layer->GetFeatureCount(); }
+
+			const std::string& get_crs_wkt() const { return crs_wkt; }
+
+		public:
+			size_t chunk_size;
+			bool index_chunks = true; // builds the rtree of each chunk (not needed for per feature processing)
+
+		private:
+			std::shared_ptr<GDALDataset> vector_dataset;
+			OGRLayer* layer;
+			std::string crs_wkt;
+			Boost_Polygon_2 spatial_filter;
+			std::unordered_set<std::string> to_load_fields;
+			std::unordered_map<std::string, std::string> field_rename;
+			bool exhausted = false;
+		};
+
+		/**
+		Streaming transform_geovector / unpool_geovector: each input chunk is transformed into an output GeoVector handed to
+		out_chunk_fn (e.g. to_dataset with WriteMode::update) before the next chunk is read.
+		*/
+		template <typename in_geom_type, typename out_geom_type>
+		void transform_geovector(GeoVectorStream<in_geom_type>& in_stream,
+			const std::function<Geometries_with_attributes<out_geom_type>(const Geometries_with_attributes<in_geom_type>&)>& transformer_fn,
+			const std::function<void(GeoVector<out_geom_type>&)>& out_chunk_fn) {
+			in_stream.for_each_chunk([&](GeoVector<in_geom_type>& in_chunk) {
+				GeoVector<out_geom_type> out_chunk;
+				out_chunk.crs_wkt = in_chunk.crs_wkt;
+				transform_geovector(in_chunk, out_chunk, transformer_fn);
+				out_chunk_fn(out_chunk);
+				});
+		}
+
+		template <typename in_geom_type, typename out_geom_type>
+		void unpool_geovector(GeoVectorStream<in_geom_type>& in_stream,
+			const std::function<std::list<Geometries_with_attributes<out_geom_type>>(const Geometries_with_attributes<in_geom_type>&)>& transformer_fn,
+			const std::function<void(GeoVector<out_geom_type>&)>& out_chunk_fn) {
+			in_stream.for_each_chunk([&](GeoVector<in_geom_type>& in_chunk) {
+				GeoVector<out_geom_type> out_chunk;
+				unpool_geovector(in_chunk, out_chunk, transformer_fn);
+				out_chunk_fn(out_chunk);
+				});
+		}
+
+	}
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include "defs.h"
+#include "lightweight/geovector.h"
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+		/**
+		A lightweight subset of a GeoVector: a reference to the parent and the indices of the selected geometries.
+		Spatial views query the parent rtree, nothing is copied. Copies are made on demand (to_geovector).
+		The parent must outlive the view and must not be edited while the view is used.
+		*/
+		template <typename geom_type, typename rtree_parameters = bgi::quadratic<16>>
+		struct GeoVectorView {
+
+			using parent_type = GeoVector<geom_type, rtree_parameters>;
+			using Boost_Value = typename parent_type::Boost_Value;
+
+			class const_iterator {
+			public:
+				using iterator_category = std::forward_iterator_tag;
+				using value_type = Geometries_with_attributes<geom_type>;
+				using difference_type = std::ptrdiff_t;
+				using pointer = const value_type*;
+				using reference = const value_type&;
+
+				const_iterator() {};
+				const_iterator(const GeoVectorView* _view, size_t _position) : view(_view), position(_position) {};
+
+				reference operator*() const { return view->at(position); }
+				pointer operator->() const { return &view->at(position); }
+				const_iterator& operator++() { position++; return *this; }
+				const_iterator operator++(int) { const_iterator previous = *this; position++; return previous; }
+				bool operator==(const const_iterator& other) const { return view == other.view && position == other.position; }
+				bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+			private:
+				const GeoVectorView* view = nullptr;
+				size_t position = 0;
+			};
+
+		public:
+			GeoVectorView(const parent_type& _parent, std::vector<size_t> _indices) : parent(&_parent), indices(std::move(_indices)) {};
+
+			/**
+			View of the parent geometries intersecting spatial_envelope (parent order).
+			*/
+			GeoVectorView(const parent_type& _parent, const Boost_Box_2& spatial_envelope) : parent(&_parent) {
+				std::vector<Boost_Value> candidates;
+				parent->rtree.query(bgi::intersects(spatial_envelope), std::back_inserter(candidates));
+				indices.reserve(candidates.size());
+				for (auto& c_candidate : candidates) {
+					if (bg::intersects(spatial_envelope, parent->geometries_container[c_candidate.second].get_definition()))
+						indices.push_back(c_candidate.second);
+				}
+				std::sort(indices.begin(), indices.end());
+			}
+
+			GeoVectorView(const parent_type& _parent, const OGREnvelope& spatial_envelope) :
+				GeoVectorView(_parent, Boost_Box_2({ spatial_envelope.MinX, spatial_envelope.MinY }, { spatial_envelope.MaxX, spatial_envelope.MaxY })) {};
+
+			size_t length() const { return indices.size(); }
+
+			const geom_type& operator[](int offset) const { return at(offset).get_definition(); }
+
+			const Geometries_with_attributes<geom_type>& at(size_t offset) const { return parent->geometries_container[indices[offset]]; }
+
+			// Index of the view geometry at offset in the parent
+			size_t parent_index(size_t offset) const { return indices[offset]; }
+
+			const std::vector<size_t>& parent_indices() const { return indices; }
+
+			const parent_type& get_parent() const { return *parent; }
+
+			const std::string& crs_wkt() const { return parent->crs_wkt; }
+
+			const_iterator begin() const { return const_iterator(this, 0); }
+
+			const_iterator end() const { return const_iterator(this, indices.size()); }
+
+			/**
+			Copies the selected geometries (with attributes) into a new indexed GeoVector.
+			*/
+			parent_type to_geovector() const {
+				parent_type out_geovector;
+				out_geovector.crs_wkt = parent->crs_wkt;
+				out_geovector.geometries_container.reserve(indices.size());
+				for (size_t c_idx : indices)
+					out_geovector.geometries_container.push_back(parent->geometries_container[c_idx]);
+				out_geovector.compact_attributes();
+				out_geovector.init_rtree();
+				return out_geovector;
+			}
+
+			void to_dataset(
+				GDALDataset* vector_dataset, WriteMode wm, std::string out_layer_name = "",
+				const std::function<bool(const Geometries_with_attributes<geom_type>&)>& filter_fn = [](const Geometries_with_attributes<geom_type>& _) {return true; },
+				size_t transaction_batch_size = DEFAULT_TRANSACTION_BATCH_SIZE
+			) const {
+
+				OGRLayer* out_layer;
+				if (out_layer_name.empty())
+					out_layer = vector_dataset->GetLayer(0);
+				else
+					out_layer = vector_dataset->GetLayerByName(out_layer_name.c_str());
+
+				GeometriesLayerWriter<geom_type> layer_writer(vector_dataset, out_layer, wm, parent_type::ID_FIELD_NAME, transaction_batch_size);
+				for (const auto& gwa : *this) {
+					if (filter_fn(gwa))
+						layer_writer.write(gwa);
+				}
+				layer_writer.finish();
+				out_layer->SyncToDisk();
+			}
+
+		private:
+			const parent_type* parent;
+			std::vector<size_t> indices;
+		};
+
+	}
+}
@@ -4,6 +4,7 @@
 #include "defs_boost.h"
 #include "export_io_data.h"
 #include "GDAL_OPENCV_IO.h"
+#include "gdal_dataset_pool.h"
 
 
 namespace LxGeo
@@ -47,6 +48,7 @@ namespace LxGeo
 			GDALDataType dtype;
 			std::string s_crs_wkt;
 			std::optional<double> no_data;
+			int block_width = 0, block_height = 0; // natural block size of the source dataset (0 when unknown)
 
 			RProfile() {};
 
@@ -66,6 +68,8 @@ namespace LxGeo
 				memcpy(geotransform, ref_profile.geotransform, sizeof(double) * 6);
 				s_crs_wkt = std::string(ref_profile.s_crs_wkt);
 				no_data = ref_profile.no_data;
+				block_width = ref_profile.block_width;
+				block_height = ref_profile.block_height;
 			};
 
 			~RProfile() {}
@@ -74,6 +78,8 @@ namespace LxGeo
 			double gsd() const { return abs(geotransform[1]); }
 
 			std::shared_ptr<GDALDataset> to_gdal_dataset(std::string fp) {
+				// pooled handles on a previous file at the same path are stale
+				GDALDatasetPool::instance().evict(fp);
 				GDALDriver* driver = GetGDALDriverManager()->GetDriverByName(driver_name.c_str());
 				GDALDataset* new_dataset = driver->Create(fp.c_str(), width, height, count, dtype, NULL);
 				if (new_dataset == NULL) {
@@ -113,11 +119,13 @@ namespace LxGeo
 				double nodata_value = gdal_dataset->GetRasterBand(1)->GetNoDataValue(&raster_has_nodata);
 				std::optional<double> nodata; if (raster_has_nodata) nodata= nodata_value;
 				GDALDataType raster_data_type = gdal_dataset->GetRasterBand(1)->GetRasterDataType();
-				return RProfile(width, height, band_count, geotransform, raster_data_type, crs_wkt, driver_name, nodata);
+				RProfile out_profile(width, height, band_count, geotransform, raster_data_type, crs_wkt, driver_name, nodata);
+				gdal_dataset->GetRasterBand(1)->GetBlockSize(&out_profile.block_width, &out_profile.block_height);
+				return out_profile;
 			}
 
 			static RProfile from_file(std::string file_path) {
-				auto gdal_dataset = load_gdal_dataset_shared_ptr(file_path);
+				auto gdal_dataset = GDALDatasetPool::instance().acquire(file_path);
 				return RProfile::from_gdal_dataset(gdal_dataset);
 			}
 
@@ -1,6 +1,7 @@
 #pragma once
 #include "defs.h"
 #include "defs_common.h"
+#include "gdal_dataset_pool.h"
 
 
 
@@ -99,6 +100,8 @@ namespace LxGeo
 				layers_def(_copy_vprofile.layers_def), driver_name(_copy_vprofile.driver_name), s_crs_wkt(_copy_vprofile.s_crs_wkt) {}
 
 			std::shared_ptr<GDALDataset> to_gdal_dataset(std::string fp) {
+				// pooled handles on a previous file at the same path are stale
+				GDALDatasetPool::instance().evict(fp);
 				GDALDriver* driver = GetGDALDriverManager()->GetDriverByName(driver_name.c_str());
 				GDALDataset* new_dataset = driver->Create(fp.c_str(), 0, 0, 0, GDT_Unknown, NULL);
 				if (new_dataset == NULL) {
@@ -0,0 +1,79 @@
+#pragma once
+#include "defs.h"
+#include <gdal_priv.h>
+#include <opencv2/core/core.hpp>
+#include "export_io_data.h"
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+
+		enum class BlendingWindow {
+			constant, // plain average of the overlapping patches
+			feathered, // weights ramp linearly from the patch borders
+			cosine // weights ramp following a raised cosine from the patch borders
+		};
+
+		struct MosaicBlendingOptions {
+			BlendingWindow window = BlendingWindow::feathered;
+			int ramp_size = 0; // pixels over which weights ramp up from the patch borders (usually the patch overlap), 0: half of the patch
+		};
+
+		/**
+		* Streaming mosaic of overlapping patches written to a GDAL dataset.
+		* Each pixel is the weighted mean of the patches covering it, the weights being given by the blending window.
+		* Weighted sums and weights are only kept for the active rows band: patches must be added by non decreasing
+		* row_start (see PatchOrdering::row_major), rows above the last added patch are then final and are written.
+		* Thus memory is bounded by patch height x raster width. Pixels covered by no patch keep the dataset content.
+		*/
+		class MosaicAccumulator {
+
+		public:
+			IO_DATA_API MosaicAccumulator(std::shared_ptr<GDALDataset> dataset, const MosaicBlendingOptions& options = MosaicBlendingOptions());
+			IO_DATA_API ~MosaicAccumulator();
+
+			MosaicAccumulator(const MosaicAccumulator&) = delete;
+			MosaicAccumulator& operator=(const MosaicAccumulator&) = delete;
+
+			/**
+			* Accumulates a patch whose top left pixel is (col_start, row_start) in the dataset.
+			* Throws when the patch touches rows already written.
+			*/
+			IO_DATA_API void add_patch(int col_start, int row_start, const cv::Mat& image);
+
+			/**
+			* Writes rows lower than row_end (no later patch may touch them).
+			*/
+			IO_DATA_API void flush_rows(int row_end);
+
+			/**
+			* Writes all remaining rows. Further patches throw.
+			*/
+			IO_DATA_API void finalize();
+
+		private:
+			const cv::Mat& patch_weights(int rows, int cols);
+			void ensure_band_capacity(int rows);
+			void write_band_rows(int rows_count);
+			void write_rows_before(int row_end);
+
+		private:
+			std::shared_ptr<GDALDataset> dataset;
+			MosaicBlendingOptions options;
+			int width, height, band_count;
+			int value_type; // cv type matching the dataset data type and bands count
+			GDALDataType buffer_type;
+
+			int band_row_start; // first dataset row not written yet
+			int band_rows; // rows of the band holding accumulated values
+			cv::Mat sums; // CV_32F weighted sums, row 0 is band_row_start
+			cv::Mat weights; // CV_32FC1 weights sums
+			std::map<std::pair<int, int>, cv::Mat> weights_cache; // patch weights by (rows, cols)
+			std::mutex mtx;
+			bool finalized;
+		};
+
+	}
+}
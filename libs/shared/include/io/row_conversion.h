@@ -0,0 +1,214 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <gdal_priv.h>
+#include "export_io_data.h"
+
+#if defined(__AVX2__)
+#define LX_GEO_ROW_CONVERSION_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LX_GEO_ROW_CONVERSION_SSE2
+#endif
+#if defined(LX_GEO_ROW_CONVERSION_SSE2) || defined(LX_GEO_ROW_CONVERSION_AVX2)
+#include <immintrin.h>
+#endif
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+
+		/**
+		* Whole row pixel conversion kernels replacing the per pixel KGDAL2CV::range_cast / write_pixel calls.
+		* Kernels are specialized per (source, destination) type pair at compile time and vectorized (SSE2 / AVX2)
+		* for the common contiguous conversions. Other pairs use the scalar kernel.
+		*/
+		namespace row_conversion
+		{
+
+			enum class RangeCastOp { identity, multiply, floor_divide };
+
+			// Compile time equivalent of KGDAL2CV::range_cast
+			template <typename src_t, typename dst_t>
+			struct range_cast_traits {
+				static constexpr RangeCastOp op = RangeCastOp::identity;
+				static constexpr double factor = 1.0;
+			};
+
+			template <> struct range_cast_traits<uint8_t, uint16_t> { static constexpr RangeCastOp op = RangeCastOp::multiply; static constexpr double factor = 256.0; };
+			template <> struct range_cast_traits<uint8_t, int16_t> { static constexpr RangeCastOp op = RangeCastOp::multiply; static constexpr double factor = 256.0; };
+			template <> struct range_cast_traits<uint8_t, int32_t> { static constexpr RangeCastOp op = RangeCastOp::multiply; static constexpr double factor = 16777216.0; };
+			template <> struct range_cast_traits<uint8_t, float> { static constexpr RangeCastOp op = RangeCastOp::multiply; static constexpr double factor = 16777216.0; };
+			template <> struct range_cast_traits<uint16_t, uint8_t> { static constexpr RangeCastOp op = RangeCastOp::floor_divide; static constexpr double factor = 256.0; };
+			template <> struct range_cast_traits<int16_t, uint8_t> { static constexpr RangeCastOp op = RangeCastOp::floor_divide; static constexpr double factor = 256.0; };
+
+			// Clamps to the destination range, integer destinations truncate toward zero as the static_cast of write_pixel
+			template <typename dst_t>
+			inline dst_t saturate(double value) {
+				if constexpr (std::is_integral_v<dst_t>) {
+					if (!(value > double(std::numeric_limits<dst_t>::min()))) return std::numeric_limits<dst_t>::min();
+					if (value >= double(std::numeric_limits<dst_t>::max())) return std::numeric_limits<dst_t>::max();
+					return static_cast<dst_t>(value);
+				}
+				else
+					return static_cast<dst_t>(value);
+			}
+
+			template <typename src_t, typename dst_t>
+			inline void convert_row_scalar(const src_t* src, dst_t* dst, size_t n, size_t dst_stride) {
+				typedef range_cast_traits<src_t, dst_t> traits;
+				if constexpr (std::is_same_v<src_t, dst_t> && traits::op == RangeCastOp::identity) {
+					if (dst_stride == 1) {
+						std::memcpy(dst, src, n * sizeof(src_t));
+						return;
+					}
+				}
+				for (size_t i = 0; i < n; ++i) {
+					double value = static_cast<double>(src[i]);
+					if constexpr (traits::op == RangeCastOp::multiply)
+						value *= traits::factor;
+					else if constexpr (traits::op == RangeCastOp::floor_divide)
+						value = std::floor(value / traits::factor);
+					dst[i * dst_stride] = saturate<dst_t>(value);
+				}
+			}
+
+			// Vectorized prefix of a contiguous row, returns the number of converted pixels
+			template <typename src_t, typename dst_t>
+			inline size_t convert_row_simd(const src_t* src, dst_t* dst, size_t n) {
+				size_t i = 0;
+#if defined(LX_GEO_ROW_CONVERSION_AVX2)
+				if constexpr (std::is_same_v<src_t, uint8_t> && std::is_same_v<dst_t, uint16_t>) {
+					for (; i + 16 <= n; i += 16) {
+						__m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_slli_epi16(v, 8));
+					}
+				}
+				else if constexpr (std::is_same_v<src_t, uint16_t> && std::is_same_v<dst_t, uint8_t>) {
+					for (; i + 32 <= n; i += 32) {
+						__m256i a = _mm256_srli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), 8);
+						__m256i b = _mm256_srli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 16)), 8);
+						// packus works on 128 bits lanes
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+					}
+				}
+				else if constexpr (std::is_same_v<src_t, int16_t> && std::is_same_v<dst_t, uint8_t>) {
+					for (; i + 32 <= n; i += 32) {
+						__m256i a = _mm256_srai_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), 8);
+						__m256i b = _mm256_srai_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 16)), 8);
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+					}
+				}
+				else if constexpr (std::is_same_v<src_t, uint8_t> && std::is_same_v<dst_t, float>) {
+					const __m256 factor = _mm256_set1_ps(16777216.0f);
+					for (; i + 8 <= n; i += 8) {
+						__m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+						_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), factor));
+					}
+				}
+				else if constexpr ((std::is_same_v<src_t, uint16_t> || std::is_same_v<src_t, int16_t>) && std::is_same_v<dst_t, float>) {
+					for (; i + 8 <= n; i += 8) {
+						__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+						__m256i w = std::is_same_v<src_t, uint16_t> ? _mm256_cvtepu16_epi32(v) : _mm256_cvtepi16_epi32(v);
+						_mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(w));
+					}
+				}
+				else if constexpr (std::is_same_v<src_t, float> && std::is_same_v<dst_t, double>) {
+					for (; i + 4 <= n; i += 4)
+						_mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+				}
+				else if constexpr (std::is_same_v<src_t, double> && std::is_same_v<dst_t, float>) {
+					for (; i + 4 <= n; i += 4)
+						_mm_storeu_ps(dst + i, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i)));
+				}
+#elif defined(LX_GEO_ROW_CONVERSION_SSE2)
+				const __m128i zero = _mm_setzero_si128();
+				if constexpr (std::is_same_v<src_t, uint8_t> && std::is_same_v<dst_t, uint16_t>) {
+					for (; i + 16 <= n; i += 16) {
+						__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi8(zero, v));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), _mm_unpackhi_epi8(zero, v));
+					}
+				}
+				else if constexpr (std::is_same_v<src_t, uint16_t> && std::is_same_v<dst_t, uint8_t>) {
+					for (; i + 16 <= n; i += 16) {
+						__m128i a = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), 8);
+						__m128i b = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)), 8);
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+					}
+				}
+				else if constexpr (std::is_same_v<src_t, int16_t> && std::is_same_v<dst_t, uint8_t>) {
+					for (; i + 16 <= n; i += 16) {
+						__m128i a = _mm_srai_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), 8);
+						__m128i b = _mm_srai_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)), 8);
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+					}
+				}
+				else if constexpr (std::is_same_v<src_t, uint8_t> && std::is_same_v<dst_t, float>) {
+					const __m128 factor = _mm_set1_ps(16777216.0f);
+					for (; i + 16 <= n; i += 16) {
+						__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+						__m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+						_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), factor));
+						_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), factor));
+						_mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), factor));
+						_mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), factor));
+					}
+				}
+				else if constexpr (std::is_same_v<src_t, uint16_t> && std::is_same_v<dst_t, float>) {
+					for (; i + 8 <= n; i += 8) {
+						__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+						_mm_storeu_ps(dst + i, _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)));
+						_mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)));
+					}
+				}
+				else if constexpr (std::is_same_v<src_t, int16_t> && std::is_same_v<dst_t, float>) {
+					for (; i + 8 <= n; i += 8) {
+						__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+						// sign extension: duplicate into the high half then arithmetic shift
+						_mm_storeu_ps(dst + i, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)));
+						_mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)));
+					}
+				}
+				else if constexpr (std::is_same_v<src_t, float> && std::is_same_v<dst_t, double>) {
+					for (; i + 4 <= n; i += 4) {
+						__m128 v = _mm_loadu_ps(src + i);
+						_mm_storeu_pd(dst + i, _mm_cvtps_pd(v));
+						_mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+					}
+				}
+				else if constexpr (std::is_same_v<src_t, double> && std::is_same_v<dst_t, float>) {
+					for (; i + 4 <= n; i += 4)
+						_mm_storeu_ps(dst + i, _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(src + i)), _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2))));
+				}
+#endif
+				return i;
+			}
+
+			/**
+			* Converts n pixels from src to dst applying range_cast, dst being written every dst_stride elements
+			* (dst_stride = channels count to fill one channel of an interleaved row).
+			*/
+			template <typename src_t, typename dst_t>
+			inline void convert_row(const src_t* src, dst_t* dst, size_t n, size_t dst_stride = 1) {
+				size_t done = 0;
+				if (dst_stride == 1)
+					done = convert_row_simd<src_t, dst_t>(src, dst, n);
+				convert_row_scalar<src_t, dst_t>(src + done, dst + done * dst_stride, n - done, dst_stride);
+			}
+
+			/**
+			* Runtime dispatch of convert_row on a GDAL source type and an OpenCV destination depth (done once per row).
+			* Returns false for unsupported types.
+			*/
+			IO_DATA_API bool convert_row(GDALDataType src_type, const void* src, int dst_depth, void* dst, size_t n, size_t dst_stride = 1);
+
+		}
+	}
+}
@@ -5,6 +5,9 @@
 #include "stitchable_geometries/def_stitched_geoms.h"
 #include "stitchable_geometries/stitching_options.h"
 #include "design_pattern/extended_iterators.h"
+#include "design_pattern/parallel_for.h"
+#include "data_structures/support_points.h"
+#include <atomic>
 
 namespace LxGeo
 {
@@ -55,32 +58,62 @@ namespace LxGeo
 				}*/
 			};
 
-			void read_unique(Elementary_Pinned_Pixels_Boost_Point_2<values_type>& p) {
+			void read_unique(Elementary_Pinned_Pixels_Boost_Point_2<values_type>& p) { read_unique(p, p.pinned_pixel); }
+			void read_spatial_buffered(Elementary_Pinned_Pixels_Boost_Point_2<values_type>& p) { read_spatial_buffered(p, p.pinned_pixel); }
+			void read_pixel_buffered(Elementary_Pinned_Pixels_Boost_Point_2<values_type>& p) { read_pixel_buffered(p, p.pinned_pixel); }
+
+			/*Reads below only read the raster and append to out_pixels (safe to call concurrently for distinct buffers)*/
+			void read_unique(const Boost_Point_2& p, PinnedPixels<values_type>& out_pixels) {
 				cv::Point pt_pixel_coord;
 				rps.ref_raster.get_pixel_coords(p, pt_pixel_coord);
-				p.pinned_pixel.push_back(rps.safe_pixel_read<values_type>(pt_pixel_coord));
+				out_pixels.push_back(rps.safe_pixel_read(pt_pixel_coord));
 			}
 
-			void read_spatial_buffered(Elementary_Pinned_Pixels_Boost_Point_2<values_type>& p) {
-				cv::Point min_pixel_corner, max_pixel_corner;
-				rps.ref_raster.get_pixel_coords(p - options.spa_left_up_pt, min_pixel_corner);
-				rps.ref_raster.get_pixel_coords(p + options.spa_right_down_pt, max_pixel_corner);
-				p.pinned_pixel.splice(p.pinned_pixel.end(), rps.readBoxPixels(min_pixel_corner.x, min_pixel_corner.y, max_pixel_corner.x, max_pixel_corner.y));
+			void read_spatial_buffered(const Boost_Point_2& p, PinnedPixels<values_type>& out_pixels) {
+				// spatial corners are converted separately (rows may grow northward or southward)
+				cv::Point left_up_pixel_corner, right_down_pixel_corner;
+				rps.ref_raster.get_pixel_coords(Boost_Point_2(p.get<0>() - options.spa_left_up_pt.get<0>(), p.get<1>() + options.spa_left_up_pt.get<1>()), left_up_pixel_corner);
+				rps.ref_raster.get_pixel_coords(Boost_Point_2(p.get<0>() + options.spa_right_down_pt.get<0>(), p.get<1>() - options.spa_right_down_pt.get<1>()), right_down_pixel_corner);
+				rps.readBoxPixels(
+					std::min(left_up_pixel_corner.x, right_down_pixel_corner.x), std::min(left_up_pixel_corner.y, right_down_pixel_corner.y),
+					std::max(left_up_pixel_corner.x, right_down_pixel_corner.x), std::max(left_up_pixel_corner.y, right_down_pixel_corner.y),
+					out_pixels
+				);
 			}
 
-			void read_pixel_buffered(Elementary_Pinned_Pixels_Boost_Point_2<values_type>& p) {
-				cv::Point min_pixel_corner, max_pixel_corner;
-				rps.ref_raster.get_pixel_coords(p, min_pixel_corner);
-				rps.ref_raster.get_pixel_coords(p, max_pixel_corner);
-				p.pinned_pixel.splice(p.pinned_pixel.end(),
-					rps.readBoxPixels(
-						min_pixel_corner.x - options.pix_left_up_pt.get<0>(), min_pixel_corner.y - options.pix_left_up_pt.get<1>(),
-						max_pixel_corner.x + options.pix_right_down_pt.get<0>(), max_pixel_corner.y + options.pix_right_down_pt.get<1>()
-					)
+			void read_pixel_buffered(const Boost_Point_2& p, PinnedPixels<values_type>& out_pixels) {
+				cv::Point pt_pixel_coord;
+				rps.ref_raster.get_pixel_coords(p, pt_pixel_coord);
+				rps.readBoxPixels(
+					pt_pixel_coord.x - options.pix_left_up_pt.get<0>(), pt_pixel_coord.y - options.pix_left_up_pt.get<1>(),
+					pt_pixel_coord.x + options.pix_right_down_pt.get<0>(), pt_pixel_coord.y + options.pix_right_down_pt.get<1>(),
+					out_pixels
 				);
 			}
 
-			std::list<values_type> readCornerPixels(const Inexact_Point_2& p_before, const Inexact_Point_2& p_mid, const Inexact_Point_2& p_after, bool CCW, const ElementaryStitchOptions& options) {
+			// Reads the pixels of a ring vertex following options.strategy (neighbour vertices are used by the corner area)
+			void read_vertex(const Boost_Point_2& p_mid, const Boost_Point_2& p_before, const Boost_Point_2& p_after, bool CCW, PinnedPixels<values_type>& out_pixels) {
+				switch (options.strategy) {
+				case ElementaryStitchStrategy::unique:
+					read_unique(p_mid, out_pixels);
+					break;
+				case ElementaryStitchStrategy::spatial_buffered:
+					read_spatial_buffered(p_mid, out_pixels);
+					break;
+				case ElementaryStitchStrategy::pixel_buffered:
+					read_pixel_buffered(p_mid, out_pixels);
+					break;
+				case ElementaryStitchStrategy::spatial_corner_area:
+					readCornerPixels(transform_B2C_Point(p_before), transform_B2C_Point(p_mid), transform_B2C_Point(p_after), CCW, options, out_pixels);
+					break;
+				default:
+					throw std::runtime_error("Choose strategy from ElementaryStitchOptions!");
+				}
+			}
+
+			// Appends the pixels of the corner area to out_pixels
+			void readCornerPixels(const Inexact_Point_2& p_before, const Inexact_Point_2& p_mid, const Inexact_Point_2& p_after, bool CCW, const ElementaryStitchOptions& options,
+				PinnedPixels<values_type>& out_pixels) {
 
 				bool is_outer_angle = CGAL::left_turn(p_before, p_mid, p_after);
 				if (!CCW) is_outer_angle = !is_outer_angle;
@@ -115,18 +148,19 @@ namespace LxGeo
 				//std::cout << std::setprecision(12) << bg::wkt(corner_polygon) << std::endl;
 
 				rps.readStructrualPixels(corner_polygon);
-				return corner_polygon.outer_pinned_pixel;
+				out_pixels.append(corner_polygon.outer_pinned_pixel.view());
 			}
 
 			void readCornerPixels(Elementary_Pinned_Pixels_Boost_Point_2<values_type>& p_mid,
 				const Boost_Point_2& p_before, const Boost_Point_2& p_after, bool CCW,
 				const ElementaryStitchOptions& options) {
-				p_mid.pinned_pixel.splice(p_mid.pinned_pixel.end(), readCornerPixels(
+				readCornerPixels(
 					transform_B2C_Point(p_before),
 					transform_B2C_Point(p_mid),
 					transform_B2C_Point(p_after),
 					CCW,
-					options)
+					options,
+					p_mid.pinned_pixel
 				);
 			}
 
@@ -152,6 +186,13 @@ namespace LxGeo
 		};
 
 
+		template <typename values_type>
+		struct ElementaryPixelsSlots {
+			SupportPoints support_points;
+			// pixels read for each support point (aligned with support_points.children)
+			std::vector<PinnedPixels<values_type>> slots;
+		};
+
 		template <typename values_type>
 		class RasterPixelsStitcher {
 
@@ -159,25 +200,25 @@ namespace LxGeo
 			RasterPixelsStitcher() {};
 			RasterPixelsStitcher(RasterIO& _ref_raster) { ref_raster = _ref_raster; };
 
-			/*Basic read operation*/
-			std::list<values_type> readBoxPixels(const Boost_Discrete_Box_2& box) {
-				return readBoxPixels<values_type>(
+			/*Basic read operation: appends pixels of the box (corners included) to out_pixels*/
+			void readBoxPixels(const Boost_Discrete_Box_2& box, PinnedPixels<values_type>& out_pixels) {
+				readBoxPixels(
 					box.min_corner().get<0>(), box.min_corner().get<1>(),
-					box.max_corner().get<0>(), box.max_corner().get<1>()
+					box.max_corner().get<0>(), box.max_corner().get<1>(),
+					out_pixels
 				);
 			}
 
-			std::list<values_type> readBoxPixels(int& min_x, int& min_y, int& max_x, int& max_y) {
-
-				std::list<values_type> out_list;
-
-				for (size_t c_col = min_x; c_col > max_x; c_col++) {
-					for (size_t c_row = min_y; c_row > max_y; c_row++) {
+			void readBoxPixels(int min_x, int min_y, int max_x, int max_y, PinnedPixels<values_type>& out_pixels) {
+				if (min_x > max_x || min_y > max_y)
+					return;
+				out_pixels.reserve(out_pixels.size() + size_t(max_x - min_x + 1) * size_t(max_y - min_y + 1));
+				for (int c_col = min_x; c_col <= max_x; c_col++) {
+					for (int c_row = min_y; c_row <= max_y; c_row++) {
 						cv::Point c_pt_pixel_coord(c_col, c_row);
-						out_list.push_back(safe_pixel_read<values_type>(c_pt_pixel_coord));
+						out_pixels.push_back(safe_pixel_read(c_pt_pixel_coord));
 					}
 				}
-				return out_list;
 			}
 
 			/*Nullable pixel read for out of bounds position*/
@@ -199,45 +240,112 @@ namespace LxGeo
 				boost::geometry::for_each_point(geometry_in, elementary_pixel_reader<values_type>(this, options));
 			}*/
 
-			/*** geometry aware elementary pixels read && can accept corner_area option***/
-			//template <typename values_type>
-			void readElementaryPixels(Elementary_Pinned_Pixels_Boost_Polygon_2<values_type>&c_polygon, const ElementaryStitchOptions & options) {
+			/*
+			Indices of the neighbours of vertex_idx in the closed ring [ring_begin, ring_end) of points (the closing vertex is excluded).
+			Returns false for the closing vertex itself.
+			*/
+			template <typename points_type>
+			static bool ring_neighbours(const points_type& points, size_t ring_begin, size_t ring_end, size_t vertex_idx, size_t& before_idx, size_t& after_idx) {
+				if (ring_end - ring_begin > 1 && bg::equals(points[ring_begin], points[ring_end - 1]))
+					ring_end--;
+				if (vertex_idx >= ring_end)
+					return false;
+				before_idx = vertex_idx == ring_begin ? ring_end - 1 : vertex_idx - 1;
+				after_idx = vertex_idx + 1 == ring_end ? ring_begin : vertex_idx + 1;
+				return true;
+			}
 
+			/*
+			Geometry aware elementary pixels read: each vertex of every ring reads its pixels (options.strategy) into its own buffer.
+			Outer ring is read with CCW=true and inner rings with CCW=false (same vertex read as the parallel overload below).
+			*/
+			void readElementaryPixels(Elementary_Pinned_Pixels_Boost_Polygon_2<values_type>&c_polygon, const ElementaryStitchOptions & options) {
 
 				elementary_pixel_reader<values_type> epr(*this, options);
 
-				auto ring_pts_geometry_aware_pixel_reader = [&](auto& c_ring, bool is_outer_ring=true)
+				auto ring_pts_geometry_aware_pixel_reader = [&](auto& c_ring, bool is_outer_ring)
 				{
-					// rings are closed so ignoring last element
-					auto& st = c_ring.begin();
-					auto& end = std::prev(c_ring.end());
-					circularIterator<Elementary_Pinned_Pixels_Boost_Point_2<values_type>, std::vector> circular_ring(st, end, c_ring.size()-1);
-					for (auto& mid_pt_iter = c_ring.begin(); mid_pt_iter != end; mid_pt_iter++) {
-						auto pts_window = circular_ring.getWindow(mid_pt_iter, 1, 1);
-						epr.readCornerPixels(pts_window[1], pts_window[0], pts_window[2], is_outer_ring, options);
+					size_t before_idx, after_idx;
+					for (size_t vertex_idx = 0; vertex_idx < c_ring.size(); vertex_idx++) {
+						if (ring_neighbours(c_ring, 0, c_ring.size(), vertex_idx, before_idx, after_idx))
+							epr.read_vertex(c_ring[vertex_idx], c_ring[before_idx], c_ring[after_idx], is_outer_ring, c_ring[vertex_idx].pinned_pixel);
 					}
 				};
 
-				ring_pts_geometry_aware_pixel_reader(c_polygon.outer());
-				for(size_t inner_ring_idx=0; inner_ring_idx<c_polygon.inners().size(); inner_ring_idx++)
-					ring_pts_geometry_aware_pixel_reader(c_polygon.inners()[inner_ring_idx], false);
+				ring_pts_geometry_aware_pixel_reader(c_polygon.outer(), true);
+				for (auto& c_inner_ring : c_polygon.inners())
+					ring_pts_geometry_aware_pixel_reader(c_inner_ring, false);
+
+			}
+
+			/*
+			Parallel elementary pixels read over the vertices of many polygons. Vertices of the outer ring then of the inner rings of
+			each polygon are listed as support points (parent: polygon index) and each vertex reads its pixels (options.strategy) into its
+			own preallocated slot, with the same orientation flag as the serial overload. Closing vertices keep an empty slot.
+			Blocks of vertices are pulled from a shared counter by n_threads threads (0: hardware concurrency). The raster is only read,
+			so slots do not depend on the threads count nor on the blocks order.
+			*/
+			ElementaryPixelsSlots<values_type> readElementaryPixels(std::vector<Boost_Polygon_2>& polygons, const ElementaryStitchOptions& options, size_t n_threads = 0) {
+
+				ElementaryPixelsSlots<values_type> out_slots{ SupportPoints(SupportPointsStrategy::vertex_only), {} };
+				std::vector<Boost_Point_2>& vertices = out_slots.support_points.children;
+				std::vector<size_t>& parents_indices = out_slots.support_points.parents_indices;
+
+				// vertices of ring r are [ring_offsets[r], ring_offsets[r + 1]), ring_is_outer[r] is its orientation flag
+				std::vector<size_t> ring_offsets = { 0 };
+				std::vector<char> ring_is_outer;
+				for (size_t polygon_idx = 0; polygon_idx < polygons.size(); polygon_idx++) {
+					auto append_ring = [&](const Boost_Ring_2& c_ring, bool is_outer_ring) {
+						vertices.insert(vertices.end(), c_ring.begin(), c_ring.end());
+						parents_indices.insert(parents_indices.end(), c_ring.size(), polygon_idx);
+						ring_offsets.push_back(vertices.size());
+						ring_is_outer.push_back(is_outer_ring);
+					};
+					append_ring(polygons[polygon_idx].outer(), true);
+					for (const Boost_Ring_2& c_inner_ring : polygons[polygon_idx].inners())
+						append_ring(c_inner_ring, false);
+				}
+				// same parent count convention as decompose_polygons
+				out_slots.support_points.parent_count = polygons.size() - 1;
+				out_slots.slots.resize(vertices.size());
+
+				elementary_pixel_reader<values_type> epr(*this, options);
+				const size_t block_size = 256;
+				size_t blocks_count = (vertices.size() + block_size - 1) / block_size;
+				std::atomic<size_t> next_block = 0;
+				size_t n_workers = n_threads == 0 ? default_threads_count() : n_threads;
+				parallel_for_chunks(std::min(n_workers, blocks_count), n_workers, [&](size_t, size_t) {
+					for (size_t c_block = next_block++; c_block < blocks_count; c_block = next_block++) {
+						size_t block_begin = c_block * block_size, block_end = std::min(vertices.size(), block_begin + block_size);
+						size_t ring_idx = std::upper_bound(ring_offsets.begin(), ring_offsets.end(), block_begin) - ring_offsets.begin() - 1;
+						size_t before_idx, after_idx;
+						for (size_t vertex_idx = block_begin; vertex_idx < block_end; vertex_idx++) {
+							while (vertex_idx >= ring_offsets[ring_idx + 1])
+								ring_idx++;
+							if (ring_neighbours(vertices, ring_offsets[ring_idx], ring_offsets[ring_idx + 1], vertex_idx, before_idx, after_idx))
+								epr.read_vertex(vertices[vertex_idx], vertices[before_idx], vertices[after_idx], ring_is_outer[ring_idx], out_slots.slots[vertex_idx]);
+						}
+					}
+					});
 
+				return out_slots;
 			}
 
 			/***Methods below read structural pixels values***/
 
-			/*Segment structural pixels read assigns a list of pixel values for the unique segment*/
+			/*Segment structural pixels read assigns a buffer of pixel values for the unique segment*/
 			void readStructrualPixels(Structural_Pinned_Pixels_Boost_Segment_2<values_type>&segment) {
 				cv::Point st_pt, end_pt;
 				ref_raster.get_pixel_coords(segment.first, st_pt);
 				ref_raster.get_pixel_coords(segment.second, end_pt);
 
 				cv::LineIterator it(ref_raster.raster_data, st_pt, end_pt, 8);
+				segment.pinned_pixel.reserve(segment.pinned_pixel.size() + it.count);
 				for (int i = 0; i < it.count; i++, ++it)
-					segment.pinned_pixel.push_back(safe_pixel_read<values_type>(it.pos()));
+					segment.pinned_pixel.push_back(safe_pixel_read(it.pos()));
 			}
 
-			/*Polygon structural pixels read assigns a list of pixel values for each constructing ring*/
+			/*Polygon structural pixels read assigns a buffer of pixel values for each constructing ring*/
 			void readStructrualPixels(Structural_Pinned_Pixels_Boost_Polygon_2<values_type>&c_polygon) {
 
 				// transform spatial polygon position to image discrete position
@@ -250,6 +358,7 @@ namespace LxGeo
 				boost::geometry::envelope(resp_polygon_pixel_coords, envelop);
 				Boost_Discrete_Point_2 min_pixel_corner = envelop.min_corner();
 				Boost_Discrete_Point_2 max_pixel_corner = envelop.max_corner();
+				c_polygon.inners_pinned_pixels.resize(resp_polygon_pixel_coords.inners().size());
 
 				for (size_t c_col = min_pixel_corner.get<0>(); c_col <= max_pixel_corner.get<0>(); c_col++) {
 					for (size_t c_row = min_pixel_corner.get<1>(); c_row <= max_pixel_corner.get<1>(); c_row++) {
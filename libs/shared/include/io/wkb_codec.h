@@ -0,0 +1,56 @@
+#pragma once
+#include "defs.h"
+#include "export_io_data.h"
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+
+		/**
+		* Conversion between WKB (ISO and extended, any byte order, Z / M coordinates are skipped) and Boost geometries
+		* without intermediate OGRGeometry objects. Each ring or linestring is allocated once with its final size.
+		* GeoPackage geometry blobs are decoded after their header is skipped (gpkg_blob_wkb).
+		*/
+		namespace wkb
+		{
+
+			/**
+			* Returns the WKB part of a GeoPackage geometry blob and its size in wkb_size,
+			* nullptr if blob is not a GeoPackage blob or holds an empty geometry.
+			*/
+			IO_DATA_API const unsigned char* gpkg_blob_wkb(const unsigned char* blob, size_t blob_size, size_t& wkb_size);
+
+			// Decoders return false for truncated blobs and other geometry types (multi geometries included)
+			IO_DATA_API bool decode(const unsigned char* data, size_t size, Boost_Point_2& out_point);
+			IO_DATA_API bool decode(const unsigned char* data, size_t size, Boost_LineString_2& out_linestring);
+			IO_DATA_API bool decode(const unsigned char* data, size_t size, Boost_Polygon_2& out_polygon);
+
+			// Exact encoded size of a geometry
+			IO_DATA_API size_t encoded_size(const Boost_Point_2& point);
+			IO_DATA_API size_t encoded_size(const Boost_LineString_2& linestring);
+			IO_DATA_API size_t encoded_size(const Boost_Polygon_2& polygon);
+
+			// Writes the little endian 2D WKB of a geometry to out_data (resized to the encoded size)
+			IO_DATA_API void encode(const Boost_Point_2& point, std::vector<unsigned char>& out_data);
+			IO_DATA_API void encode(const Boost_LineString_2& linestring, std::vector<unsigned char>& out_data);
+			IO_DATA_API void encode(const Boost_Polygon_2& polygon, std::vector<unsigned char>& out_data);
+
+			/**
+			* Builds the OGR geometry of a Boost geometry from its WKB (one copy per ring instead of point by point insertions).
+			* The caller owns the returned geometry (OGRFeature::SetGeometryDirectly).
+			*/
+			template <typename geom_type>
+			OGRGeometry* to_ogr_geometry(const geom_type& in_geometry) {
+				thread_local std::vector<unsigned char> wkb_buffer;
+				encode(in_geometry, wkb_buffer);
+				OGRGeometry* out_geometry = nullptr;
+				if (OGRGeometryFactory::createFromWkb(wkb_buffer.data(), nullptr, &out_geometry, wkb_buffer.size()) != OGRERR_NONE)
+					throw std::runtime_error("Error : couldn't convert geometry from WKB.");
+				return out_geometry;
+			}
+
+		}
+	}
+}
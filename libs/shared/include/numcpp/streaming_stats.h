@@ -0,0 +1,129 @@
+#pragma once
+#include "defs.h"
+
+namespace LxGeo
+{
+	namespace numcpp
+	{
+
+		/**
+		StreamingStats accumulates count, sum, min, max, mean and variance (Welford) of values added one by one, without storing them.
+		Percentiles are read from an optional fixed range histogram: values are ranked as in DetailedStats::percentile, each rank
+		taking the center of its bin (exact for integer values when bins are one unit wide and centered on integers).
+		Accumulators of the same histogram layout can be merged (e.g. partial accumulators of a polygon over several tiles).
+		*/
+		class StreamingStats {
+		public:
+			StreamingStats() {};
+
+			// Histogram of bins_count bins over [histogram_min, histogram_max], out of range values are counted in the end bins
+			StreamingStats(double histogram_min, double histogram_max, size_t bins_count) :
+				histogram_min(histogram_min), bin_width((histogram_max - histogram_min) / std::max<size_t>(bins_count, 1)), histogram(bins_count, 0) {
+				if (!(histogram_max > histogram_min))
+					throw std::runtime_error("StreamingStats histogram range is empty!");
+			};
+
+			void reset() {
+				m_count = 0; m_null_count = 0;
+				m_sum = 0; m_mean = 0; m_m2 = 0;
+				m_min = std::numeric_limits<double>::infinity();
+				m_max = -std::numeric_limits<double>::infinity();
+				std::fill(histogram.begin(), histogram.end(), 0);
+			}
+
+			void add(double value) {
+				m_count++;
+				m_sum += value;
+				double delta = value - m_mean;
+				m_mean += delta / m_count;
+				m_m2 += delta * (value - m_mean);
+				if (value < m_min) m_min = value;
+				if (value > m_max) m_max = value;
+				if (!histogram.empty())
+					histogram[bin_index(value)]++;
+			}
+
+			void add_null(size_t count = 1) { m_null_count += count; }
+
+			// Chan et al. pairwise combination of the moments
+			void merge(const StreamingStats& other) {
+				if (histogram.size() != other.histogram.size())
+					throw std::runtime_error("Merged StreamingStats histograms do not match!");
+				m_null_count += other.m_null_count;
+				if (other.m_count == 0)
+					return;
+				size_t merged_count = m_count + other.m_count;
+				double delta = other.m_mean - m_mean;
+				m_mean += delta * other.m_count / merged_count;
+				m_m2 += other.m_m2 + delta * delta * (double(m_count) * other.m_count / merged_count);
+				m_count = merged_count;
+				m_sum += other.m_sum;
+				m_min = std::min(m_min, other.m_min);
+				m_max = std::max(m_max, other.m_max);
+				for (size_t bin = 0; bin < histogram.size(); bin++)
+					histogram[bin] += other.histogram[bin];
+			}
+
+			// All statistics are regarding non null values (NaN when empty)
+			size_t count() const { return m_count; }
+			size_t count_null() const { return m_null_count; }
+			double sum() const { return m_sum; }
+			double min() const { return m_count ? m_min : std::numeric_limits<double>::quiet_NaN(); }
+			double max() const { return m_count ? m_max : std::numeric_limits<double>::quiet_NaN(); }
+			double mean() const { return m_count ? m_mean : std::numeric_limits<double>::quiet_NaN(); }
+			double variance() const { return m_count ? m_m2 / m_count : std::numeric_limits<double>::quiet_NaN(); }
+			double stdev() const { return std::sqrt(variance()); }
+
+			bool has_histogram() const { return !histogram.empty(); }
+
+			double percentile(double p) const {
+				if (!std::isfinite(p) || p < 0 || p > 100)
+					throw std::runtime_error("Percentile must be between 0 and 100.");
+				if (histogram.empty())
+					throw std::runtime_error("Percentiles require a StreamingStats histogram!");
+				if (m_count == 0)
+					return std::numeric_limits<double>::quiet_NaN();
+
+				double index = (p / 100.0) * (m_count - 1);
+				double int_part;
+				double frac_part = std::modf(index, &int_part);
+				double lower_value = ranked_value(static_cast<size_t>(int_part));
+				if (frac_part == 0.0)
+					return lower_value;
+				return lower_value + frac_part * (ranked_value(static_cast<size_t>(int_part) + 1) - lower_value);
+			}
+
+		private:
+			size_t bin_index(double value) const {
+				double bin = std::floor((value - histogram_min) / bin_width);
+				if (!(bin > 0)) return 0;
+				return std::min(histogram.size() - 1, static_cast<size_t>(std::min(bin, double(histogram.size()))));
+			}
+
+			// Center of the bin holding the value of rank (0 based) in sorted order
+			double ranked_value(size_t rank) const {
+				size_t cumulated_count = 0;
+				for (size_t bin = 0; bin < histogram.size(); bin++) {
+					cumulated_count += histogram[bin];
+					if (cumulated_count > rank)
+						return std::clamp(histogram_min + (bin + 0.5) * bin_width, m_min, m_max);
+				}
+				return m_max;
+			}
+
+		private:
+			size_t m_count = 0;
+			size_t m_null_count = 0;
+			double m_sum = 0;
+			double m_mean = 0;
+			double m_m2 = 0;
+			double m_min = std::numeric_limits<double>::infinity();
+			double m_max = -std::numeric_limits<double>::infinity();
+
+			double histogram_min = 0;
+			double bin_width = 1;
+			std::vector<uint64_t> histogram;
+		};
+
+	}
+}
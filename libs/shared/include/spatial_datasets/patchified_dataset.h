@@ -2,6 +2,8 @@
 #include "defs.h"
 #include "geometry_constructor/grid.h"
 #include "lightweight/geovector.h"
+#include "lightweight/raster_profile.h"
+#include <numeric>
 
 
 namespace LxGeo
@@ -15,6 +17,26 @@ namespace LxGeo
 			Boost_Polygon_2 boundary_geometry = Boost_Polygon_2();
 		};
 
+		enum class PatchOrdering {
+			grid, // column by column, as built by create_rectangular_grid
+			block_major, // raster blocks in row-major order, patches sharing a block are consecutive
+			z_order, // raster blocks in Morton order
+			row_major // patches top to bottom then left to right (required by streaming writers, see IO_DATA::MosaicAccumulator)
+		};
+
+		struct PatchGridLayout {
+			bool block_aligned = false; // snap grid origin and patch size to the raster blocks
+			PatchOrdering ordering = PatchOrdering::grid;
+		};
+
+		struct BlockAccessReport {
+			size_t n_patches = 0;
+			size_t n_block_reads = 0; // sum over patches of intersected raster blocks
+			size_t n_distinct_blocks = 0;
+			size_t n_block_cache_misses = 0; // block decodes when iterating with a block cache of the given capacity
+			double blocks_per_patch() const { return (n_patches > 0) ? double(n_block_reads) / n_patches : 0.0; }
+		};
+
 		class ContinuousPatchifiedDataset {
 
 		public:
@@ -51,6 +73,173 @@ namespace LxGeo
 					[&_boundary_geometry](const Boost_Box_2& a)->bool {return bg::intersects(_boundary_geometry, a); });
 			};
 
+			ContinuousPatchifiedDataset(PatchifiedDatasetParameters _patchified_dst_parameters, const IO_DATA::RProfile& raster_profile, PatchGridLayout layout) : patchified_dst_parameters(_patchified_dst_parameters) {
+				setup_spatial(
+					patchified_dst_parameters.spatial_patch_size,
+					patchified_dst_parameters.spatial_patch_overlap,
+					patchified_dst_parameters.boundary_geometry,
+					raster_profile,
+					layout,
+					patchified_dst_parameters.spatial_pad_size
+				);
+			}
+
+			/**
+			* Builds the grid relatively to the blocks (tiles or strips) of the raster described by raster_profile.
+			* When layout.block_aligned is set, the patch size is snapped to a multiple of the block size (or to a divisor of it when
+			* the patch is smaller than a block) and the grid origin is snapped to the block grid. Only these two are snapped: the step
+			* is the snapped patch size minus the requested overlap.
+			* Thus patch windows start on blocks and GDAL decompresses fewer blocks for a fraction of their pixels.
+			* Snapped sizes are stored in patchified_dst_parameters. A dimension spanning the whole raster (strips) is not snapped.
+			*/
+			void setup_spatial(double _spatial_patch_size, double _spatial_patch_overlap, const Boost_Polygon_2& _boundary_geometry,
+				const IO_DATA::RProfile& raster_profile, PatchGridLayout layout, double spatial_pad_size = 0.0)
+			{
+				if (!layout.block_aligned || raster_profile.block_width <= 0 || raster_profile.block_height <= 0) {
+					setup_spatial(_spatial_patch_size, _spatial_patch_overlap, _boundary_geometry, spatial_pad_size);
+					order_grid_boxes(layout.ordering, raster_profile);
+					return;
+				}
+
+				const double gsd = raster_profile.gsd();
+				// dimensions spanning the whole raster (strips) or made of single rows are not snapped
+				int x_block = (raster_profile.block_width < raster_profile.width) ? raster_profile.block_width : 1;
+				int y_block = (raster_profile.block_height < raster_profile.height) ? raster_profile.block_height : 1;
+				// patches are square, thus both dimensions share a common block size
+				int block_px = std::lcm(x_block, y_block);
+				if (block_px <= 1) {
+					setup_spatial(_spatial_patch_size, _spatial_patch_overlap, _boundary_geometry, spatial_pad_size);
+					order_grid_boxes(layout.ordering, raster_profile);
+					return;
+				}
+
+				int patch_px = std::max<int>(std::rint(_spatial_patch_size / gsd), 1);
+				int overlap_px = std::rint(_spatial_patch_overlap / gsd);
+				int snapped_patch_px;
+				if (patch_px >= block_px)
+					snapped_patch_px = std::max<int>(std::rint(double(patch_px) / block_px), 1) * block_px;
+				else {
+					// nearest divisor of the block size
+					snapped_patch_px = 1;
+					for (int divisor = 1; divisor <= block_px; ++divisor)
+						if (block_px % divisor == 0 && std::abs(divisor - patch_px) <= std::abs(snapped_patch_px - patch_px))
+							snapped_patch_px = divisor;
+				}
+				// a step shortened to the block grid would add patches, each reading its blocks again
+				int step_px = std::clamp(snapped_patch_px - overlap_px, 1, snapped_patch_px);
+
+				patchified_dst_parameters.spatial_patch_size = snapped_patch_px * gsd;
+				patchified_dst_parameters.spatial_patch_overlap = (snapped_patch_px - step_px) * gsd;
+				patchified_dst_parameters.boundary_geometry = _boundary_geometry;
+
+				Boost_Box_2 boundary_geometry_envelope;
+				bg::envelope(_boundary_geometry, boundary_geometry_envelope);
+				// snap the lower corner on the block grid anchored at the raster origin
+				double x_block_spatial = std::abs(raster_profile.geotransform[1]) * block_px;
+				double y_block_spatial = std::abs(raster_profile.geotransform[5]) * block_px;
+				double aligned_xmin = raster_profile.geotransform[0] + std::floor((boundary_geometry_envelope.min_corner().get<0>() - spatial_pad_size - raster_profile.geotransform[0]) / x_block_spatial) * x_block_spatial;
+				double aligned_ymin = raster_profile.geotransform[3] + std::floor((boundary_geometry_envelope.min_corner().get<1>() - spatial_pad_size - raster_profile.geotransform[3]) / y_block_spatial) * y_block_spatial;
+				boundary_geometry_envelope = Boost_Box_2(
+					Boost_Point_2(aligned_xmin, aligned_ymin),
+					Boost_Point_2(boundary_geometry_envelope.max_corner().get<0>() + spatial_pad_size, boundary_geometry_envelope.max_corner().get<1>() + spatial_pad_size)
+				);
+
+				grid_boxes = create_rectangular_grid<Boost_Box_2, Boost_Box_2>(
+					boundary_geometry_envelope, step_px * std::abs(raster_profile.geotransform[1]), step_px * std::abs(raster_profile.geotransform[5]),
+					patchified_dst_parameters.spatial_patch_size, patchified_dst_parameters.spatial_patch_size,
+					[&_boundary_geometry](const Boost_Box_2& a)->bool {return bg::intersects(_boundary_geometry, a); });
+
+				order_grid_boxes(layout.ordering, raster_profile);
+			}
+
+			/**
+			* Sorts grid_boxes so that consecutive patches read the same raster blocks (reuse of the GDAL block cache).
+			*/
+			void order_grid_boxes(PatchOrdering ordering, const IO_DATA::RProfile& raster_profile) {
+				if (ordering == PatchOrdering::grid || grid_boxes.empty())
+					return;
+
+				int block_width = (raster_profile.block_width > 0) ? raster_profile.block_width : raster_profile.width;
+				int block_height = (raster_profile.block_height > 0) ? raster_profile.block_height : 1;
+
+				struct patch_key { int64_t block_col, block_row, pixel_col, pixel_row; };
+				std::vector<patch_key> keys; keys.reserve(grid_boxes.size());
+				for (const auto& c_box : grid_boxes) {
+					auto pixel_window = box_pixel_window(c_box, raster_profile);
+					int64_t pixel_col = pixel_window.first.first, pixel_row = pixel_window.first.second;
+					keys.push_back({ floor_div(pixel_col, block_width), floor_div(pixel_row, block_height), pixel_col, pixel_row });
+				}
+				// Morton codes require non negative indices (padded grids start before the raster)
+				int64_t min_block_col = std::min_element(keys.begin(), keys.end(), [](auto& a, auto& b) {return a.block_col < b.block_col; })->block_col;
+				int64_t min_block_row = std::min_element(keys.begin(), keys.end(), [](auto& a, auto& b) {return a.block_row < b.block_row; })->block_row;
+
+				std::vector<std::pair<std::tuple<uint64_t, int64_t, int64_t>, size_t>> sort_keys(grid_boxes.size());
+				for (size_t idx = 0; idx < keys.size(); idx++) {
+					const auto& c_key = keys[idx];
+					uint64_t block_key;
+					if (ordering == PatchOrdering::row_major)
+						block_key = 0;
+					else if (ordering == PatchOrdering::z_order)
+						block_key = morton_code(c_key.block_col - min_block_col, c_key.block_row - min_block_row);
+					else
+						block_key = (uint64_t(c_key.block_row - min_block_row) << 32) | uint64_t(c_key.block_col - min_block_col);
+					sort_keys[idx] = { { block_key, c_key.pixel_row, c_key.pixel_col }, idx };
+				}
+				std::stable_sort(sort_keys.begin(), sort_keys.end(), [](auto& a, auto& b) {return a.first < b.first; });
+
+				std::vector<Boost_Box_2> ordered_boxes; ordered_boxes.reserve(grid_boxes.size());
+				for (auto& c_sort_key : sort_keys)
+					ordered_boxes.push_back(grid_boxes[c_sort_key.second]);
+				grid_boxes = std::move(ordered_boxes);
+			}
+
+			/**
+			* Counts the raster blocks intersected by the patch windows (clipped to the raster extents).
+			* Block cache misses are simulated for a least recently used cache of block_cache_capacity blocks
+			* while iterating grid_boxes in order.
+			*/
+			BlockAccessReport block_access_report(const IO_DATA::RProfile& raster_profile, size_t block_cache_capacity = 64) const {
+				BlockAccessReport report;
+				int block_width = (raster_profile.block_width > 0) ? raster_profile.block_width : raster_profile.width;
+				int block_height = (raster_profile.block_height > 0) ? raster_profile.block_height : 1;
+
+				std::set<std::pair<int64_t, int64_t>> distinct_blocks;
+				std::list<std::pair<int64_t, int64_t>> lru_blocks;
+				std::map<std::pair<int64_t, int64_t>, std::list<std::pair<int64_t, int64_t>>::iterator> lru_index;
+
+				for (const auto& c_box : grid_boxes) {
+					auto pixel_window = box_pixel_window(c_box, raster_profile);
+					int64_t col_start = std::max<int64_t>(pixel_window.first.first, 0);
+					int64_t row_start = std::max<int64_t>(pixel_window.first.second, 0);
+					int64_t col_end = std::min<int64_t>(pixel_window.second.first, raster_profile.width);
+					int64_t row_end = std::min<int64_t>(pixel_window.second.second, raster_profile.height);
+					report.n_patches++;
+					if (col_start >= col_end || row_start >= row_end)
+						continue;
+					for (int64_t block_row = row_start / block_height; block_row <= (row_end - 1) / block_height; block_row++) {
+						for (int64_t block_col = col_start / block_width; block_col <= (col_end - 1) / block_width; block_col++) {
+							std::pair<int64_t, int64_t> c_block(block_col, block_row);
+							report.n_block_reads++;
+							distinct_blocks.insert(c_block);
+							auto index_it = lru_index.find(c_block);
+							if (index_it != lru_index.end()) {
+								lru_blocks.splice(lru_blocks.begin(), lru_blocks, index_it->second);
+								continue;
+							}
+							report.n_block_cache_misses++;
+							lru_blocks.push_front(c_block);
+							lru_index[c_block] = lru_blocks.begin();
+							if (lru_blocks.size() > std::max<size_t>(block_cache_capacity, 1)) {
+								lru_index.erase(lru_blocks.back());
+								lru_blocks.pop_back();
+							}
+						}
+					}
+				}
+				report.n_distinct_blocks = distinct_blocks.size();
+				return report;
+			}
+
 			void transform_inplace(const std::function<void(Boost_Box_2&)>& transformer_fn) {
 				for (auto& el : grid_boxes)
 					transformer_fn(el);
@@ -74,6 +263,31 @@ namespace LxGeo
 				grid_gvector.to_file(out_path, &srs);
 			}
 
+		private:
+			static int64_t floor_div(int64_t a, int64_t b) {
+				return (a >= 0) ? a / b : -((-a + b - 1) / b);
+			}
+
+			static uint64_t morton_code(uint64_t x, uint64_t y) {
+				uint64_t code = 0;
+				for (int bit = 0; bit < 32; bit++) {
+					code |= ((x >> bit) & 1ULL) << (2 * bit);
+					code |= ((y >> bit) & 1ULL) << (2 * bit + 1);
+				}
+				return code;
+			}
+
+			// ((col_start, row_start), (col_end, row_end)) of a spatial box in the raster pixel space
+			static std::pair<std::pair<int64_t, int64_t>, std::pair<int64_t, int64_t>> box_pixel_window(const Boost_Box_2& box, const IO_DATA::RProfile& raster_profile) {
+				const double* gt = raster_profile.geotransform;
+				double col_a = (box.min_corner().get<0>() - gt[0]) / gt[1], col_b = (box.max_corner().get<0>() - gt[0]) / gt[1];
+				double row_a = (box.min_corner().get<1>() - gt[3]) / gt[5], row_b = (box.max_corner().get<1>() - gt[3]) / gt[5];
+				return {
+					{ int64_t(std::floor(std::min(col_a, col_b) + 1e-6)), int64_t(std::floor(std::min(row_a, row_b) + 1e-6)) },
+					{ int64_t(std::ceil(std::max(col_a, col_b) - 1e-6)), int64_t(std::ceil(std::max(row_a, row_b) - 1e-6)) }
+				};
+			}
+
 		public:
 			PatchifiedDatasetParameters patchified_dst_parameters;
 			std::vector<Boost_Box_2> grid_boxes;
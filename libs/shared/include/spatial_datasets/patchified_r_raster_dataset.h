@@ -3,6 +3,9 @@
 #include "spatial_datasets/patchified_dataset.h"
 #include "lightweight/raster_profile.h"
 #include "lightweight/geoimage.h"
+#include "gdal_dataset_pool.h"
+#include "design_pattern/bounded_queue.h"
+#include <thread>
 
 
 namespace LxGeo
@@ -10,6 +13,12 @@ namespace LxGeo
 	namespace GeometryFactoryShared
 	{
 
+		struct PatchIterationOptions {
+			size_t n_readers = 2; // reader threads, each one holding its own dataset handle
+			size_t n_workers = std::max<size_t>(std::thread::hardware_concurrency(), 1); // threads running the processing callback
+			size_t prefetch_count = 8; // patches read ahead of the processing
+		};
+
 		template <typename cv_mat_type>
 		class RPRasterDataset {
 
@@ -17,20 +26,18 @@ namespace LxGeo
 
 			// Constructor from filepath using predfined ContinuousPatchifiedDataset
 			RPRasterDataset(std::string _raster_file_path, const ContinuousPatchifiedDataset& _cpd) : raster_file_path(_raster_file_path), cpd(_cpd) {
-				raster_dataset = load_gdal_dataset_shared_ptr(raster_file_path);
-				raster_profile = IO_DATA::RProfile::from_gdal_dataset(raster_dataset);
+				raster_profile = IO_DATA::RProfile::from_gdal_dataset(IO_DATA::GDALDatasetPool::instance().acquire(raster_file_path));
 
 				pixel_patch_size = std::rint(cpd.patchified_dst_parameters.spatial_patch_size / raster_profile.gsd());
 				pixel_patch_overlap = std::rint(cpd.patchified_dst_parameters.spatial_patch_overlap / raster_profile.gsd());
 			}
 
-			// Constructor from filepath and pixel patchified parameters
-			RPRasterDataset(std::string _raster_file_path, int _pixel_patch_size, int _pixel_patch_overlap, int _pixel_pad_size=0, const Boost_Polygon_2& _boundary_geometry=Boost_Polygon_2()):
+			// Constructor from filepath and pixel patchified parameters (layout may align the patches on the raster blocks)
+			RPRasterDataset(std::string _raster_file_path, int _pixel_patch_size, int _pixel_patch_overlap, int _pixel_pad_size=0, const Boost_Polygon_2& _boundary_geometry=Boost_Polygon_2(),
+				PatchGridLayout layout = PatchGridLayout()):
 				raster_file_path(_raster_file_path),pixel_patch_size(_pixel_patch_size), pixel_patch_overlap(_pixel_patch_overlap), pixel_pad_size(_pixel_pad_size)
 			{
-				raster_dataset = load_gdal_dataset_shared_ptr(raster_file_path);
-				RProfile temp_profile = IO_DATA::RProfile::from_gdal_dataset(raster_dataset);
-				raster_profile = temp_profile;
+				raster_profile = IO_DATA::RProfile::from_gdal_dataset(IO_DATA::GDALDatasetPool::instance().acquire(raster_file_path));
 				
 				Boost_Polygon_2 correct_boundary_geometry;
 				if (_boundary_geometry.outer().empty()) {
@@ -43,7 +50,10 @@ namespace LxGeo
 				double spatial_patch_size = double(pixel_patch_size) * raster_profile.gsd();
 				double spatial_patch_overlap = double(pixel_patch_overlap) * raster_profile.gsd();
 				double spatial_pad_size = double(pixel_pad_size) * raster_profile.gsd();
-				cpd = ContinuousPatchifiedDataset({ spatial_patch_size, spatial_patch_overlap, spatial_pad_size, correct_boundary_geometry });
+				cpd = ContinuousPatchifiedDataset({ spatial_patch_size, spatial_patch_overlap, spatial_pad_size, correct_boundary_geometry }, raster_profile, layout);
+				// block alignment may have snapped the patch size and overlap
+				pixel_patch_size = std::rint(cpd.patchified_dst_parameters.spatial_patch_size / raster_profile.gsd());
+				pixel_patch_overlap = std::rint(cpd.patchified_dst_parameters.spatial_patch_overlap / raster_profile.gsd());
 			}
 
 			size_t length() {
@@ -54,15 +64,189 @@ namespace LxGeo
 				return raster_profile;
 			}
 
+			BlockAccessReport block_access_report(size_t block_cache_capacity = 64) const {
+				return cpd.block_access_report(raster_profile, block_cache_capacity);
+			}
+
 			IO_DATA::GeoImage<cv_mat_type> operator[](const int& offset) {
 				auto& patch_box = cpd.grid_boxes[offset];
 				OGREnvelope patch_envelope = transform_B2OGR_Envelope(patch_box);
+				// from_file reuses pooled dataset handles (see IO_DATA::GDALDatasetPool)
 				return IO_DATA::GeoImage<cv_mat_type>::from_file(raster_file_path, patch_envelope);
 			}
 
+			/**
+			* Reads and processes all patches concurrently.
+			* Patches are read by options.n_readers threads and prefetched in a bounded queue consumed by options.n_workers threads
+			* running process_fn(patch_idx, patch). Results are handed to consume_fn(patch_idx, result) on the calling thread in patch order.
+			* The number of patches in flight is bounded by prefetch_count + n_workers.
+			* The first exception thrown by a reader, process_fn or consume_fn stops the iteration and is rethrown.
+			*/
+			template <typename process_fn_t, typename consume_fn_t>
+				requires std::invocable<consume_fn_t&, size_t, std::invoke_result_t<process_fn_t&, size_t, IO_DATA::GeoImage<cv_mat_type>&>&>
+			void for_each_patch(process_fn_t process_fn, consume_fn_t consume_fn, const PatchIterationOptions& options = PatchIterationOptions()) {
+
+				typedef std::invoke_result_t<process_fn_t&, size_t, IO_DATA::GeoImage<cv_mat_type>&> result_type;
+				typedef std::pair<size_t, IO_DATA::GeoImage<cv_mat_type>> read_item;
+
+				const size_t n_patches = length();
+				if (n_patches == 0)
+					return;
+				const size_t n_readers = std::clamp<size_t>(options.n_readers, 1, n_patches);
+				const size_t n_workers = std::clamp<size_t>(options.n_workers, 1, n_patches);
+				const size_t max_in_flight = std::max<size_t>(options.prefetch_count, 1) + n_workers;
+
+				std::mutex mtx;
+				std::condition_variable slot_cv, result_cv;
+				size_t next_to_read = 0, next_to_consume = 0;
+				bool aborted = false;
+				std::exception_ptr first_error;
+				std::map<size_t, result_type> ready_results;
+				BoundedQueue<read_item> read_queue(options.prefetch_count);
+
+				auto abort_iteration = [&](std::exception_ptr c_error) {
+					{
+						std::lock_guard<std::mutex> lock(mtx);
+						if (!first_error)
+							first_error = c_error;
+						aborted = true;
+					}
+					slot_cv.notify_all();
+					result_cv.notify_all();
+					read_queue.close();
+				};
+
+				auto reader_task = [&]() {
+					try {
+						std::shared_ptr<GDALDataset> c_dataset = IO_DATA::GDALDatasetPool::instance().acquire(raster_file_path);
+						while (true) {
+							size_t patch_idx;
+							{
+								std::unique_lock<std::mutex> lock(mtx);
+								slot_cv.wait(lock, [&]() { return aborted || next_to_read >= n_patches || next_to_read < next_to_consume + max_in_flight; });
+								if (aborted || next_to_read >= n_patches)
+									break;
+								patch_idx = next_to_read++;
+							}
+							OGREnvelope patch_envelope = transform_B2OGR_Envelope(cpd.grid_boxes[patch_idx]);
+							read_item c_item(patch_idx, IO_DATA::GeoImage<cv_mat_type>::from_dataset(c_dataset, patch_envelope));
+							if (!read_queue.push(std::move(c_item)))
+								break;
+						}
+					}
+					catch (...) {
+						abort_iteration(std::current_exception());
+					}
+				};
+
+				auto worker_task = [&]() {
+					try {
+						read_item c_item;
+						while (read_queue.pop(c_item)) {
+							result_type c_result = process_fn(c_item.first, c_item.second);
+							{
+								std::lock_guard<std::mutex> lock(mtx);
+								if (aborted)
+									continue;
+								ready_results.emplace(c_item.first, std::move(c_result));
+							}
+							result_cv.notify_all();
+						}
+					}
+					catch (...) {
+						abort_iteration(std::current_exception());
+					}
+				};
+
+				std::vector<std::thread> readers, workers;
+				for (size_t i = 0; i < n_readers; ++i)
+					readers.emplace_back(reader_task);
+				for (size_t i = 0; i < n_workers; ++i)
+					workers.emplace_back(worker_task);
+
+				try {
+					for (size_t patch_idx = 0; patch_idx < n_patches; ++patch_idx) {
+						typename std::map<size_t, result_type>::node_type c_node;
+						{
+							std::unique_lock<std::mutex> lock(mtx);
+							result_cv.wait(lock, [&]() { return aborted || ready_results.count(patch_idx) > 0; });
+							if (aborted)
+								break;
+							c_node = ready_results.extract(patch_idx);
+							next_to_consume = patch_idx + 1;
+						}
+						slot_cv.notify_all();
+						consume_fn(patch_idx, c_node.mapped());
+					}
+				}
+				catch (...) {
+					abort_iteration(std::current_exception());
+				}
+
+				// workers stop once readers are done and the queue is drained
+				for (auto& c_thread : readers)
+					c_thread.join();
+				read_queue.close();
+				for (auto& c_thread : workers)
+					c_thread.join();
+
+				if (first_error)
+					std::rethrow_exception(first_error);
+			}
+
+			/**
+			* Same as for_each_patch without results: process_fn(patch_idx, patch) runs on the worker threads.
+			*/
+			template <typename process_fn_t>
+			void for_each_patch(process_fn_t process_fn, const PatchIterationOptions& options = PatchIterationOptions()) {
+				for_each_patch(
+					[&process_fn](size_t patch_idx, IO_DATA::GeoImage<cv_mat_type>& patch) { process_fn(patch_idx, patch); return true; },
+					[](size_t, bool&) {},
+					options
+				);
+			}
+
+			/**
+			* Reads patches [start_idx, start_idx + batch_size) using n_readers threads.
+			* Patches are returned in index order.
+			*/
+			std::vector<IO_DATA::GeoImage<cv_mat_type>> read_batch(size_t start_idx, size_t batch_size, size_t n_readers = 2) {
+				size_t end_idx = std::min<size_t>(start_idx + batch_size, length());
+				if (start_idx >= end_idx)
+					return {};
+				std::vector<IO_DATA::GeoImage<cv_mat_type>> batch(end_idx - start_idx);
+				n_readers = std::clamp<size_t>(n_readers, 1, batch.size());
+
+				std::exception_ptr first_error;
+				std::mutex error_mtx;
+				auto reader_task = [&](size_t reader_idx) {
+					try {
+						std::shared_ptr<GDALDataset> c_dataset = IO_DATA::GDALDatasetPool::instance().acquire(raster_file_path);
+						for (size_t patch_idx = start_idx + reader_idx; patch_idx < end_idx; patch_idx += n_readers) {
+							OGREnvelope patch_envelope = transform_B2OGR_Envelope(cpd.grid_boxes[patch_idx]);
+							batch[patch_idx - start_idx] = IO_DATA::GeoImage<cv_mat_type>::from_dataset(c_dataset, patch_envelope);
+						}
+					}
+					catch (...) {
+						std::lock_guard<std::mutex> lock(error_mtx);
+						if (!first_error)
+							first_error = std::current_exception();
+					}
+				};
+
+				std::vector<std::thread> readers;
+				for (size_t i = 0; i < n_readers; ++i)
+					readers.emplace_back(reader_task, i);
+				for (auto& c_thread : readers)
+					c_thread.join();
+
+				if (first_error)
+					std::rethrow_exception(first_error);
+				return batch;
+			}
+
 		private:
 			std::string raster_file_path;
-			std::shared_ptr<GDALDataset> raster_dataset;
 			IO_DATA::RProfile raster_profile;
 			ContinuousPatchifiedDataset cpd;
 			int pixel_patch_size, pixel_patch_overlap, pixel_pad_size;
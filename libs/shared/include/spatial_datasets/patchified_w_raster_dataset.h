@@ -4,6 +4,8 @@
 #include "lightweight/raster_profile.h"
 #include "lightweight/geoimage.h"
 #include "spatial_coord_transformer.h"
+#include "async_tiled_raster_writer.h"
+#include "mosaic_accumulator.h"
 
 
 namespace LxGeo
@@ -36,17 +38,69 @@ namespace LxGeo
 					raster_dataset = std::shared_ptr<GDALDataset>((GDALDataset*)GDALOpen(raster_file_path.c_str(), GA_Update), GDALClose);
 			}
 
+			/**
+			* Routes the following write_geoimage calls to a writer thread (see IO_DATA::AsyncTiledRasterWriter).
+			* write_geoimage may then be called concurrently and blocks only when the submit queue is full.
+			*/
+			void enable_async_writing(const AsyncWriteOptions& options = AsyncWriteOptions()) {
+				close();
+				raster_dataset->GetGeoTransform(sink_geotransform);
+				async_writer = std::make_shared<AsyncTiledRasterWriter>(raster_dataset, options);
+			}
+
+			/**
+			* Blends the following written geoimages into a streaming mosaic (see IO_DATA::MosaicAccumulator).
+			* Geoimages must be written by non decreasing top row (PatchOrdering::row_major), the mosaic is completed on close.
+			*/
+			void enable_blending(const MosaicBlendingOptions& options = MosaicBlendingOptions()) {
+				close();
+				raster_dataset->GetGeoTransform(sink_geotransform);
+				mosaic_accumulator = std::make_shared<MosaicAccumulator>(raster_dataset, options);
+			}
+
 			template <typename cv_mat_type>
 			void write_geoimage(const GeoImage<cv_mat_type>& gimg) {
-				gimg.to_dataset(raster_dataset);
+				if (!async_writer && !mosaic_accumulator) {
+					gimg.to_dataset(raster_dataset);
+					return;
+				}
+				int col_start, row_start;
+				AffineTransformerBase(sink_geotransform)._calc_pixel_coords(gimg.geotransform[0], gimg.geotransform[3], col_start, row_start);
+				if (async_writer)
+					async_writer->submit(col_start, row_start, gimg.get_image());
+				else
+					mosaic_accumulator->add_patch(col_start, row_start, gimg.get_image());
 			}
 
+			// Waits until all written geoimages are stored in the dataset (only completed rows when blending)
+			void flush() {
+				if (async_writer)
+					async_writer->flush();
+				else
+					raster_dataset->FlushCache();
+			}
 
+			// Flushes and stops asynchronous writing or blending (following writes are synchronous)
+			void close() {
+				if (async_writer) {
+					async_writer->close();
+					async_writer.reset();
+				}
+				if (mosaic_accumulator) {
+					mosaic_accumulator->finalize();
+					mosaic_accumulator.reset();
+				}
+				if (raster_dataset)
+					raster_dataset->FlushCache();
+			}
 
 		private:
 			std::string raster_file_path;
 			std::shared_ptr<GDALDataset> raster_dataset;
 			RProfile raster_profile;
+			std::shared_ptr<AsyncTiledRasterWriter> async_writer;
+			std::shared_ptr<MosaicAccumulator> mosaic_accumulator;
+			double sink_geotransform[6];
 		};
 
 	}
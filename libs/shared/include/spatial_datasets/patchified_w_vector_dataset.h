@@ -3,6 +3,7 @@
 #include "spatial_datasets/patchified_dataset.h"
 #include "lightweight/vector_profile.h"
 #include "lightweight/geovector.h"
+#include "lightweight/geovector_view.h"
 #include "spatial_coord_transformer.h"
 
 
@@ -38,20 +39,31 @@ namespace LxGeo
 				}
 			}
 
-			template <typename geom_type>
-			void write_geovector(const GeoVector<geom_type>& gvec) {
+			template <typename geom_type, typename rtree_parameters>
+			void write_geovector(const GeoVector<geom_type, rtree_parameters>& gvec) {
+				write_features<geom_type>(gvec, gvec.geometries_container);
+			}
+
+			// Writes the view geometries without copying them
+			template <typename geom_type, typename rtree_parameters>
+			void write_geovector(const GeoVectorView<geom_type, rtree_parameters>& gview) {
+				write_features<geom_type>(gview, gview);
+			}
+
+		private:
+			template <typename geom_type, typename features_source_type, typename features_range_type>
+			void write_features(const features_source_type& features_source, const features_range_type& features) {
 				auto already_saved_filter = [this](const Geometries_with_attributes<geom_type>& gwa)->bool {
 					size_t c_geom_id = gwa.get_int_attribute(GeoVector<geom_type>::ID_FIELD_NAME);
 					return (saved_ids.find(c_geom_id) == saved_ids.end());
 				};
-				gvec.to_dataset(vector_dataset.get(), wm, "", already_saved_filter);
-				std::transform(gvec.geometries_container.begin(),
-					gvec.geometries_container.end(),
+				features_source.to_dataset(vector_dataset.get(), wm, "", already_saved_filter);
+				std::transform(features.begin(),
+					features.end(),
 					std::inserter(saved_ids, saved_ids.begin()),
 					[](const auto& gwa) {return gwa.get_int_attribute(GeoVector<geom_type>::ID_FIELD_NAME); });
 			}
 
-
 		private:
 			std::string vector_file_path;
 			WriteMode wm;
@@ -1,34 +1,46 @@
 #pragma once
 #include "defs.h"
 #include "geometries_with_attributes/geometries_with_attributes.h"
+#include "design_pattern/parallel_for.h"
 
 namespace LxGeo
 {
 	namespace GeometryFactoryShared
 	{
 
-		template <typename geom_type>
+		struct RTreeBuildOptions {
+			bool packed = true; // bulk loading through the rtree range constructor (STR packing), otherwise elements are inserted one by one
+			size_t n_threads = 1; // threads computing the geometries envelopes before packing (0: hardware concurrency)
+		};
+
+		/**
+		* rtree_parameters selects the balancing policy and node capacity used by the rtree (bgi::quadratic<16>, bgi::linear<32>, bgi::rstar<16> ...).
+		* Packed trees are built the same way whatever the policy, the policy applies to later insertions and removals.
+		*/
+		template <typename geom_type, typename rtree_parameters = bgi::quadratic<16>>
 		struct SpatialIndexedGeometryContainer {
 
 			//typedef std::conditional<std::is_same_v<geom_type, Boost_Point_2>, std::pair<Boost_Point_2, size_t>, std::pair<Boost_Box_2, size_t>>::type Boost_Value;
 			using Boost_Value = typename std::conditional<std::is_same_v<geom_type, Boost_Point_2>, std::pair<Boost_Point_2, size_t>, std::pair<Boost_Box_2, size_t>>::type;
-			typedef bgi::rtree<Boost_Value, bgi::quadratic<16> > Boost_RTree;
+			typedef bgi::rtree<Boost_Value, rtree_parameters > Boost_RTree;
 
 		public:
 			Boost_RTree rtree;
 
 			SpatialIndexedGeometryContainer() {}
-			SpatialIndexedGeometryContainer(const SpatialIndexedGeometryContainer& other): rtree(other.rtree) {};
+			SpatialIndexedGeometryContainer(const SpatialIndexedGeometryContainer& other): rtree(other.rtree), rtree_rebuild_ratio(other.rtree_rebuild_ratio) {};
 			SpatialIndexedGeometryContainer(const Boost_RTree& ref_rtree) :rtree(ref_rtree) {};
 			~SpatialIndexedGeometryContainer() {};
 
 			SpatialIndexedGeometryContainer(SpatialIndexedGeometryContainer&& other) noexcept {
 				rtree = std::move(other.rtree);				
+				rtree_rebuild_ratio = other.rtree_rebuild_ratio;
 			}
 			
 			SpatialIndexedGeometryContainer& operator=(SpatialIndexedGeometryContainer&& other) noexcept {
 				if (this != &other) {
 					rtree = std::move(other.rtree);
+					rtree_rebuild_ratio = other.rtree_rebuild_ratio;
 				}
 				return *this;
 			}
@@ -39,30 +51,110 @@ namespace LxGeo
 			virtual geom_type& operator[](int offset) = 0;
 			virtual const geom_type& operator[](int offset) const = 0;
 
-			void init_rtree() {
-				rtree.clear();
-				if constexpr (std::is_same_v<geom_type, Boost_Point_2>)
-					init_rtree_1d();
-				else
-					init_rtree_2d();
+			void init_rtree(const RTreeBuildOptions& options = RTreeBuildOptions()) {
+				rtree_rebuild_pending = false;
+				// the rebuilt rtree holds the current value of every geometry
+				pending_removals.clear();
+				pending_insertions.clear();
+				if (!options.packed) {
+					rtree.clear();
+					for (size_t idx = 0; idx < this->length(); idx++)
+						rtree.insert(indexed_value(idx));
+					return;
+				}
+				std::vector<Boost_Value> values(this->length());
+				parallel_for_chunks(values.size(), options.n_threads, [this, &values](size_t begin, size_t end) {
+					for (size_t idx = begin; idx < end; idx++)
+						values[idx] = indexed_value(idx);
+					});
+				rtree = Boost_RTree(values.begin(), values.end());
+			}
+
+			// Packs the rtree from precomputed values (e.g. envelopes stored with the geometries)
+			void init_rtree(std::vector<Boost_Value> values) {
+				rtree_rebuild_pending = false;
+				rtree = Boost_RTree(values.begin(), values.end());
+				pending_removals.clear();
+				pending_insertions.clear();
+			}
+
+			/**
+			* Scope during which rtree updates are only recorded. When the last scope ends, recorded updates are applied
+			* one by one, or the rtree is rebuilt when they exceed rtree_rebuild_ratio of the geometries count.
+			* The scope may end during stack unwinding, a failing commit is not rethrown: the rtree is rebuilt by the next commit instead.
+			*/
+			class RTreeUpdateScope {
+			public:
+				RTreeUpdateScope(SpatialIndexedGeometryContainer& _container) : container(_container) { container.deferred_updates_depth++; }
+				~RTreeUpdateScope() noexcept {
+					if (--container.deferred_updates_depth != 0)
+						return;
+					try {
+						container.commit_rtree_updates();
+					}
+					catch (...) {
+						container.rtree_rebuild_pending = true;
+					}
+				}
+				RTreeUpdateScope(const RTreeUpdateScope&) = delete;
+				RTreeUpdateScope& operator=(const RTreeUpdateScope&) = delete;
+			private:
+				SpatialIndexedGeometryContainer& container;
+			};
+
+			// Defers rtree updates until the returned scope is destroyed (batches of edits)
+			[[nodiscard]] RTreeUpdateScope defer_rtree_updates() { return RTreeUpdateScope(*this); }
+
+		public:
+			double rtree_rebuild_ratio = 0.1; // pending updates over geometries count above which the rtree is rebuilt instead of updated
+
+		protected:
+			/**
+			* Incremental maintenance used by derived containers editing their geometries within an update scope:
+			* rtree_unindex(idx) before the geometry at idx changes or leaves the container, rtree_index(idx) once it is set.
+			*/
+			void rtree_unindex(size_t idx) {
+				// geometries added or changed in the current scope are not in the rtree yet
+				if (pending_insertions.erase(idx) == 0)
+					pending_removals.push_back(indexed_value(idx));
+			}
+
+			void rtree_index(size_t idx) {
+				pending_insertions.insert(idx);
 			}
 
 		private:
-			void init_rtree_1d() {
-				for (size_t idx = 0; idx < this->length(); idx++) {
-					const geom_type& c_boost_geom = this->operator[](idx);
-					rtree.insert(std::make_pair(c_boost_geom, idx));
+			void commit_rtree_updates() {
+				size_t updates_count = pending_removals.size() + pending_insertions.size();
+				if (updates_count == 0 && !rtree_rebuild_pending)
+					return;
+				if (rtree_rebuild_pending || updates_count > rtree_rebuild_ratio * this->length()) {
+					init_rtree();
+					return;
 				}
+				for (const auto& c_value : pending_removals)
+					rtree.remove(c_value);
+				for (size_t idx : pending_insertions)
+					rtree.insert(indexed_value(idx));
+				pending_removals.clear();
+				pending_insertions.clear();
 			}
 
-			void init_rtree_2d() {
-				for (size_t idx = 0; idx < this->length(); idx++) {
-					const geom_type& c_boost_geom = this->operator[](idx);
+			Boost_Value indexed_value(size_t idx) const {
+				const geom_type& c_boost_geom = this->operator[](idx);
+				if constexpr (std::is_same_v<geom_type, Boost_Point_2>)
+					return std::make_pair(c_boost_geom, idx);
+				else {
 					Boost_Box_2 envelope; bg::envelope(c_boost_geom, envelope);
-					rtree.insert(std::make_pair(envelope, idx));
+					return std::make_pair(envelope, idx);
 				}
 			}
 
+		private:
+			size_t deferred_updates_depth = 0;
+			bool rtree_rebuild_pending = false; // set when a commit failed (the rtree may be partially updated)
+			std::vector<Boost_Value> pending_removals; // values to remove from the rtree
+			std::unordered_set<size_t> pending_insertions; // indices whose current value is to insert in the rtree
 		};
 
 	}
@@ -1,6 +1,7 @@
 #pragma once
 #include "defs_boost.h"
 #include <boost/range/adaptor/indirected.hpp>
+#include <span>
 
 
 namespace LxGeo
@@ -8,25 +9,48 @@ namespace LxGeo
 	namespace GeometryFactoryShared
 	{
 
+		/*
+		Contiguous buffer of the pixel values pinned to a geometry element. Values are appended in blocks (no allocation per pixel)
+		and consumed through span views (ex: aggregators).
+		*/
+		template <typename pixel_values_type>
+		class PinnedPixels {
+		public:
+			void push_back(const pixel_values_type& value) { values.push_back(value); }
+			void append(std::span<const pixel_values_type> appended_values) { values.insert(values.end(), appended_values.begin(), appended_values.end()); }
+			void reserve(size_t count) { values.reserve(count); }
+			void clear() { values.clear(); }
+
+			size_t size() const { return values.size(); }
+			bool empty() const { return values.empty(); }
+			std::span<const pixel_values_type> view() const { return values; }
+			std::span<pixel_values_type> view() { return values; }
+
+			auto begin() const { return values.begin(); }
+			auto end() const { return values.end(); }
+
+		private:
+			std::vector<pixel_values_type> values;
+		};
 
 		template<typename pixel_values_type, typename CoordinateType, std::size_t DimensionCount, typename CoordinateSystem>
 		class Elementary_Pinned_Pixels_Boost_Point : public bg::model::point<CoordinateType, DimensionCount, CoordinateSystem> {
 		public:
 			using Boost_Point_2::Boost_Point_2;
-			std::list<pixel_values_type> pinned_pixel;
+			PinnedPixels<pixel_values_type> pinned_pixel;
 		};
 		
 		template <typename pixel_values_type>
 		using Elementary_Pinned_Pixels_Boost_Point_2 = Elementary_Pinned_Pixels_Boost_Point<pixel_values_type, double, 2, bg::cs::cartesian>;
 		
 
-		// Extension of point class with a list of pixel values
+		// Extension of point class with a buffer of pixel values
 		/*template <typename pixel_values_type>
 		class Elementary_Pinned_Pixels_Boost_Point_2 : public bg::model::point<double, 2, bg::cs::cartesian> {
 		public:
 			using Boost_Point_2::Boost_Point_2;
 		public:
-			std::list<pixel_values_type> pinned_pixel;
+			PinnedPixels<pixel_values_type> pinned_pixel;
 		};*/
 		
 
@@ -43,28 +67,32 @@ namespace LxGeo
 		template <typename pixel_values_type>
 		using Elementary_Pinned_Pixels_Boost_Polygon_2 = bg::model::polygon<Elementary_Pinned_Pixels_Boost_Point_2<pixel_values_type>>;
 
-		/*Extension of a set of geometries with a list of pixel values for each structural elements (ex: rings for a polygon)*/
+		/*Extension of a set of geometries with a buffer of pixel values for each structural elements (ex: rings for a polygon)*/
 		template <typename pixel_values_type>
 		class Structural_Pinned_Pixels_Boost_Segment_2 : public Boost_Segment_2 {
-			std::list<pixel_values_type> pinned_pixel;
+		public:
+			PinnedPixels<pixel_values_type> pinned_pixel;
 		};
 		template <typename pixel_values_type>
 		class Structural_Pinned_Pixels_Boost_Box_2 : public Boost_Box_2 {
-			std::list<pixel_values_type> pinned_pixel;
+		public:
+			PinnedPixels<pixel_values_type> pinned_pixel;
 		};
 		template <typename pixel_values_type>
 		class Structural_Pinned_Pixels_Boost_LineString_2 : public Boost_LineString_2 {
-			std::list<pixel_values_type> pinned_pixel;
+		public:
+			PinnedPixels<pixel_values_type> pinned_pixel;
 		};
 		template <typename pixel_values_type>
 		class Structural_Pinned_Pixels_Boost_Ring_2 : public Boost_Ring_2 {
-			std::list<pixel_values_type> pinned_pixel;
+		public:
+			PinnedPixels<pixel_values_type> pinned_pixel;
 		};
 		template <typename pixel_values_type>
 		class Structural_Pinned_Pixels_Boost_Polygon_2 : public Boost_Polygon_2 {
 		public:
-			std::list<pixel_values_type> outer_pinned_pixel;
-			std::vector<std::list<pixel_values_type>> inners_pinned_pixels;
+			PinnedPixels<pixel_values_type> outer_pinned_pixel;
+			std::vector<PinnedPixels<pixel_values_type>> inners_pinned_pixels;
 		};
 
 	}
@@ -3,6 +3,7 @@
 #include "affine_geometry/affine_transformer.h"
 #include "lightweight/geoimage.h"
 #include "geometries_with_attributes/geometries_with_attributes.h"
+#include "geometry_rasterizer/polygon_scanline.h"
 #include "export_shared.h"
 
 namespace LxGeo
@@ -14,7 +15,8 @@ namespace LxGeo
 			vertex_and_mid_point = 1 << 1,
 			constant_walker = 1 << 2,
 			contours = 1 << 3,
-			filled_polygon = 1 << 4
+			filled_polygon = 1 << 4, // pixels whose center is inside the polygon
+			filled_polygon_all_touched = 1 << 5 // pixels intersecting the polygon interior
 		};
 
 		using namespace LxGeo::IO_DATA;
@@ -27,7 +29,7 @@ namespace LxGeo
 			{};
 			template <typename cv_pixel_type>
 			std::list<cv_pixel_type> readLineStringPixels(const Boost_LineString_2& resp_linestring, RasterPixelsStitcherStartegy strategy) {
-				std::list<cv_pixel_type> out_pixels_list;
+				std::list<cv_pixel_type> out_pixels;
 
 				Boost_Discrete_LineString_2 resp_linestring_pixel_coords = affine_transform_geometry<Boost_LineString_2, Boost_Discrete_LineString_2>(
 					resp_linestring, inv_transformer_matrix
@@ -41,7 +43,7 @@ namespace LxGeo
 						cv::LineIterator it(ref_gimg.image, st_pt, end_pt, 8);
 						if (*it != nullptr) {
 							for (int i = 0; i < it.count; i++, ++it) {
-								out_pixels_list.push_back(ref_gimg.image.at<cv_pixel_type>(it.pos()));
+								out_pixels.push_back(ref_gimg.image.at<cv_pixel_type>(it.pos()));
 							}
 						}
 						pts_iter++;
@@ -51,21 +53,21 @@ namespace LxGeo
 				else
 					throw std::exception("Only contours strategy is implemented for linestring!");
 
-				return out_pixels_list;
+				return out_pixels;
 
 			}
 			
 			template <typename cv_pixel_type>
-			std::list<cv_pixel_type> readPolygonPixels(const Boost_Polygon_2& resp_polygon, RasterPixelsStitcherStartegy strategy) {
+			std::vector<cv_pixel_type> readPolygonPixels(const Boost_Polygon_2& resp_polygon, RasterPixelsStitcherStartegy strategy) {
 
-				std::list<cv_pixel_type> out_pixels_list;
-
-				Boost_Discrete_Polygon_2 resp_polygon_pixel_coords = affine_transform_geometry<Boost_Polygon_2, Boost_Discrete_Polygon_2>(
-					resp_polygon, inv_transformer_matrix
-					);
+				std::vector<cv_pixel_type> out_pixels;
 
 				if (strategy == RasterPixelsStitcherStartegy::contours) {
 
+					Boost_Discrete_Polygon_2 resp_polygon_pixel_coords = affine_transform_geometry<Boost_Polygon_2, Boost_Discrete_Polygon_2>(
+						resp_polygon, inv_transformer_matrix
+						);
+
 					// creating a list of all rings (outer and inners)
 					std::list<Boost_Discrete_Ring_2*> polygons_rings_pixels_coords;
 					polygons_rings_pixels_coords.push_back(&resp_polygon_pixel_coords.outer());
@@ -80,7 +82,7 @@ namespace LxGeo
 							cv::LineIterator it(ref_gimg.image, st_pt, end_pt, 8);
 							if (*it != nullptr) {
 								for (int i = 0; i < it.count; i++, ++it) {
-									out_pixels_list.push_back(ref_gimg.image.at<cv_pixel_type>(it.pos()));
+									out_pixels.push_back(ref_gimg.image.at<cv_pixel_type>(it.pos()));
 								}
 							}
 							pts_iter++;
@@ -88,60 +90,23 @@ namespace LxGeo
 					}					
 				}
 
-				else if (strategy == RasterPixelsStitcherStartegy::filled_polygon) {
-
-					auto ring_pixels_aggregator = [](std::list<cv_pixel_type>& values_list) -> float {
-						// (temporary) returns sum with nan turned to max_val
-						int null_count = 0;
-						float max_val = 0.0;
-						float sum = 0.0;
-
-						for (auto& c_pixel : values_list) {
-							float c_val = c_pixel;
-							if (isnan(c_val)) null_count += 1;
-							else {
-								sum += c_val;
-								if (c_val > max_val) max_val = c_val;
-							}
-						}
-						return sum + max_val * null_count;
-					};
-
-					Boost_Discrete_Box_2 envelop;
-					boost::geometry::envelope(resp_polygon_pixel_coords, envelop);
-					Boost_Discrete_Point_2 min_pixel_corner = envelop.min_corner();
-					Boost_Discrete_Point_2 max_pixel_corner = envelop.max_corner();
-
-					for (size_t c_row = min_pixel_corner.get<1>(); c_row <= max_pixel_corner.get<1>(); c_row++) {
-
-						if (c_row < 0 || c_row >= ref_gimg.image.rows)
-							continue;
-
-						for (size_t c_col = min_pixel_corner.get<0>(); c_col <= max_pixel_corner.get<0>(); c_col++) {
-
-							if (c_col < 0 || c_col >= ref_gimg.image.cols)
-								continue;
-
-							cv::Point c_pos(c_col, c_row);
-							Boost_Discrete_Point_2 c_p(c_col, c_row);
-
-							// within exterior ring
-							if (boost::geometry::within(c_p, resp_polygon_pixel_coords.outer())) {
-								bool is_within_hole = false;
-								for (size_t c_ring_idx = 0; c_ring_idx < resp_polygon_pixel_coords.inners().size(); c_ring_idx++) {
-									auto& c_interior_ring = resp_polygon_pixel_coords.inners()[c_ring_idx];
-									// within interior ring
-									if (boost::geometry::within(c_p, c_interior_ring))
-									{
-										//loaded_pixels.push_back(ref_gimg.image.ptr<pixel_type>(c_row)[c_col]);
-										is_within_hole = true;
-										break;
-									}
-								}
-								if (!is_within_hole)
-									out_pixels_list.push_back(ref_gimg.image.at<cv_pixel_type>(c_row,c_col));
-							}
-						}
+				else if (strategy == RasterPixelsStitcherStartegy::filled_polygon || strategy == RasterPixelsStitcherStartegy::filled_polygon_all_touched) {
+
+					// scanline rasterization in continuous pixel coordinates, pixels are copied run by run from the image rows
+					Boost_Polygon_2 resp_polygon_pixel_coords = affine_transform_geometry<Boost_Polygon_2, Boost_Polygon_2>(
+						resp_polygon, inv_transformer_matrix
+						);
+					// per thread buffer reused between polygons (concurrent reads share no state)
+					thread_local std::vector<PixelRun> pixel_runs;
+					polygon_pixel_runs(resp_polygon_pixel_coords, ref_gimg.image.rows, ref_gimg.image.cols,
+						strategy == RasterPixelsStitcherStartegy::filled_polygon_all_touched, pixel_runs);
+
+					size_t pixels_count = 0;
+					for (const PixelRun& c_run : pixel_runs) pixels_count += c_run.length();
+					out_pixels.reserve(pixels_count);
+					for (const PixelRun& c_run : pixel_runs) {
+						const cv_pixel_type* c_row_values = ref_gimg.image.ptr<cv_pixel_type>(c_run.row);
+						out_pixels.insert(out_pixels.end(), c_row_values + c_run.col_begin, c_row_values + c_run.col_end);
 					}
 
 				}
@@ -149,7 +114,7 @@ namespace LxGeo
 				else
 					throw std::exception("Only contours and filled_polygon strategies are implemented!");
 
-				return out_pixels_list;
+				return out_pixels;
 			}
 
 		public:
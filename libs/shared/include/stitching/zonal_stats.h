@@ -0,0 +1,356 @@
+#pragma once
+#include "defs.h"
+#include "affine_geometry/affine_transformer.h"
+#include "lightweight/geoimage.h"
+#include "lightweight/geovector.h"
+#include "gdal_dataset_pool.h"
+#include "GDAL_OPENCV_IO.h"
+#include "geometry_rasterizer/polygon_scanline.h"
+#include "numcpp/streaming_stats.h"
+#include "design_pattern/parallel_for.h"
+#include <array>
+#include <sstream>
+
+namespace LxGeo
+{
+	namespace GeometryFactoryShared
+	{
+
+		enum class ZonalStat {
+			count,
+			nodata_count,
+			sum,
+			min,
+			max,
+			mean,
+			variance,
+			stdev
+		};
+
+		struct ZonalStatsOptions {
+			std::vector<ZonalStat> stats = { ZonalStat::count, ZonalStat::mean };
+			std::vector<double> percentiles; // in [0, 100], read from per polygon histograms
+			std::string fields_prefix; // prefix of the written fields names
+			int band = 0; // image channel
+			std::optional<double> nodata; // defaults to the image no_data (NaN values are always null)
+			bool all_touched = false; // pixels intersecting polygons instead of pixels centered in polygons
+			size_t histogram_bins = 256;
+			std::optional<std::pair<double, double>> histogram_range; // defaults to the band values range
+			size_t n_threads = 0; // polygons are split across threads (0: hardware concurrency)
+		};
+
+		inline std::string zonal_stat_name(ZonalStat stat) {
+			switch (stat) {
+			case ZonalStat::count: return "count";
+			case ZonalStat::nodata_count: return "nodata_count";
+			case ZonalStat::sum: return "sum";
+			case ZonalStat::min: return "min";
+			case ZonalStat::max: return "max";
+			case ZonalStat::mean: return "mean";
+			case ZonalStat::variance: return "variance";
+			case ZonalStat::stdev: return "stdev";
+			}
+			throw std::runtime_error("Unknown zonal statistic!");
+		}
+
+		// Output fields names: stats then percentiles (p50, p2.5 ...)
+		inline std::vector<std::string> zonal_stats_fields(const ZonalStatsOptions& options) {
+			std::vector<std::string> fields_names;
+			for (ZonalStat c_stat : options.stats)
+				fields_names.push_back(options.fields_prefix + zonal_stat_name(c_stat));
+			for (double c_percentile : options.percentiles) {
+				std::ostringstream percentile_name; percentile_name << "p" << c_percentile;
+				fields_names.push_back(options.fields_prefix + percentile_name.str());
+			}
+			return fields_names;
+		}
+
+		/**
+		Empty accumulator of the options statistics for values within [min_value, max_value]: a histogram is only set up when percentiles
+		are requested. Without histogram_range, integer values get one unit bins centered on integers when the range fits in
+		histogram_bins (exact percentiles).
+		*/
+		inline numcpp::StreamingStats zonal_stats_accumulator(const ZonalStatsOptions& options, double min_value, double max_value, bool integer_values) {
+			if (options.percentiles.empty())
+				return numcpp::StreamingStats();
+			if (options.histogram_range)
+				return numcpp::StreamingStats(options.histogram_range->first, options.histogram_range->second, options.histogram_bins);
+
+			if (integer_values) {
+				size_t values_count = static_cast<size_t>(max_value - min_value) + 1;
+				if (values_count <= options.histogram_bins)
+					return numcpp::StreamingStats(min_value - 0.5, max_value + 0.5, values_count);
+			}
+			if (!(max_value > min_value))
+				max_value = min_value + 1;
+			return numcpp::StreamingStats(min_value, max_value, options.histogram_bins);
+		}
+
+		// Empty accumulator for values of image (band), the band values range (nodata excluded) is scanned when a histogram is needed
+		inline numcpp::StreamingStats zonal_stats_accumulator(const cv::Mat& image, const ZonalStatsOptions& options, std::optional<double> nodata) {
+			if (options.percentiles.empty() || options.histogram_range)
+				return zonal_stats_accumulator(options, 0, 0, false);
+
+			cv::Mat band_values;
+			if (image.channels() > 1)
+				cv::extractChannel(image, band_values, options.band);
+			else
+				band_values = image;
+			cv::Mat valid_mask = (band_values == band_values); // NaN
+			if (nodata)
+				valid_mask &= (band_values != *nodata);
+			double min_value = 0, max_value = 0;
+			if (cv::countNonZero(valid_mask) > 0)
+				cv::minMaxLoc(band_values, &min_value, &max_value, nullptr, nullptr, valid_mask);
+			return zonal_stats_accumulator(options, min_value, max_value, image.depth() != CV_32F && image.depth() != CV_64F);
+		}
+
+		// Adds the band values of the pixels runs to accumulator (NaN and nodata values are counted as null)
+		inline void accumulate_pixel_runs(const cv::Mat& image, int band, std::optional<double> nodata, const std::vector<PixelRun>& runs, numcpp::StreamingStats& accumulator) {
+			auto accumulate_typed = [&]<typename pixel_type>(pixel_type) {
+				int channels = image.channels();
+				for (const PixelRun& c_run : runs) {
+					const pixel_type* c_values = image.ptr<pixel_type>(c_run.row) + c_run.col_begin * channels + band;
+					for (int c_col = c_run.col_begin; c_col < c_run.col_end; c_col++, c_values += channels) {
+						double c_value = static_cast<double>(*c_values);
+						if (std::isnan(c_value) || (nodata && c_value == *nodata))
+							accumulator.add_null();
+						else
+							accumulator.add(c_value);
+					}
+				}
+			};
+			switch (image.depth()) {
+			case CV_8U: accumulate_typed(uint8_t()); break;
+			case CV_8S: accumulate_typed(int8_t()); break;
+			case CV_16U: accumulate_typed(uint16_t()); break;
+			case CV_16S: accumulate_typed(int16_t()); break;
+			case CV_32S: accumulate_typed(int32_t()); break;
+			case CV_32F: accumulate_typed(float()); break;
+			case CV_64F: accumulate_typed(double()); break;
+			default: throw std::runtime_error("Unsupported image depth for zonal statistics!");
+			}
+		}
+
+		// Writes the options statistics of accumulator to out_values (zonal_stats_fields order)
+		inline void zonal_stats_values(const numcpp::StreamingStats& accumulator, const ZonalStatsOptions& options, double* out_values) {
+			for (ZonalStat c_stat : options.stats) {
+				switch (c_stat) {
+				case ZonalStat::count: *out_values++ = double(accumulator.count()); break;
+				case ZonalStat::nodata_count: *out_values++ = double(accumulator.count_null()); break;
+				case ZonalStat::sum: *out_values++ = accumulator.sum(); break;
+				case ZonalStat::min: *out_values++ = accumulator.min(); break;
+				case ZonalStat::max: *out_values++ = accumulator.max(); break;
+				case ZonalStat::mean: *out_values++ = accumulator.mean(); break;
+				case ZonalStat::variance: *out_values++ = accumulator.variance(); break;
+				case ZonalStat::stdev: *out_values++ = accumulator.stdev(); break;
+				}
+			}
+			for (double c_percentile : options.percentiles)
+				*out_values++ = accumulator.percentile(c_percentile);
+		}
+
+		// Writes a row major matrix of values (one row per geometry) as double fields of the geometries (NaN values are null)
+		template <typename rtree_parameters>
+		void write_zonal_stats(IO_DATA::GeoVector<Boost_Polygon_2, rtree_parameters>& gvec, const std::vector<std::string>& fields_names, const std::vector<double>& values) {
+			if (gvec.length() == 0)
+				return;
+			gvec.compact_attributes();
+			AttributeTable& table = *gvec.attributes();
+			size_t fields_count = fields_names.size();
+			for (size_t field_idx = 0; field_idx < fields_count; field_idx++) {
+				auto existing_field = table.find_field(fields_names[field_idx], AttributeType::real);
+				field_id fid = existing_field ? *existing_field : table.add_field(fields_names[field_idx], AttributeType::real);
+				for (size_t geom_idx = 0; geom_idx < gvec.length(); geom_idx++) {
+					size_t c_row = gvec.geometries_container[geom_idx].get_attributes_row();
+					double c_value = values[geom_idx * fields_count + field_idx];
+					if (std::isnan(c_value))
+						table.set_null(c_row, fid);
+					else
+						table.set_double(c_row, fid, c_value);
+				}
+			}
+		}
+
+		/**
+		Zonal statistics of every polygon of gvec over gimg, written as double fields of gvec (see zonal_stats_fields).
+		Each polygon is rasterized to pixels runs (polygon_pixel_runs) and its values are streamed into an accumulator,
+		no pixel values are stored. Polygons are split across threads, each with its own runs buffer and accumulator.
+		Returns the written fields names.
+		*/
+		template <typename rtree_parameters>
+		std::vector<std::string> zonal_stats(IO_DATA::GeoVector<Boost_Polygon_2, rtree_parameters>& gvec, const IO_DATA::GeoImage<cv::Mat>& gimg, const ZonalStatsOptions& options) {
+			if (options.band < 0 || options.band >= gimg.image.channels())
+				throw std::runtime_error("Zonal statistics band is out of the image channels!");
+			std::optional<double> nodata = options.nodata ? options.nodata : gimg.no_data;
+			std::vector<std::string> fields_names = zonal_stats_fields(options);
+			size_t fields_count = fields_names.size();
+			std::vector<double> values(gvec.length() * fields_count);
+
+			const numcpp::StreamingStats empty_accumulator = zonal_stats_accumulator(gimg.image, options, nodata);
+			const auto inv_transformer_matrix = geotransform_to_inv_matrix_transformer(gimg.geotransform);
+			parallel_for_chunks(gvec.length(), options.n_threads, [&](size_t geoms_begin, size_t geoms_end) {
+				std::vector<PixelRun> pixel_runs;
+				numcpp::StreamingStats accumulator = empty_accumulator;
+				for (size_t geom_idx = geoms_begin; geom_idx < geoms_end; geom_idx++) {
+					Boost_Polygon_2 polygon_pixel_coords = affine_transform_geometry<Boost_Polygon_2, Boost_Polygon_2>(
+						gvec.geometries_container[geom_idx].get_definition(), inv_transformer_matrix
+						);
+					polygon_pixel_runs(polygon_pixel_coords, gimg.image.rows, gimg.image.cols, options.all_touched, pixel_runs);
+					accumulator.reset();
+					accumulate_pixel_runs(gimg.image, options.band, nodata, pixel_runs, accumulator);
+					zonal_stats_values(accumulator, options, values.data() + geom_idx * fields_count);
+				}
+				});
+
+			write_zonal_stats(gvec, fields_names, values);
+			return fields_names;
+		}
+
+		/**
+		Zonal statistics of every polygon of gvec over the raster at raster_path, without loading the raster (see zonal_stats).
+		The raster is read by tiles of whole blocks (at least min_tile_size pixels per side), one band only, in row major order:
+		each tile is read once and released before the next one. Candidate polygons of a tile are queried from gvec rtree and
+		rasterized in tile pixel coordinates (polygons pixels are the same as on the full raster). Partial accumulators of
+		polygons spanning several tiles are merged in tiles order and released after their last tile, memory is thus bounded
+		by one tile and the accumulators of the polygons crossing it.
+		Without histogram_range, percentiles histograms span the data type range (8 bits) or the approximate band range.
+		*/
+		template <typename rtree_parameters>
+		std::vector<std::string> zonal_stats(IO_DATA::GeoVector<Boost_Polygon_2, rtree_parameters>& gvec, const std::string& raster_path, const ZonalStatsOptions& options, int min_tile_size = 512) {
+			std::shared_ptr<GDALDataset> raster_dataset = IO_DATA::GDALDatasetPool::instance().acquire(raster_path);
+			if (options.band < 0 || options.band >= raster_dataset->GetRasterCount())
+				throw std::runtime_error("Zonal statistics band is out of the raster bands!");
+			GDALRasterBand* raster_band = raster_dataset->GetRasterBand(options.band + 1);
+			int raster_width = raster_dataset->GetRasterXSize(), raster_height = raster_dataset->GetRasterYSize();
+			GDALDataType data_type = raster_band->GetRasterDataType();
+			int tile_type = KGDAL2CV().gdal2opencv(data_type, 1);
+			if (tile_type == -1)
+				throw std::runtime_error("Raster data type is not supported by zonal statistics!");
+
+			double geotransform[6];
+			if (raster_dataset->GetGeoTransform(geotransform) != CE_None)
+				throw std::runtime_error("Zonal statistics raster has no geotransform!");
+			std::optional<double> nodata = options.nodata;
+			int raster_has_nodata;
+			double raster_nodata = raster_band->GetNoDataValue(&raster_has_nodata);
+			if (!nodata && raster_has_nodata)
+				nodata = raster_nodata;
+
+			numcpp::StreamingStats empty_accumulator;
+			if (options.percentiles.empty() || options.histogram_range)
+				empty_accumulator = zonal_stats_accumulator(options, 0, 0, false);
+			else if (data_type == GDT_Byte)
+				empty_accumulator = zonal_stats_accumulator(options, 0, 255, true);
+			else {
+				double min_max[2] = { 0, 0 };
+				raster_band->ComputeRasterMinMax(TRUE, min_max);
+				empty_accumulator = zonal_stats_accumulator(options, min_max[0], min_max[1], GDALDataTypeIsInteger(data_type));
+			}
+
+			std::vector<std::string> fields_names = zonal_stats_fields(options);
+			size_t fields_count = fields_names.size();
+			std::vector<double> values(gvec.length() * fields_count);
+			// polygons outside the raster keep empty statistics
+			for (size_t geom_idx = 0; geom_idx < gvec.length(); geom_idx++)
+				zonal_stats_values(empty_accumulator, options, values.data() + geom_idx * fields_count);
+
+			// tiles of whole blocks (strips are grouped by rows)
+			int block_width, block_height;
+			raster_band->GetBlockSize(&block_width, &block_height);
+			int tile_width = block_width * std::max(1, (min_tile_size + block_width - 1) / block_width);
+			int tile_height = block_height * std::max(1, (min_tile_size + block_height - 1) / block_height);
+			int tiles_cols = (raster_width + tile_width - 1) / tile_width, tiles_rows = (raster_height + tile_height - 1) / tile_height;
+
+			const auto inv_transformer_matrix = geotransform_to_inv_matrix_transformer(geotransform);
+			const auto transformer_matrix = geotransform_to_matrix_transformer(geotransform);
+
+			std::map<size_t, numcpp::StreamingStats> spanning_accumulators; // polygons crossing the tiles already read
+			std::multimap<size_t, size_t> last_tiles; // (last tile index, polygon) of spanning polygons
+			std::vector<bool> finalized(gvec.length(), false); // envelopes touching a later tile add no pixel
+			cv::Mat tile_values;
+			std::vector<typename IO_DATA::GeoVector<Boost_Polygon_2, rtree_parameters>::Boost_Value> candidates;
+			for (int tile_row = 0; tile_row < tiles_rows; tile_row++) {
+				for (int tile_col = 0; tile_col < tiles_cols; tile_col++) {
+					size_t tile_idx = size_t(tile_row) * tiles_cols + tile_col;
+					cv::Rect tile_rect(tile_col * tile_width, tile_row * tile_height,
+						std::min(tile_width, raster_width - tile_col * tile_width), std::min(tile_height, raster_height - tile_row * tile_height));
+
+					// candidates intersecting the tile spatial envelope, in polygons order
+					const std::array<std::pair<int, int>, 4> tile_corners = { { { tile_rect.x, tile_rect.y }, { tile_rect.x + tile_rect.width, tile_rect.y },
+						{ tile_rect.x + tile_rect.width, tile_rect.y + tile_rect.height }, { tile_rect.x, tile_rect.y + tile_rect.height } } };
+					Boost_Polygon_2 tile_polygon;
+					for (auto [c_col, c_row] : tile_corners) {
+						Boost_Point_2 c_corner;
+						bg::transform(Boost_Point_2(c_col, c_row), c_corner, transformer_matrix);
+						bg::append(tile_polygon.outer(), c_corner);
+					}
+					Boost_Box_2 tile_envelope;
+					bg::envelope(tile_polygon, tile_envelope);
+					candidates.clear();
+					gvec.rtree.query(bgi::intersects(tile_envelope), std::back_inserter(candidates));
+					std::erase_if(candidates, [&finalized](const auto& c_candidate) { return finalized[c_candidate.second]; });
+					if (candidates.empty())
+						continue;
+					std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+
+					tile_values.create(tile_rect.height, tile_rect.width, tile_type);
+					if (raster_band->RasterIO(GF_Read, tile_rect.x, tile_rect.y, tile_rect.width, tile_rect.height, tile_values.data, tile_rect.width, tile_rect.height,
+						KGDAL2CV::opencv2gdal(tile_type), static_cast<GSpacing>(tile_values.elemSize()), static_cast<GSpacing>(tile_values.step[0]), nullptr) != CE_None)
+						throw std::runtime_error("Unable to read a tile of the zonal statistics raster!");
+
+					// tile partial accumulators (one per candidate)
+					std::vector<numcpp::StreamingStats> tile_accumulators(candidates.size(), empty_accumulator);
+					std::vector<size_t> candidates_last_tile(candidates.size());
+					parallel_for_chunks(candidates.size(), options.n_threads, [&](size_t candidates_begin, size_t candidates_end) {
+						std::vector<PixelRun> pixel_runs;
+						for (size_t candidate_idx = candidates_begin; candidate_idx < candidates_end; candidate_idx++) {
+							Boost_Polygon_2 polygon_pixel_coords = affine_transform_geometry<Boost_Polygon_2, Boost_Polygon_2>(
+								gvec.geometries_container[candidates[candidate_idx].second].get_definition(), inv_transformer_matrix
+								);
+							Boost_Box_2 pixel_envelope;
+							bg::envelope(polygon_pixel_coords, pixel_envelope);
+							int last_tile_col = std::clamp(int(std::floor(std::min(pixel_envelope.max_corner().get<0>(), double(raster_width)) / tile_width)), 0, tiles_cols - 1);
+							int last_tile_row = std::clamp(int(std::floor(std::min(pixel_envelope.max_corner().get<1>(), double(raster_height)) / tile_height)), 0, tiles_rows - 1);
+							candidates_last_tile[candidate_idx] = size_t(last_tile_row) * tiles_cols + last_tile_col;
+
+							Boost_Polygon_2 polygon_tile_coords = translate_geometry(polygon_pixel_coords, std::make_pair(-double(tile_rect.x), -double(tile_rect.y)));
+							polygon_pixel_runs(polygon_tile_coords, tile_rect.height, tile_rect.width, options.all_touched, pixel_runs);
+							accumulate_pixel_runs(tile_values, 0, nodata, pixel_runs, tile_accumulators[candidate_idx]);
+						}
+						});
+
+					// merge partial accumulators in tiles order
+					for (size_t candidate_idx = 0; candidate_idx < candidates.size(); candidate_idx++) {
+						size_t geom_idx = candidates[candidate_idx].second;
+						auto spanning_it = spanning_accumulators.find(geom_idx);
+						if (spanning_it != spanning_accumulators.end())
+							spanning_it->second.merge(tile_accumulators[candidate_idx]);
+						else if (candidates_last_tile[candidate_idx] > tile_idx) {
+							spanning_accumulators.emplace(geom_idx, std::move(tile_accumulators[candidate_idx]));
+							last_tiles.emplace(candidates_last_tile[candidate_idx], geom_idx);
+						}
+						else {
+							zonal_stats_values(tile_accumulators[candidate_idx], options, values.data() + geom_idx * fields_count);
+							finalized[geom_idx] = true;
+						}
+					}
+					// polygons whose last tile is read
+					for (auto last_it = last_tiles.begin(); last_it != last_tiles.end() && last_it->first <= tile_idx; last_it = last_tiles.erase(last_it)) {
+						auto spanning_it = spanning_accumulators.find(last_it->second);
+						zonal_stats_values(spanning_it->second, options, values.data() + last_it->second * fields_count);
+						spanning_accumulators.erase(spanning_it);
+						finalized[last_it->second] = true;
+					}
+				}
+			}
+			// spanning polygons missed by their last tile envelope query
+			for (auto& [geom_idx, c_accumulator] : spanning_accumulators)
+				zonal_stats_values(c_accumulator, options, values.data() + geom_idx * fields_count);
+
+			write_zonal_stats(gvec, fields_names, values);
+			return fields_names;
+		}
+
+	}
+}
@@ -246,8 +246,9 @@ namespace LxGeo
                     c_gwa.set_definition(c_geom);
                     c_gwa.set_int_attribute("pid", c_edge->curve().data().front().parent_id);
                     c_gwa.set_double_attribute("pos", c_edge->curve().data().front().position);
-                    out_gvec.add_geometry(c_gwa);
+                    out_gvec.geometries_container.push_back(c_gwa);
                 }
+                out_gvec.init_rtree();
                 return out_gvec;
             }
 
@@ -271,8 +272,9 @@ namespace LxGeo
                     c_gwa.set_definition(c_geom);
                     c_gwa.set_int_attribute("pid", edge_data.parent_id);
                     c_gwa.set_double_attribute("pos", edge_data.position);
-                    out_gvec.add_geometry(c_gwa);
+                    out_gvec.geometries_container.push_back(c_gwa);
                 }
+                out_gvec.init_rtree();
                 return out_gvec;
             }
 
@@ -76,43 +76,39 @@ namespace LxGeo
 			return aux_ogr_ring;
 		}
 
+		// Boost points and OGR raw points share the same layout: point arrays are copied at once into pre-sized containers
+		static_assert(sizeof(Boost_Point_2) == sizeof(OGRRawPoint), "Boost and OGR points layouts differ");
+
+		template <typename boost_points_container>
+		static void copy_OGR2B_points(const OGRSimpleCurve* ogr_curve, boost_points_container& out_points) {
+			out_points.resize(ogr_curve->getNumPoints());
+			if (!out_points.empty())
+				ogr_curve->getPoints(reinterpret_cast<OGRRawPoint*>(out_points.data()));
+		}
+
+		template <typename boost_points_container>
+		static void copy_B2OGR_points(const boost_points_container& in_points, OGRSimpleCurve& out_curve) {
+			out_curve.setPoints(static_cast<int>(in_points.size()), reinterpret_cast<const OGRRawPoint*>(in_points.data()));
+		}
+
 		Boost_Polygon_2 transform_OGR2B_Polygon(OGRPolygon* ogr_polygon) {
 			Boost_Polygon_2 aux_boost_polygon;
 
 			// fill exterior
 			OGRLinearRing* exterior_ring = ogr_polygon->getExteriorRing();
-			for (size_t v_idx = 0; v_idx < exterior_ring->getNumPoints(); ++v_idx) {
-				OGRPoint pt;
-				exterior_ring->getPoint(v_idx, &pt);
-				double x = pt.getX(), y = pt.getY();
-				aux_boost_polygon.outer().push_back(Boost_Point_2(x, y));
-			}
+			if (exterior_ring == nullptr) return aux_boost_polygon;
+			copy_OGR2B_points(exterior_ring, aux_boost_polygon.outer());
 			// fill interior
-			for (size_t int_ring_idx = 0; int_ring_idx < ogr_polygon->getNumInteriorRings(); ++int_ring_idx) {
-				OGRLinearRing* c_int_ring = ogr_polygon->getInteriorRing(int_ring_idx);
-				Boost_Ring_2 R;
-				int ring_size = c_int_ring->getNumPoints();
-				R.reserve(ring_size);
-				for (int u = 0; u < ring_size; ++u) { //-1
-					OGRPoint pt;
-					c_int_ring->getPoint(u, &pt);
-					double x = pt.getX(), y = pt.getY();
-					//CT->Transform(1, &x, &y);
-					R.push_back(Boost_Point_2(x, y));
-				}
-				aux_boost_polygon.inners().push_back(R);
-			}
+			aux_boost_polygon.inners().resize(ogr_polygon->getNumInteriorRings());
+			for (size_t int_ring_idx = 0; int_ring_idx < aux_boost_polygon.inners().size(); ++int_ring_idx)
+				copy_OGR2B_points(ogr_polygon->getInteriorRing(int_ring_idx), aux_boost_polygon.inners()[int_ring_idx]);
 			return aux_boost_polygon;
 
 		}
 
 		Boost_LineString_2 transform_OGR2B_Linestring(OGRLineString* ogr_linestring) {
 			Boost_LineString_2 aux_boost_linestring;
-			for (size_t v_idx = 0; v_idx < ogr_linestring->getNumPoints(); ++v_idx) {
-				OGRPoint pt;
-				ogr_linestring->getPoint(v_idx, &pt);
-				aux_boost_linestring.push_back(transform_OGR2B_Point(&pt));
-			}
+			copy_OGR2B_points(ogr_linestring, aux_boost_linestring);
 			return aux_boost_linestring;
 		}
 
@@ -158,19 +154,13 @@ namespace LxGeo
 
 		OGRLinearRing transform_B2OGR_LinearRing(const Boost_Ring_2& in_ring) {
 			OGRLinearRing ogr_linering;
-			for (const Boost_Point_2& c_pt : in_ring) {
-				OGRPoint c_ogr_point = transform_B2OGR_Point(c_pt);
-				ogr_linering.addPoint(&c_ogr_point);
-			}
+			copy_B2OGR_points(in_ring, ogr_linering);
 			return ogr_linering;
 		}
 
 		OGRLinearRing transform_B2OGR_Ring(const Boost_Ring_2& in_ring) {
 			OGRLinearRing ogr_ring;
-			for (const Boost_Point_2& c_pt : in_ring) {
-				OGRPoint c_ogr_point = transform_B2OGR_Point(c_pt);
-				ogr_ring.addPoint(&c_ogr_point);
-			}
+			copy_B2OGR_points(in_ring, ogr_ring);
 			return ogr_ring;
 		}
 
@@ -194,10 +184,7 @@ namespace LxGeo
 
 		OGRLineString transform_B2OGR_LineString(const Boost_LineString_2& in_linestring) {
 			OGRLineString out_linestring;
-			for (auto& c_pt : in_linestring) {
-				OGRPoint c_ogr_point = transform_B2OGR_Point(c_pt);
-				out_linestring.addPoint(&c_ogr_point);
-			}
+			copy_B2OGR_points(in_linestring, out_linestring);
 			return out_linestring;
 		}
 
@@ -0,0 +1,123 @@
+#include "geometry_rasterizer/polygon_scanline.h"
+
+
+namespace LxGeo
+{
+	namespace GeometryFactoryShared
+	{
+
+		// Calls edge_fn(start, end) for every edge of the polygon rings
+		template <typename edge_fn_type>
+		static void for_each_polygon_edge(const Boost_Polygon_2& polygon, edge_fn_type&& edge_fn) {
+			auto ring_edges = [&edge_fn](const Boost_Ring_2& c_ring) {
+				for (size_t point_idx = 0; point_idx + 1 < c_ring.size(); point_idx++)
+					edge_fn(c_ring[point_idx], c_ring[point_idx + 1]);
+				// open rings
+				if (c_ring.size() > 2 && !bg::equals(c_ring.front(), c_ring.back()))
+					edge_fn(c_ring.back(), c_ring.front());
+			};
+			ring_edges(polygon.outer());
+			for (const auto& c_inner : polygon.inners())
+				ring_edges(c_inner);
+		}
+
+		// Sorts runs by row then column and merges overlapping or adjacent runs of a row
+		static void merge_pixel_runs(std::vector<PixelRun>& runs) {
+			std::sort(runs.begin(), runs.end(), [](const PixelRun& a, const PixelRun& b) { return std::tie(a.row, a.col_begin) < std::tie(b.row, b.col_begin); });
+			size_t out_idx = 0;
+			for (size_t run_idx = 0; run_idx < runs.size(); run_idx++) {
+				if (out_idx > 0 && runs[out_idx - 1].row == runs[run_idx].row && runs[run_idx].col_begin <= runs[out_idx - 1].col_end)
+					runs[out_idx - 1].col_end = std::max(runs[out_idx - 1].col_end, runs[run_idx].col_end);
+				else
+					runs[out_idx++] = runs[run_idx];
+			}
+			runs.resize(out_idx);
+		}
+
+		void polygon_pixel_runs(const Boost_Polygon_2& pixel_polygon, int rows, int cols, bool all_touched, std::vector<PixelRun>& out_runs) {
+			out_runs.clear();
+			if (pixel_polygon.outer().size() < 3 || rows <= 0 || cols <= 0)
+				return;
+
+			// coordinates are clamped next to the raster before integer conversions
+			auto clamp_x = [cols](double x) { return std::clamp(x, -1.0, cols + 1.0); };
+			auto clamp_y = [rows](double y) { return std::clamp(y, -1.0, rows + 1.0); };
+
+			Boost_Box_2 envelop;
+			bg::envelope(pixel_polygon, envelop);
+			int row_min = std::max(0, int(std::floor(clamp_y(envelop.min_corner().get<1>()))));
+			int row_max = std::min(rows - 1, int(std::floor(clamp_y(envelop.max_corner().get<1>()))));
+			if (row_min > row_max || envelop.max_corner().get<0>() < 0 || envelop.min_corner().get<0>() >= cols)
+				return;
+			size_t n_rows = row_max - row_min + 1;
+
+			// rows of an edge whose center line (row + 0.5) lies in [min y, max y) (half open: shared vertices are counted once)
+			auto crossed_rows = [row_min, row_max, &clamp_y](double y_a, double y_b) {
+				double y_low = clamp_y(std::min(y_a, y_b)), y_high = clamp_y(std::max(y_a, y_b));
+				int first_row = std::max(row_min, int(std::ceil(y_low - 0.5)));
+				int last_row = std::min(row_max, int(std::ceil(y_high - 0.5)) - 1);
+				return std::make_pair(first_row, last_row);
+			};
+
+			// crossings of each row center line, stored by row (counting pass then filling pass)
+			std::vector<size_t> row_offsets(n_rows + 1, 0);
+			for_each_polygon_edge(pixel_polygon, [&](const Boost_Point_2& p_a, const Boost_Point_2& p_b) {
+				auto [first_row, last_row] = crossed_rows(p_a.get<1>(), p_b.get<1>());
+				for (int c_row = first_row; c_row <= last_row; c_row++)
+					row_offsets[c_row - row_min + 1]++;
+				});
+			for (size_t row_idx = 0; row_idx < n_rows; row_idx++)
+				row_offsets[row_idx + 1] += row_offsets[row_idx];
+
+			std::vector<double> crossings(row_offsets[n_rows]);
+			std::vector<size_t> next_position(row_offsets.begin(), row_offsets.end() - 1);
+			for_each_polygon_edge(pixel_polygon, [&](const Boost_Point_2& p_a, const Boost_Point_2& p_b) {
+				auto [first_row, last_row] = crossed_rows(p_a.get<1>(), p_b.get<1>());
+				if (first_row > last_row)
+					return;
+				double inv_slope = (p_b.get<0>() - p_a.get<0>()) / (p_b.get<1>() - p_a.get<1>());
+				for (int c_row = first_row; c_row <= last_row; c_row++)
+					crossings[next_position[c_row - row_min]++] = p_a.get<0>() + (c_row + 0.5 - p_a.get<1>()) * inv_slope;
+				});
+
+			// pixels whose center is in [x_in, x_out)
+			for (size_t row_idx = 0; row_idx < n_rows; row_idx++) {
+				auto row_begin = crossings.begin() + row_offsets[row_idx], row_end = crossings.begin() + row_offsets[row_idx + 1];
+				std::sort(row_begin, row_end);
+				for (auto c_crossing = row_begin; c_crossing + 1 < row_end; c_crossing += 2) {
+					int col_begin = std::max(0, int(std::ceil(clamp_x(*c_crossing) - 0.5)));
+					int col_end = std::min(cols, int(std::ceil(clamp_x(*(c_crossing + 1)) - 0.5)));
+					if (col_begin < col_end)
+						out_runs.push_back({ row_min + int(row_idx), col_begin, col_end });
+				}
+			}
+
+			if (!all_touched)
+				return;
+
+			// pixels crossed by the boundary: x extent of each edge within each row strip [row, row + 1]
+			for_each_polygon_edge(pixel_polygon, [&](const Boost_Point_2& p_a, const Boost_Point_2& p_b) {
+				double y_low = clamp_y(std::min(p_a.get<1>(), p_b.get<1>())), y_high = clamp_y(std::max(p_a.get<1>(), p_b.get<1>()));
+				int first_row = std::max(row_min, int(std::floor(y_low)));
+				// edges lying on pixel borders add no pixel (pixels on their inner side are already filled)
+				int last_row = std::min(row_max, int(std::ceil(y_high)) - 1);
+				double d_y = p_b.get<1>() - p_a.get<1>();
+				for (int c_row = first_row; c_row <= last_row; c_row++) {
+					double x_a = p_a.get<0>(), x_b = p_b.get<0>();
+					if (d_y != 0) {
+						double t_a = std::clamp((c_row - p_a.get<1>()) / d_y, 0.0, 1.0), t_b = std::clamp((c_row + 1 - p_a.get<1>()) / d_y, 0.0, 1.0);
+						x_a = p_a.get<0>() + t_a * (p_b.get<0>() - p_a.get<0>());
+						x_b = p_a.get<0>() + t_b * (p_b.get<0>() - p_a.get<0>());
+					}
+					double x_low = clamp_x(std::min(x_a, x_b)), x_high = clamp_x(std::max(x_a, x_b));
+					int col_begin = std::max(0, int(std::floor(x_low)));
+					int col_end = std::min(cols, int(std::ceil(x_high)));
+					if (col_begin < col_end)
+						out_runs.push_back({ c_row, col_begin, col_end });
+				}
+				});
+			merge_pixel_runs(out_runs);
+		}
+
+	}
+}
@@ -0,0 +1,137 @@
+#include "graph_weights/weights_csr.h"
+#include "design_pattern/parallel_for.h"
+#include <atomic>
+#include <numeric>
+
+
+namespace LxGeo
+{
+	namespace GeometryFactoryShared
+	{
+
+		WeightsCSR weights_csr_from_edges(size_t n_rows, const std::vector<WeightedEdge>& edges) {
+			WeightsCSR out_csr;
+			out_csr.row_offsets.assign(n_rows + 1, 0);
+			for (const WeightedEdge& c_edge : edges) {
+				out_csr.row_offsets[c_edge.source + 1]++;
+				if (c_edge.target != c_edge.source)
+					out_csr.row_offsets[c_edge.target + 1]++;
+			}
+			for (size_t row = 0; row < n_rows; row++)
+				out_csr.row_offsets[row + 1] += out_csr.row_offsets[row];
+
+			out_csr.columns.resize(out_csr.row_offsets[n_rows]);
+			out_csr.weights.resize(out_csr.row_offsets[n_rows]);
+			std::vector<size_t> next_position(out_csr.row_offsets.begin(), out_csr.row_offsets.end() - 1);
+			auto insert_entry = [&out_csr, &next_position](size_t row, size_t column, double weight) {
+				size_t position = next_position[row]++;
+				out_csr.columns[position] = column;
+				out_csr.weights[position] = weight;
+			};
+			for (const WeightedEdge& c_edge : edges) {
+				insert_entry(c_edge.source, c_edge.target, c_edge.weight);
+				if (c_edge.target != c_edge.source)
+					insert_entry(c_edge.target, c_edge.source, c_edge.weight);
+			}
+
+			// rows sorted by column
+			std::vector<std::pair<size_t, double>> row_entries;
+			for (size_t row = 0; row < n_rows; row++) {
+				size_t row_begin = out_csr.row_offsets[row], row_end = out_csr.row_offsets[row + 1];
+				if (std::is_sorted(out_csr.columns.begin() + row_begin, out_csr.columns.begin() + row_end))
+					continue;
+				row_entries.clear();
+				for (size_t position = row_begin; position < row_end; position++)
+					row_entries.emplace_back(out_csr.columns[position], out_csr.weights[position]);
+				std::sort(row_entries.begin(), row_entries.end());
+				for (size_t position = row_begin; position < row_end; position++)
+					std::tie(out_csr.columns[position], out_csr.weights[position]) = row_entries[position - row_begin];
+			}
+			return out_csr;
+		}
+
+		WeightsCSR row_standardized(const WeightsCSR& weights) {
+			WeightsCSR out_csr = weights;
+			for (size_t row = 0; row < out_csr.rows_count(); row++) {
+				size_t row_begin = out_csr.row_offsets[row], row_end = out_csr.row_offsets[row + 1];
+				double row_sum = std::accumulate(out_csr.weights.begin() + row_begin, out_csr.weights.begin() + row_end, 0.0);
+				if (row_sum == 0)
+					continue;
+				for (size_t position = row_begin; position < row_end; position++)
+					out_csr.weights[position] /= row_sum;
+			}
+			return out_csr;
+		}
+
+		void spatial_lag(const WeightsCSR& weights, std::span<const double> values, size_t columns_count, std::span<double> out_lag, size_t n_threads) {
+			size_t rows_count = weights.rows_count();
+			if (values.size() != rows_count * columns_count || out_lag.size() != rows_count * columns_count)
+				throw std::runtime_error("Spatial lag values size does not match the weights matrix!");
+			parallel_for_chunks(rows_count, n_threads, [&](size_t rows_begin, size_t rows_end) {
+				for (size_t row = rows_begin; row < rows_end; row++) {
+					double* c_lag = out_lag.data() + row * columns_count;
+					std::fill(c_lag, c_lag + columns_count, 0.0);
+					for (size_t position = weights.row_offsets[row]; position < weights.row_offsets[row + 1]; position++) {
+						const double* c_values = values.data() + weights.columns[position] * columns_count;
+						double c_weight = weights.weights[position];
+						for (size_t column = 0; column < columns_count; column++)
+							c_lag[column] += c_weight * c_values[column];
+					}
+				}
+				});
+		}
+
+		size_t connected_components(const WeightsCSR& weights, std::vector<size_t>& labels, size_t n_threads) {
+			size_t rows_count = weights.rows_count();
+			// roots are only linked under lower roots: parents never form cycles whatever the threads interleaving
+			std::vector<std::atomic<size_t>> parents(rows_count);
+			for (size_t row = 0; row < rows_count; row++)
+				parents[row].store(row, std::memory_order_relaxed);
+
+			auto find_root = [&parents](size_t vertex) {
+				while (true) {
+					size_t parent = parents[vertex].load(std::memory_order_relaxed);
+					if (parent == vertex)
+						return vertex;
+					size_t grand_parent = parents[parent].load(std::memory_order_relaxed);
+					if (grand_parent != parent) // path halving
+						parents[vertex].compare_exchange_weak(parent, grand_parent, std::memory_order_relaxed);
+					vertex = grand_parent;
+				}
+			};
+			auto unite = [&parents, &find_root](size_t vertex_a, size_t vertex_b) {
+				while (true) {
+					vertex_a = find_root(vertex_a);
+					vertex_b = find_root(vertex_b);
+					if (vertex_a == vertex_b)
+						return;
+					if (vertex_a < vertex_b)
+						std::swap(vertex_a, vertex_b);
+					size_t expected_root = vertex_a;
+					if (parents[vertex_a].compare_exchange_strong(expected_root, vertex_b, std::memory_order_relaxed))
+						return;
+				}
+			};
+
+			parallel_for_chunks(rows_count, n_threads, [&](size_t rows_begin, size_t rows_end) {
+				for (size_t row = rows_begin; row < rows_end; row++)
+					for (size_t neighbor : weights.neighbors(row))
+						if (neighbor > row)
+							unite(row, neighbor);
+				});
+
+			// roots to labels numbered by first vertex
+			labels.assign(rows_count, 0);
+			std::vector<size_t> root_labels(rows_count, std::numeric_limits<size_t>::max());
+			size_t components_count = 0;
+			for (size_t row = 0; row < rows_count; row++) {
+				size_t& c_root_label = root_labels[find_root(row)];
+				if (c_root_label == std::numeric_limits<size_t>::max())
+					c_root_label = components_count++;
+				labels[row] = c_root_label;
+			}
+			return components_count;
+		}
+
+	}
+}
@@ -40,6 +40,7 @@
 //M*/
 
 #include "GDAL_OPENCV_IO.h"
+#include "row_conversion.h"
 #include <iostream>
 #include <vector>
 
@@ -207,7 +208,19 @@ GDALDataType KGDAL2CV::opencv2gdal(int cvType) {
 bool KGDAL2CV::readHeader()
 {
 	// load the dataset
-	m_dataset = static_cast<GDALDataset*>(GDALOpen(m_filename.c_str(), GA_ReadOnly));
+	GDALDataset* dataset = static_cast<GDALDataset*>(GDALOpen(m_filename.c_str(), GA_ReadOnly));
+	return readHeader(dataset, true);
+}
+
+/**
+* Read header of an already opened dataset (ownsDataset: close it when done)
+*/
+bool KGDAL2CV::readHeader(GDALDataset* dataset, bool ownsDataset)
+{
+	// release previously loaded dataset
+	Close();
+	m_dataset = dataset;
+	m_ownsDataset = ownsDataset;
 
 	// if dataset is null, then there was a problem
 	if (m_dataset == nullptr) {
@@ -295,6 +308,63 @@ bool KGDAL2CV::CheckDataType(const GDALDataType& gdalDataType, cv::Mat img)
 	return false;
 }
 
+/**
+* Check whether GDAL can fill the cv::Mat buffer directly (same depth and band count, no color table)
+* In that case range_cast is the identity and the per pixel conversion can be skipped.
+*/
+bool KGDAL2CV::isDirectReadable(const GDALDataType& gdalType, const int& gdalChannels, const cv::Mat& img)
+{
+	if (hasColorTable || gdalChannels != img.channels()) return false;
+	return gdal2opencv(gdalType, gdalChannels) == img.type();
+}
+
+bool KGDAL2CV::isDirectReadable(GDALDataset* dataset, const cv::Mat& img)
+{
+	const GDALDataType gdalType = dataset->GetRasterBand(1)->GetRasterDataType();
+	for (int c = 2; c <= dataset->GetRasterCount(); c++)
+		if (dataset->GetRasterBand(c)->GetRasterDataType() != gdalType) return false;
+	return isDirectReadable(gdalType, dataset->GetRasterCount(), img);
+}
+
+/**
+* Read a window of one band in its own data type and convert it row by row into a channel of img (range_cast applied)
+*/
+bool KGDAL2CV::readBandConverted(GDALRasterBand* band, cv::Mat& img, int channel, int xStart, int yStart)
+{
+	const GDALDataType gdalType = band->GetRasterDataType();
+	const size_t typeSize = GDALGetDataTypeSizeBytes(gdalType);
+	std::vector<unsigned char> buffer(size_t(img.cols) * img.rows * typeSize);
+	if (band->RasterIO(GF_Read, xStart, yStart, img.cols, img.rows, buffer.data(), img.cols, img.rows, gdalType, 0, 0) != CE_None) return false;
+	for (int y = 0; y < img.rows; y++) {
+		const unsigned char* srcRow = buffer.data() + size_t(y) * img.cols * typeSize;
+		unsigned char* dstRow = img.ptr<unsigned char>(y) + channel * img.elemSize1();
+		if (!LxGeo::IO_DATA::row_conversion::convert_row(gdalType, srcRow, img.depth(), dstRow, img.cols, img.channels())) return false;
+	}
+	return true;
+}
+
+/**
+* Read a window of all bands into the interleaved buffer of img with a single RasterIO call
+*/
+bool KGDAL2CV::readDirect(GDALDataset* dataset, cv::Mat& img, int xStart, int yStart)
+{
+	GDALDataType bufType = dataset->GetRasterBand(1)->GetRasterDataType();
+	// cv::Mat has no unsigned 32 bits depth
+	if (bufType == GDT_UInt32) bufType = GDT_Int32;
+	CPLErr err = dataset->RasterIO(GF_Read, xStart, yStart, img.cols, img.rows, img.data, img.cols, img.rows, bufType,
+		img.channels(), nullptr, static_cast<GSpacing>(img.elemSize()), static_cast<GSpacing>(img.step[0]), static_cast<GSpacing>(img.elemSize1()), nullptr);
+	return err == CE_None;
+}
+
+bool KGDAL2CV::readDirect(GDALRasterBand* pBand, cv::Mat& img, int xStart, int yStart)
+{
+	GDALDataType bufType = pBand->GetRasterDataType();
+	if (bufType == GDT_UInt32) bufType = GDT_Int32;
+	CPLErr err = pBand->RasterIO(GF_Read, xStart, yStart, img.cols, img.rows, img.data, img.cols, img.rows, bufType,
+		static_cast<GSpacing>(img.elemSize()), static_cast<GSpacing>(img.step[0]), nullptr);
+	return err == CE_None;
+}
+
 /**
 * Convert data range
 */
@@ -437,6 +507,26 @@ bool KGDAL2CV::ImgWriteByGDAL(GDALDataset* dataset, const cv::Mat img, int xStar
 
 	GDALDataType dataType = dataset->GetRasterBand(1)->GetRasterDataType();
 	CheckDataType(dataType, imgToSave);
+
+	// write all bands at once from the interleaved buffer
+	GDALDataType bufType = opencv2gdal(CV_MAKETYPE(imgToSave.depth(), 1));
+	if (bufType != GDT_Unknown) {
+		if (xStart + xWidth > width)
+		{
+			std::cout << "Saved image will be cutted!" << std::endl;
+			xWidth = width - xStart;
+		}
+		if (yStart + yWidth > height)
+		{
+			std::cout << "Saved image will be cutted!" << std::endl;
+			yWidth = height - yStart;
+		}
+		CPLErr err = dataset->RasterIO(GF_Write, xStart, yStart, xWidth, yWidth, imgToSave.data, xWidth, yWidth, bufType,
+			nBand, nullptr, static_cast<GSpacing>(imgToSave.elemSize()), static_cast<GSpacing>(imgToSave.step[0]), static_cast<GSpacing>(imgToSave.elemSize1()), nullptr);
+		dataset->FlushCache();
+		return err == CE_None;
+	}
+
 	std::vector<cv::Mat> singleMats;
 	int ret = 0;
 	cv::split(imgToSave, singleMats);
@@ -460,13 +550,14 @@ bool KGDAL2CV::ImgWriteByGDAL(GDALRasterBand* pBand, const cv::Mat img, int xSta
 		std::cout << "Invalid access type of the GDALRasterBand!" << std::endl;
 		return false;
 	}
-	cv::Mat imgToSave = img.clone();
+	// views are enough: RasterIO follows the cv::Mat strides
+	cv::Mat imgToSave = img;
 	if (img.channels() > 1) {
 		std::cout << "More channels of the cv::Mat will be passed!" << std::endl;
 		std::vector<cv::Mat> singleMats;
 		cv::split(img, singleMats);
 		//singleMats[0].copyTo(imgToSave);
-		imgToSave = singleMats[0].clone();
+		imgToSave = singleMats[0];
 	}
 
 	int width = pBand->GetXSize();
@@ -484,12 +575,12 @@ bool KGDAL2CV::ImgWriteByGDAL(GDALRasterBand* pBand, const cv::Mat img, int xSta
 	if (xStart + xWidth > width)
 	{
 		std::cout << "Saved image will be cutted!" << std::endl;
-		imgToSave = (imgToSave.colRange(0, width - xStart)).clone();
+		imgToSave = imgToSave.colRange(0, width - xStart);
 	}
 	if (yStart + yWidth > height)
 	{
 		std::cout << "Saved image will be cutted!" << std::endl;
-		imgToSave = (imgToSave.rowRange(0, height - yStart)).clone();
+		imgToSave = imgToSave.rowRange(0, height - yStart);
 	}
 
 	GDALDataType dataType = pBand->GetRasterDataType();
@@ -497,55 +588,23 @@ bool KGDAL2CV::ImgWriteByGDAL(GDALRasterBand* pBand, const cv::Mat img, int xSta
 
 	xWidth = imgToSave.cols;
 	yWidth = imgToSave.rows;
-	int cvDepth = imgToSave.depth();
-	imgToSave.reshape(1, 1);
 
-	double* imgBuff = new(std::nothrow) double[xWidth * yWidth];
-	if (nullptr == imgBuff) return false;
-
-	if (cvDepth == CV_8S)
-	{
-		char* data = imgToSave.ptr<char>(0);
-		for (int index = 0; index < xWidth * yWidth; ++index) imgBuff[index] = static_cast<double>(data[index]);
-	}
-	else if (cvDepth == CV_16U)
-	{
-		unsigned short* data = imgToSave.ptr<unsigned short>(0);
-		for (int index = 0; index < xWidth * yWidth; ++index) imgBuff[index] = static_cast<double>(data[index]);
-	}
-	else if (cvDepth == CV_16S)
-	{
-		short* data = imgToSave.ptr<short>(0);
-		for (int index = 0; index < xWidth * yWidth; ++index) imgBuff[index] = static_cast<double>(data[index]);
-	}
-	else if (cvDepth == CV_32S)
-	{
-		int* data = imgToSave.ptr<int>(0);
-		for (int index = 0; index < xWidth * yWidth; ++index) imgBuff[index] = static_cast<double>(data[index]);
-	}
-	else if (cvDepth == CV_32F)
-	{
-		float* data = imgToSave.ptr<float>(0);
-		for (int index = 0; index < xWidth * yWidth; ++index) imgBuff[index] = static_cast<double>(data[index]);
-	}
-	else if (cvDepth == CV_64F)
-	{
-		double* data = imgToSave.ptr<double>(0);
-		for (int index = 0; index < xWidth * yWidth; ++index) imgBuff[index] = static_cast<double>(data[index]);
-	}
-	else {
-		unsigned char* data = imgToSave.ptr<unsigned char>(0);
-		for (int index = 0; index < xWidth * yWidth; ++index) imgBuff[index] = static_cast<double>(data[index]);
+	// GDAL converts from the cv::Mat type to the band type while writing
+	GDALDataType bufType = opencv2gdal(CV_MAKETYPE(imgToSave.depth(), 1));
+	if (bufType == GDT_Unknown) {
+		// CV_8S has no GDAL equivalent
+		cv::Mat widened(yWidth, xWidth, CV_16SC1);
+		for (int y = 0; y < yWidth; y++)
+			LxGeo::IO_DATA::row_conversion::convert_row(imgToSave.ptr<int8_t>(y), widened.ptr<int16_t>(y), xWidth);
+		imgToSave = widened;
+		bufType = GDT_Int16;
 	}
 
-	// datatype translate
-	//for (int index = 0; index < xWidth * yWidth; ++index) imgBuff[index] = range_cast_inv(dataType, cvDepth, imgBuff[index]);
-
-	pBand->RasterIO(GF_Write, xStart, yStart, xWidth, yWidth, imgBuff, xWidth, yWidth, GDT_Float64, 0, 0);
+	CPLErr err = pBand->RasterIO(GF_Write, xStart, yStart, xWidth, yWidth, imgToSave.data, xWidth, yWidth, bufType,
+		static_cast<GSpacing>(imgToSave.elemSize()), static_cast<GSpacing>(imgToSave.step[0]), nullptr);
 	pBand->FlushCache();
 
-	delete[] imgBuff;
-	return true;
+	return err == CE_None;
 }
 
 /**
@@ -755,6 +814,10 @@ bool KGDAL2CV::readData(cv::Mat img) {
 	const GDALDataType gdalType = m_dataset->GetRasterBand(1)->GetRasterDataType();
 	int nRows, nCols;
 
+	// fast path: GDAL writes the interleaved pixels in place
+	if (isDirectReadable(m_dataset, img))
+		return readDirect(m_dataset, img, 0, 0);
+
 	//if (nChannels > img.channels()){
 	//	nChannels = img.channels();
 	//}
@@ -775,6 +838,12 @@ bool KGDAL2CV::readData(cv::Mat img) {
 		// make sure the image band has the same dimensions as the image
 		if (band->GetXSize() != m_width || band->GetYSize() != m_height) { return false; }
 
+		// whole rows conversion
+		if (hasColorTable == false && nChannels == img.channels()) {
+			if (!readBandConverted(band, img, realBandIndex, 0, 0)) return false;
+			continue;
+		}
+
 		// grab the raster size
 		nRows = band->GetYSize();
 		nCols = band->GetXSize();
@@ -858,6 +927,11 @@ cv::Mat KGDAL2CV::ImgReadByGDAL(GDALRasterBand* pBand)
 	const GDALDataType gdalType = pBand->GetRasterDataType();
 	int nRows, nCols;
 
+	if (isDirectReadable(gdalType, m_nBand, img)) {
+		if (!readDirect(pBand, img, 0, 0)) return cv::Mat();
+		return img;
+	}
+
 	//if (m_nBand > img.channels()){
 	//	m_nBand = img.channels();
 	//}
@@ -901,6 +975,16 @@ cv::Mat KGDAL2CV::PaddedImgReadByGDAL(cv::String filename, int xStart, int yStar
 
 	m_filename = filename;
 	if (!readHeader()) return cv::Mat();
+	return readPaddedDatasetWindow(xStart, yStart, xWidth, yWidth);
+}
+
+cv::Mat KGDAL2CV::PaddedImgReadByGDAL(GDALDataset* dataset, int xStart, int yStart, int xWidth, int yWidth) {
+
+	if (!readHeader(dataset, false)) return cv::Mat();
+	return readPaddedDatasetWindow(xStart, yStart, xWidth, yWidth);
+}
+
+cv::Mat KGDAL2CV::readPaddedDatasetWindow(int xStart, int yStart, int xWidth, int yWidth) {
 
 	int left_pad = -std::min<int>(xStart, 0);
 	int right_pad = std::max<int>(xStart + xWidth, m_width) - m_width;
@@ -908,7 +992,7 @@ cv::Mat KGDAL2CV::PaddedImgReadByGDAL(cv::String filename, int xStart, int yStar
 	int down_pad = std::max<int>(yStart + yWidth, m_height) - m_height;
 
 	cv::Mat non_padded_data, padded_data;
-	non_padded_data = ImgReadByGDAL(m_filename, xStart + left_pad, yStart + top_pad, xWidth - left_pad - right_pad, yWidth - top_pad - down_pad);
+	non_padded_data = readDatasetWindow(xStart + left_pad, yStart + top_pad, xWidth - left_pad - right_pad, yWidth - top_pad - down_pad, true);
 	if (left_pad || right_pad || top_pad || down_pad)
 		copyMakeBorder(non_padded_data, padded_data, top_pad, down_pad, left_pad, right_pad, cv::BORDER_CONSTANT, cv::Scalar(0));
 	else
@@ -920,7 +1004,20 @@ cv::Mat KGDAL2CV::ImgReadByGDAL(cv::String filename, int xStart, int yStart, int
 {
 	m_filename = filename;
 	if (!readHeader()) return cv::Mat();
+	return readDatasetWindow(xStart, yStart, xWidth, yWidth, beReadFourth);
+}
 
+cv::Mat KGDAL2CV::ImgReadByGDAL(GDALDataset* dataset, int xStart, int yStart, int xWidth, int yWidth, bool beReadFourth)
+{
+	if (!readHeader(dataset, false)) return cv::Mat();
+	return readDatasetWindow(xStart, yStart, xWidth, yWidth, beReadFourth);
+}
+
+/**
+* Read a window of the loaded dataset (header should be read beforehand)
+*/
+cv::Mat KGDAL2CV::readDatasetWindow(int xStart, int yStart, int xWidth, int yWidth, bool beReadFourth)
+{
 	int tempType = m_type;
 
 	if (xStart < 0 || yStart < 0 || xWidth < 1 || yWidth < 1 || xStart > m_width - 1 || yStart > m_height - 1) return cv::Mat();
@@ -942,7 +1039,7 @@ cv::Mat KGDAL2CV::ImgReadByGDAL(cv::String filename, int xStart, int yStart, int
 		std::cout << "Fourth band is not supported!" << std::endl;
 	}
 
-	cv::Mat img(yWidth, xWidth, tempType, cv::Scalar::all(0.f));
+	cv::Mat img(yWidth, xWidth, tempType);
 	// iterate over each raster band
 	// note that OpenCV does bgr rather than rgb
 	int nChannels = m_dataset->GetRasterCount();
@@ -954,6 +1051,13 @@ cv::Mat KGDAL2CV::ImgReadByGDAL(cv::String filename, int xStart, int yStart, int
 
 	const GDALDataType gdalType = m_dataset->GetRasterBand(1)->GetRasterDataType();
 
+	// fast path: GDAL writes the interleaved pixels in place
+	if (isDirectReadable(m_dataset, img)) {
+		if (!readDirect(m_dataset, img, xStart, yStart)) return cv::Mat();
+		return img;
+	}
+	img = cv::Scalar::all(0.f);
+
 	//if (nChannels > img.channels()){
 	//	nChannels = img.channels();
 	//}
@@ -973,6 +1077,12 @@ cv::Mat KGDAL2CV::ImgReadByGDAL(cv::String filename, int xStart, int yStart, int
 		// make sure the image band has the same dimensions as the image
 		if (band->GetXSize() != m_width || band->GetYSize() != m_height) { return cv::Mat(); }
 
+		// whole rows conversion
+		if (hasColorTable == false && nChannels == img.channels()) {
+			if (!readBandConverted(band, img, realBandIndex, xStart, yStart)) return cv::Mat();
+			continue;
+		}
+
 		// create a temporary scanline pointer to store data
 		double* scanline = new double[xWidth];
 
@@ -1062,6 +1172,11 @@ cv::Mat KGDAL2CV::ImgReadByGDAL(GDALRasterBand* pBand, int xStart, int yStart, i
 
 	const GDALDataType gdalType = pBand->GetRasterDataType();
 
+	if (isDirectReadable(gdalType, m_nBand, img)) {
+		if (!readDirect(pBand, img, xStart, yStart)) return cv::Mat();
+		return img;
+	}
+
 	//if (m_nBand > img.channels()){
 	//	m_nBand = img.channels();
 	//}
@@ -1102,7 +1217,20 @@ cv::Mat KGDAL2CV::ImgReadByGDAL(cv::String filename, bool beReadFourth)
 {
 	m_filename = filename;
 	if (!readHeader()) return cv::Mat();
+	return readDataset(beReadFourth);
+}
+
+cv::Mat KGDAL2CV::ImgReadByGDAL(GDALDataset* dataset, bool beReadFourth)
+{
+	if (!readHeader(dataset, false)) return cv::Mat();
+	return readDataset(beReadFourth);
+}
 
+/**
+* Read the whole loaded dataset (header should be read beforehand)
+*/
+cv::Mat KGDAL2CV::readDataset(bool beReadFourth)
+{
 	int tempType = m_type;
 
 	if (!beReadFourth && 4 == m_nBand)
@@ -1120,12 +1248,13 @@ cv::Mat KGDAL2CV::ImgReadByGDAL(cv::String filename, bool beReadFourth)
 
 void KGDAL2CV::Close()
 {
-	if (nullptr != m_dataset) GDALClose(static_cast<GDALDatasetH>(m_dataset));
+	if (nullptr != m_dataset && m_ownsDataset) GDALClose(static_cast<GDALDatasetH>(m_dataset));
 	m_dataset = nullptr;
+	m_ownsDataset = false;
 	m_driver = nullptr;
 }
 
-KGDAL2CV::KGDAL2CV() : m_dataset(nullptr), m_filename(""), m_driver(nullptr), hasColorTable(false), m_width(0), m_height(0), m_type(-1), m_nBand(0)
+KGDAL2CV::KGDAL2CV() : m_dataset(nullptr), m_filename(""), m_driver(nullptr), hasColorTable(false), m_ownsDataset(false), m_width(0), m_height(0), m_type(-1), m_nBand(0)
 {
 	GDALAllRegister();
 	//CPLSetConfigOption("GDAL_FILENAME_IS_UTF8", "NO");
@@ -0,0 +1,323 @@
+#include "async_tiled_raster_writer.h"
+#include "GDAL_OPENCV_IO.h"
+#include <boost/filesystem.hpp>
+
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+
+		// Repeats a single channel matrix over channels_count channels
+		static cv::Mat repeat_channels(const cv::Mat& single_channel, int channels_count) {
+			if (channels_count == 1)
+				return single_channel;
+			std::vector<cv::Mat> channels(channels_count, single_channel);
+			cv::Mat out;
+			cv::merge(channels, out);
+			return out;
+		}
+
+		AsyncTiledRasterWriter::AsyncTiledRasterWriter(std::shared_ptr<GDALDataset> _dataset, const AsyncWriteOptions& _options) :
+			dataset(_dataset), options(_options), requests(_options.queue_capacity), closed(false), cached_bytes(0) {
+
+			if (!dataset)
+				throw std::runtime_error("AsyncTiledRasterWriter requires an opened dataset!");
+
+			width = dataset->GetRasterXSize();
+			height = dataset->GetRasterYSize();
+			band_count = dataset->GetRasterCount();
+
+			KGDAL2CV kgdal2cv;
+			value_type = kgdal2cv.gdal2opencv(dataset->GetRasterBand(1)->GetRasterDataType(), band_count);
+			if (value_type == -1)
+				throw std::runtime_error("Dataset data type is not supported by AsyncTiledRasterWriter!");
+			buffer_type = KGDAL2CV::opencv2gdal(CV_MAKETYPE(CV_MAT_DEPTH(value_type), 1));
+
+			// tiles group whole blocks up to at least 256 pixels per side (strips are grouped by rows)
+			int block_width, block_height;
+			dataset->GetRasterBand(1)->GetBlockSize(&block_width, &block_height);
+			tile_width = block_width * std::max(1, (256 + block_width - 1) / block_width);
+			tile_height = block_height * std::max(1, (256 + block_height - 1) / block_height);
+
+			writer_thread = std::thread(&AsyncTiledRasterWriter::writer_loop, this);
+		}
+
+		AsyncTiledRasterWriter::~AsyncTiledRasterWriter() {
+			try {
+				close();
+			}
+			catch (std::exception& e) {
+				BOOST_LOG_TRIVIAL(error) << "Asynchronous raster writing failed: " << e.what();
+			}
+		}
+
+		void AsyncTiledRasterWriter::submit(int col_start, int row_start, const cv::Mat& image) {
+
+			if (closed)
+				throw std::runtime_error("Cannot submit a patch to a closed AsyncTiledRasterWriter!");
+			rethrow_writer_error();
+
+			if (image.channels() < band_count)
+				throw std::runtime_error("Patch channels count is lower than the sink dataset bands count!");
+
+			cv::Rect patch_rect(col_start, row_start, image.cols, image.rows);
+			cv::Rect sink_rect = patch_rect & cv::Rect(0, 0, width, height);
+			if (sink_rect.empty())
+				throw std::runtime_error("Patch is fully outside the sink dataset!");
+
+			// cropping and conversion are done on the caller thread
+			cv::Mat cropped = image(sink_rect - patch_rect.tl());
+			if (image.channels() > band_count) {
+				std::vector<cv::Mat> channels;
+				cv::split(cropped, channels);
+				channels.resize(band_count);
+				cv::merge(channels, cropped);
+			}
+
+			write_request request;
+			request.col_start = sink_rect.x;
+			request.row_start = sink_rect.y;
+			cropped.convertTo(request.image, CV_MAT_DEPTH(value_type));
+
+			if (!requests.push(std::move(request)))
+				throw std::runtime_error("Cannot submit a patch to a closed AsyncTiledRasterWriter!");
+		}
+
+		void AsyncTiledRasterWriter::flush() {
+			if (closed)
+				return;
+			write_request request;
+			request.flushed = std::make_shared<std::promise<void>>();
+			std::future<void> flushed = request.flushed->get_future();
+			if (!requests.push(std::move(request)))
+				return;
+			flushed.get();
+		}
+
+		void AsyncTiledRasterWriter::close() {
+			if (closed)
+				return;
+			std::exception_ptr flush_error;
+			try {
+				flush();
+			}
+			catch (...) {
+				flush_error = std::current_exception();
+			}
+			closed = true;
+			requests.close();
+			if (writer_thread.joinable())
+				writer_thread.join();
+			if (spill_file.is_open()) {
+				spill_file.close();
+				boost::system::error_code remove_error;
+				boost::filesystem::remove(spill_path, remove_error);
+			}
+			spilled_tiles.clear();
+			if (flush_error)
+				std::rethrow_exception(flush_error);
+		}
+
+		void AsyncTiledRasterWriter::rethrow_writer_error() {
+			std::lock_guard<std::mutex> lock(error_mtx);
+			if (writer_error)
+				std::rethrow_exception(writer_error);
+		}
+
+		void AsyncTiledRasterWriter::writer_loop() {
+			write_request c_request;
+			while (requests.pop(c_request)) {
+				try {
+					if (c_request.flushed) {
+						rethrow_writer_error();
+						write_all_tiles();
+						dataset->FlushCache();
+						c_request.flushed->set_value();
+					}
+					else {
+						bool failed;
+						{
+							std::lock_guard<std::mutex> lock(error_mtx);
+							failed = (writer_error != nullptr);
+						}
+						// patches submitted after a failure are dropped
+						if (!failed)
+							composite(c_request);
+					}
+				}
+				catch (...) {
+					{
+						std::lock_guard<std::mutex> lock(error_mtx);
+						if (!writer_error)
+							writer_error = std::current_exception();
+					}
+					if (c_request.flushed)
+						c_request.flushed->set_exception(std::current_exception());
+				}
+				c_request = write_request();
+			}
+		}
+
+		cv::Rect AsyncTiledRasterWriter::tile_rect(const tile_key& key) const {
+			int x = key.first * tile_width, y = key.second * tile_height;
+			return cv::Rect(x, y, std::min(tile_width, width - x), std::min(tile_height, height - y));
+		}
+
+		size_t AsyncTiledRasterWriter::tile_bytes(const tile& c_tile) const {
+			return c_tile.values.total() * c_tile.values.elemSize() + c_tile.sums.total() * c_tile.sums.elemSize() + c_tile.counts.total() * c_tile.counts.elemSize();
+		}
+
+		AsyncTiledRasterWriter::tile& AsyncTiledRasterWriter::get_tile(const tile_key& key) {
+
+			auto tile_it = tiles.find(key);
+			if (tile_it != tiles.end()) {
+				tiles_lru.splice(tiles_lru.begin(), tiles_lru, tile_it->second.lru_it);
+				return tile_it->second;
+			}
+
+			cv::Rect rect = tile_rect(key);
+			tile new_tile;
+			// pixels not covered by patches keep the dataset content
+			new_tile.values = cv::Mat(rect.height, rect.width, value_type);
+			CPLErr err = dataset->RasterIO(GF_Read, rect.x, rect.y, rect.width, rect.height, new_tile.values.data, rect.width, rect.height, buffer_type,
+				band_count, nullptr, static_cast<GSpacing>(new_tile.values.elemSize()), static_cast<GSpacing>(new_tile.values.step[0]), static_cast<GSpacing>(new_tile.values.elemSize1()), nullptr);
+			if (err != CE_None)
+				throw std::runtime_error("Unable to read back a tile of the sink dataset!");
+
+			// counts and sums of a written tile are read back from the spill file (means are never converted back to sums)
+			if (options.overlap_policy != OverlapPolicy::last_wins) {
+				new_tile.counts = cv::Mat::zeros(rect.height, rect.width, CV_8UC1);
+				if (options.overlap_policy == OverlapPolicy::average)
+					new_tile.sums = cv::Mat::zeros(rect.height, rect.width, CV_MAKETYPE(CV_64F, band_count));
+				load_tile_state(key, new_tile);
+			}
+
+			tiles_lru.push_front(key);
+			new_tile.lru_it = tiles_lru.begin();
+			tile& inserted_tile = tiles.emplace(key, std::move(new_tile)).first->second;
+			cached_bytes += tile_bytes(inserted_tile);
+			return inserted_tile;
+		}
+
+		void AsyncTiledRasterWriter::composite(const write_request& request) {
+
+			cv::Rect patch_rect(request.col_start, request.row_start, request.image.cols, request.image.rows);
+			int tile_col_start = patch_rect.x / tile_width, tile_col_end = (patch_rect.br().x - 1) / tile_width;
+			int tile_row_start = patch_rect.y / tile_height, tile_row_end = (patch_rect.br().y - 1) / tile_height;
+
+			for (int tile_row = tile_row_start; tile_row <= tile_row_end; tile_row++) {
+				for (int tile_col = tile_col_start; tile_col <= tile_col_end; tile_col++) {
+					tile_key key(tile_col, tile_row);
+					tile& c_tile = get_tile(key);
+					cv::Rect c_tile_rect = tile_rect(key);
+					cv::Rect overlap_rect = patch_rect & c_tile_rect;
+					cv::Mat patch_roi = request.image(overlap_rect - patch_rect.tl());
+					cv::Rect tile_roi_rect = overlap_rect - c_tile_rect.tl();
+					cv::Mat values_roi = c_tile.values(tile_roi_rect);
+
+					switch (options.overlap_policy) {
+					case OverlapPolicy::last_wins:
+						patch_roi.copyTo(values_roi);
+						break;
+					case OverlapPolicy::max: {
+						cv::Mat counts_roi = c_tile.counts(tile_roi_rect);
+						cv::Mat merged;
+						cv::max(values_roi, patch_roi, merged);
+						patch_roi.copyTo(merged, counts_roi == 0);
+						merged.copyTo(values_roi);
+						counts_roi += 1;
+						break;
+					}
+					case OverlapPolicy::average: {
+						cv::Mat counts_roi = c_tile.counts(tile_roi_rect);
+						cv::Mat sums_roi = c_tile.sums(tile_roi_rect);
+						cv::Mat patch_64;
+						patch_roi.convertTo(patch_64, CV_64F);
+						sums_roi += patch_64;
+						counts_roi += 1;
+						break;
+					}
+					}
+				}
+			}
+
+			// evict least recently used tiles over the cache budget
+			while (cached_bytes > options.cache_size_mb * 1024 * 1024 && tiles_lru.size() > 1) {
+				tile_key key = tiles_lru.back();
+				auto tile_it = tiles.find(key);
+				write_tile(key, tile_it->second);
+				cached_bytes -= tile_bytes(tile_it->second);
+				spill_tile_state(key, tile_it->second);
+				tiles_lru.pop_back();
+				tiles.erase(tile_it);
+			}
+		}
+
+		void AsyncTiledRasterWriter::write_tile(const tile_key& key, tile& c_tile) {
+
+			if (options.overlap_policy == OverlapPolicy::average) {
+				cv::Mat counts_64, means, converted_means;
+				c_tile.counts.convertTo(counts_64, CV_64F);
+				cv::divide(c_tile.sums, repeat_channels(counts_64, band_count), means);
+				means.convertTo(converted_means, CV_MAT_DEPTH(value_type));
+				converted_means.copyTo(c_tile.values, c_tile.counts > 0);
+			}
+
+			cv::Rect rect = tile_rect(key);
+			CPLErr err = dataset->RasterIO(GF_Write, rect.x, rect.y, rect.width, rect.height, c_tile.values.data, rect.width, rect.height, buffer_type,
+				band_count, nullptr, static_cast<GSpacing>(c_tile.values.elemSize()), static_cast<GSpacing>(c_tile.values.step[0]), static_cast<GSpacing>(c_tile.values.elemSize1()), nullptr);
+			if (err != CE_None)
+				throw std::runtime_error("Unable to write a tile of the sink dataset!");
+		}
+
+		// Slots are sized for full tiles, edge tiles use the beginning of their slot
+		void AsyncTiledRasterWriter::spill_tile_state(const tile_key& key, const tile& c_tile) {
+			if (c_tile.counts.empty())
+				return;
+			if (!spill_file.is_open()) {
+				boost::filesystem::path spill_directory = options.spill_directory.empty() ? boost::filesystem::temp_directory_path() : boost::filesystem::path(options.spill_directory);
+				spill_path = (spill_directory / boost::filesystem::unique_path("async_tiled_writer_%%%%-%%%%-%%%%.spill")).string();
+				spill_file.open(spill_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+				if (!spill_file)
+					throw std::runtime_error("Unable to create the tiles spill file " + spill_path);
+			}
+			spill_file.seekp(tile_slot_offset(key));
+			spill_file.write(reinterpret_cast<const char*>(c_tile.counts.data), c_tile.counts.total() * c_tile.counts.elemSize());
+			if (!c_tile.sums.empty())
+				spill_file.write(reinterpret_cast<const char*>(c_tile.sums.data), c_tile.sums.total() * c_tile.sums.elemSize());
+			if (!spill_file)
+				throw std::runtime_error("Unable to spill the state of a tile to " + spill_path);
+			spilled_tiles.insert(key);
+		}
+
+		void AsyncTiledRasterWriter::load_tile_state(const tile_key& key, tile& c_tile) {
+			if (spilled_tiles.find(key) == spilled_tiles.end())
+				return;
+			spill_file.seekg(tile_slot_offset(key));
+			spill_file.read(reinterpret_cast<char*>(c_tile.counts.data), c_tile.counts.total() * c_tile.counts.elemSize());
+			if (!c_tile.sums.empty())
+				spill_file.read(reinterpret_cast<char*>(c_tile.sums.data), c_tile.sums.total() * c_tile.sums.elemSize());
+			if (!spill_file)
+				throw std::runtime_error("Unable to read back the state of a tile from " + spill_path);
+		}
+
+		std::streamoff AsyncTiledRasterWriter::tile_slot_offset(const tile_key& key) const {
+			std::streamoff tiles_per_row = (width + tile_width - 1) / tile_width;
+			std::streamoff slot_bytes = std::streamoff(tile_width) * tile_height * (1 + ((options.overlap_policy == OverlapPolicy::average) ? sizeof(double) * band_count : 0));
+			return (key.second * tiles_per_row + key.first) * slot_bytes;
+		}
+
+		void AsyncTiledRasterWriter::write_all_tiles() {
+			for (auto& [key, c_tile] : tiles) {
+				write_tile(key, c_tile);
+				spill_tile_state(key, c_tile);
+			}
+			tiles.clear();
+			tiles_lru.clear();
+			cached_bytes = 0;
+		}
+
+	}
+}
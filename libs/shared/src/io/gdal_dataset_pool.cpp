@@ -0,0 +1,197 @@
+#include "gdal_dataset_pool.h"
+#include <chrono>
+
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+
+		GDALDatasetPool::GDALDatasetPool(size_t max_open_handles) : state(std::make_shared<pool_state>()) {
+			GDALAllRegister();
+			state->max_open_handles = std::max<size_t>(max_open_handles, 1);
+		}
+
+		GDALDatasetPool::~GDALDatasetPool() {
+			clear();
+		}
+
+		GDALDatasetPool& GDALDatasetPool::instance() {
+			static GDALDatasetPool pool;
+			return pool;
+		}
+
+		void GDALDatasetPool::remove_idle(pool_state& state, lru_list::iterator lru_it) {
+			auto index_it = state.idle_index.find(lru_it->key);
+			auto& key_handles = index_it->second;
+			key_handles.erase(std::find(key_handles.begin(), key_handles.end(), lru_it));
+			if (key_handles.empty())
+				state.idle_index.erase(index_it);
+			state.idle_lru.erase(lru_it);
+		}
+
+		size_t GDALDatasetPool::eviction_generation(const pool_state& state, const std::string& file_path) {
+			auto generation_it = state.eviction_generations.find(file_path);
+			return generation_it == state.eviction_generations.end() ? 0 : generation_it->second;
+		}
+
+		std::shared_ptr<GDALDataset> GDALDatasetPool::acquire(const std::string& file_path, GDALAccess access) {
+
+			pool_key key(file_path, access);
+			std::weak_ptr<pool_state> weak_state = state;
+			auto pooled_handle = [&weak_state, &key](GDALDataset* dataset, size_t generation) {
+				return std::shared_ptr<GDALDataset>(dataset, [weak_state, key, generation](GDALDataset* released) { release(weak_state, key, generation, released); });
+			};
+			size_t generation;
+
+			std::list<GDALDataset*> to_close;
+			{
+				std::lock_guard<std::mutex> lock(state->mtx);
+				generation = eviction_generation(*state, file_path);
+				auto index_it = state->idle_index.find(key);
+				if (index_it != state->idle_index.end()) {
+					// reuse the most recently released handle of this key
+					lru_list::iterator lru_it = index_it->second.back();
+					GDALDataset* dataset = lru_it->dataset;
+					remove_idle(*state, lru_it);
+					state->stats.hits++;
+					return pooled_handle(dataset, generation);
+				}
+				// free room for the handle to open
+				while (state->stats.open_handles >= state->max_open_handles && !state->idle_lru.empty()) {
+					to_close.push_back(state->idle_lru.back().dataset);
+					remove_idle(*state, std::prev(state->idle_lru.end()));
+					state->stats.open_handles--;
+					state->stats.evictions++;
+				}
+				state->stats.misses++;
+			}
+			for (GDALDataset* dataset : to_close)
+				GDALClose((GDALDatasetH)dataset);
+
+			auto open_start = std::chrono::steady_clock::now();
+			GDALDataset* dataset = (GDALDataset*)GDALOpen(file_path.c_str(), access);
+			std::chrono::duration<double> open_duration = std::chrono::steady_clock::now() - open_start;
+
+			{
+				std::lock_guard<std::mutex> lock(state->mtx);
+				state->stats.open_time += open_duration.count();
+				if (dataset != NULL)
+					state->stats.open_handles++;
+			}
+
+			if (dataset == NULL) {
+				auto err_msg = "Unable to open raster dataset from file " + file_path;
+				throw std::runtime_error(err_msg.c_str());
+			}
+			return pooled_handle(dataset, generation);
+		}
+
+		void GDALDatasetPool::release(const std::weak_ptr<pool_state>& weak_state, const pool_key& key, size_t generation, GDALDataset* dataset) {
+
+			std::shared_ptr<pool_state> state = weak_state.lock();
+			if (!state) {
+				// pool already destroyed
+				GDALClose((GDALDatasetH)dataset);
+				return;
+			}
+
+			if (key.second == GA_Update)
+				dataset->FlushCache();
+
+			bool close_dataset = false;
+			{
+				std::lock_guard<std::mutex> lock(state->mtx);
+				if (generation != eviction_generation(*state, key.first)) {
+					// file evicted while the handle was acquired (possibly overwritten or deleted)
+					close_dataset = true;
+					state->stats.open_handles--;
+				}
+				else if (state->stats.open_handles > state->max_open_handles) {
+					// handles acquired beyond the cap are not kept
+					close_dataset = true;
+					state->stats.open_handles--;
+					state->stats.evictions++;
+				}
+				else {
+					state->idle_lru.push_front({ key, dataset });
+					state->idle_index[key].push_back(state->idle_lru.begin());
+				}
+			}
+			if (close_dataset)
+				GDALClose((GDALDatasetH)dataset);
+		}
+
+		void GDALDatasetPool::set_max_open_handles(size_t max_open_handles) {
+			std::list<GDALDataset*> to_close;
+			{
+				std::lock_guard<std::mutex> lock(state->mtx);
+				state->max_open_handles = std::max<size_t>(max_open_handles, 1);
+				while (state->stats.open_handles > state->max_open_handles && !state->idle_lru.empty()) {
+					to_close.push_back(state->idle_lru.back().dataset);
+					remove_idle(*state, std::prev(state->idle_lru.end()));
+					state->stats.open_handles--;
+					state->stats.evictions++;
+				}
+			}
+			for (GDALDataset* dataset : to_close)
+				GDALClose((GDALDatasetH)dataset);
+		}
+
+		size_t GDALDatasetPool::get_max_open_handles() const {
+			std::lock_guard<std::mutex> lock(state->mtx);
+			return state->max_open_handles;
+		}
+
+		void GDALDatasetPool::evict(const std::string& file_path) {
+			std::list<GDALDataset*> to_close;
+			{
+				std::lock_guard<std::mutex> lock(state->mtx);
+				state->eviction_generations[file_path]++;
+				for (GDALAccess access : { GA_ReadOnly, GA_Update }) {
+					auto index_it = state->idle_index.find(pool_key(file_path, access));
+					if (index_it == state->idle_index.end())
+						continue;
+					for (lru_list::iterator lru_it : index_it->second) {
+						to_close.push_back(lru_it->dataset);
+						state->idle_lru.erase(lru_it);
+					}
+					state->idle_index.erase(index_it);
+				}
+				state->stats.open_handles -= to_close.size();
+			}
+			for (GDALDataset* dataset : to_close)
+				GDALClose((GDALDatasetH)dataset);
+		}
+
+		void GDALDatasetPool::clear() {
+			std::list<GDALDataset*> to_close;
+			{
+				std::lock_guard<std::mutex> lock(state->mtx);
+				for (auto& c_entry : state->idle_lru)
+					to_close.push_back(c_entry.dataset);
+				state->idle_lru.clear();
+				state->idle_index.clear();
+				state->stats.open_handles -= to_close.size();
+			}
+			for (GDALDataset* dataset : to_close)
+				GDALClose((GDALDatasetH)dataset);
+		}
+
+		GDALDatasetPoolStats GDALDatasetPool::stats() const {
+			std::lock_guard<std::mutex> lock(state->mtx);
+			GDALDatasetPoolStats out_stats = state->stats;
+			out_stats.idle_handles = state->idle_lru.size();
+			return out_stats;
+		}
+
+		void GDALDatasetPool::reset_stats() {
+			std::lock_guard<std::mutex> lock(state->mtx);
+			size_t open_handles = state->stats.open_handles;
+			state->stats = GDALDatasetPoolStats();
+			state->stats.open_handles = open_handles;
+		}
+
+	}
+}
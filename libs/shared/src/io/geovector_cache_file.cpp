@@ -0,0 +1,119 @@
+#include "geovector_cache_file.h"
+#include <boost/filesystem.hpp>
+#include <cctype>
+#include <cstring>
+
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+
+		namespace geovector_cache
+		{
+
+			static inline uint64_t mix64(uint64_t value) {
+				value ^= value >> 30; value *= 0xBF58476D1CE4E5B9ull;
+				value ^= value >> 27; value *= 0x94D049BB133111EBull;
+				return value ^ (value >> 31);
+			}
+
+			uint64_t hash_bytes(const void* data, size_t size, uint64_t seed) {
+				const unsigned char* bytes = static_cast<const unsigned char*>(data);
+				uint64_t hash = mix64(seed ^ (size * 0x9E3779B97F4A7C15ull));
+				size_t words_count = size / 8;
+				for (size_t word_idx = 0; word_idx < words_count; word_idx++) {
+					uint64_t word; std::memcpy(&word, bytes + word_idx * 8, 8);
+					hash ^= mix64(word);
+					hash = (hash << 27 | hash >> 37) * 0x9E3779B97F4A7C15ull;
+				}
+				uint64_t tail = 0;
+				std::memcpy(&tail, bytes + words_count * 8, size % 8);
+				return mix64(hash ^ mix64(tail));
+			}
+
+			std::vector<std::string> source_files(const std::string& path) {
+				std::vector<std::string> files_paths;
+				boost::system::error_code error;
+				if (!boost::filesystem::is_regular_file(path, error))
+					return files_paths;
+				files_paths.push_back(path);
+
+				boost::filesystem::path source_path(path);
+				std::string extension = source_path.extension().string();
+				bool upper_case = !extension.empty() && std::all_of(extension.begin(), extension.end(), [](char c) {return !std::islower(static_cast<unsigned char>(c)); });
+				std::vector<std::string> companions;
+				for (std::string c_extension : { ".shx", ".dbf", ".prj", ".cpg", ".qix", ".sbn", ".sbx" }) {
+					if (upper_case)
+						std::transform(c_extension.begin(), c_extension.end(), c_extension.begin(), [](char c) {return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+					companions.push_back(boost::filesystem::path(source_path).replace_extension(c_extension).string());
+				}
+				companions.push_back(path + "-wal");
+				companions.push_back(path + "-journal");
+				for (const std::string& c_companion : companions)
+					if (c_companion != path && boost::filesystem::is_regular_file(c_companion, error))
+						files_paths.push_back(c_companion);
+				return files_paths;
+			}
+
+			SourceKey source_files_key(const std::vector<std::string>& files_paths, bool full_content) {
+				SourceKey key;
+				std::vector<char> buffer(full_content ? size_t(1 << 20) : SOURCE_SAMPLE_BYTES);
+				auto hash_stream = [&](std::ifstream& in_stream, uint64_t bytes_count) {
+					while (in_stream && bytes_count > 0) {
+						in_stream.read(buffer.data(), std::min<uint64_t>(buffer.size(), bytes_count));
+						key.content_hash = hash_bytes(buffer.data(), in_stream.gcount(), key.content_hash);
+						bytes_count -= in_stream.gcount();
+					}
+				};
+				for (const std::string& file_path : files_paths) {
+					uint64_t file_size = boost::filesystem::file_size(file_path);
+					key.mtime = std::max<uint64_t>(key.mtime, boost::filesystem::last_write_time(file_path));
+					key.size += file_size;
+					key.content_hash = hash_bytes(file_path.data(), file_path.size(), key.content_hash);
+					std::ifstream in_stream(file_path, std::ios::binary);
+					if (full_content || file_size <= 2 * SOURCE_SAMPLE_BYTES)
+						hash_stream(in_stream, file_size);
+					else {
+						// bounded cost whatever the files size: head (headers, indices) and tail (last appended features)
+						hash_stream(in_stream, SOURCE_SAMPLE_BYTES);
+						in_stream.seekg(file_size - SOURCE_SAMPLE_BYTES);
+						hash_stream(in_stream, SOURCE_SAMPLE_BYTES);
+					}
+				}
+				return key;
+			}
+
+			MappedFile::MappedFile(const std::string& file_path) :
+				mapping(file_path.c_str(), boost::interprocess::read_only), region(mapping, boost::interprocess::read_only) {}
+
+			FileWriter::FileWriter(const std::string& file_path) : out_stream(file_path, std::ios::binary | std::ios::trunc), position(0) {
+				if (!out_stream)
+					throw std::runtime_error("Cannot create cache file: " + file_path);
+				// header place holder
+				FileHeader empty_header{};
+				write(&empty_header, sizeof(empty_header));
+			}
+
+			uint64_t FileWriter::write(const void* data, size_t size) {
+				uint64_t offset = position;
+				out_stream.write(static_cast<const char*>(data), size);
+				static const char padding[8] = {};
+				size_t padding_size = (8 - size % 8) % 8;
+				out_stream.write(padding, padding_size);
+				position += size + padding_size;
+				return offset;
+			}
+
+			void FileWriter::write_header(const FileHeader& header) {
+				out_stream.seekp(0);
+				out_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+				out_stream.flush();
+				if (!out_stream)
+					throw std::runtime_error("Error while writing cache file!");
+			}
+
+		}
+	}
+}
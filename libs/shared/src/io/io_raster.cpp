@@ -1,6 +1,7 @@
 #include "io_raster.h"
 #include "defs.h"
 #include "GDAL_OPENCV_IO.h"
+#include "gdal_dataset_pool.h"
 
 
 namespace LxGeo
@@ -12,12 +13,15 @@ namespace LxGeo
 		bool RasterIO::load_raster(std::string _raster_path, GDALAccess read_mode, bool lazy_load) {
 
 			raster_path = _raster_path;
-			raster_dataset = (GDALDataset*)GDALOpen(raster_path.c_str(), read_mode);
-			if (raster_dataset == NULL)
-			{
+			try {
+				pooled_raster_dataset = GDALDatasetPool::instance().acquire(raster_path, read_mode);
+			}
+			catch (std::exception& e) {
+				BOOST_LOG_TRIVIAL(debug) << e.what();
 				BOOST_LOG_TRIVIAL(fatal) << fmt::format("Error loading raster at {} !", raster_path);
 				return false;
 			}
+			raster_dataset = pooled_raster_dataset.get();
 			raster_X_size = raster_dataset->GetRasterXSize();
 			raster_Y_size = raster_dataset->GetRasterYSize();
 			raster_size = raster_X_size * raster_Y_size;
@@ -34,7 +38,7 @@ namespace LxGeo
 				KGDAL2CV kgdal2cv;
 				try {
 					//raster_data = cv::imread(raster_path, cv::IMREAD_LOAD_GDAL );
-					raster_data = kgdal2cv.ImgReadByGDAL(raster_path);
+					raster_data = kgdal2cv.ImgReadByGDAL(raster_dataset);
 					if (raster_data.empty()) {
 						throw std::runtime_error("Empty raster data!");
 					}
@@ -71,6 +75,8 @@ namespace LxGeo
 			if (_band_count) out_band_count = _band_count;
 			else out_band_count = band_count;
 			
+			// pooled handles on a previous file at the same path are stale
+			GDALDatasetPool::instance().evict(raster_path);
 			GDALDataset* new_dataset = tiff_driver->Create(raster_path.c_str(), raster_X_size, raster_Y_size, out_band_count, out_data_type, NULL);
 			if (new_dataset == NULL) { throw std::exception(fmt::format("Cannot create copy dataset at {}", raster_path).c_str()); }
 			if (spatial_refrence) new_dataset->SetSpatialRef(spatial_refrence);
@@ -80,6 +86,8 @@ namespace LxGeo
 
 		static GDALDataset* create_dataset(std::string& dataset_path, GDALDriver* gdal_driver, GDALDataType gdal_datatype, size_t raster_X_size, size_t raster_Y_size,
 			double geotransform[6], size_t band_count, const OGRSpatialReference* srs, char** papzoptions) {
+			// pooled handles on a previous file at the same path are stale
+			GDALDatasetPool::instance().evict(dataset_path);
 			GDALDataset* new_dataset = gdal_driver->Create(dataset_path.c_str(), raster_X_size, raster_Y_size, band_count, gdal_datatype, papzoptions);
 			if (new_dataset == NULL) { throw std::exception("Cannot create copy dataset!"); }
 			if (srs) new_dataset->SetSpatialRef(srs);
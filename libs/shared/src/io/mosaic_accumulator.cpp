@@ -0,0 +1,198 @@
+#include "mosaic_accumulator.h"
+#include "GDAL_OPENCV_IO.h"
+
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+
+		// Repeats a single channel matrix over channels_count channels
+		static cv::Mat repeat_channels(const cv::Mat& single_channel, int channels_count) {
+			if (channels_count == 1)
+				return single_channel;
+			std::vector<cv::Mat> channels(channels_count, single_channel);
+			cv::Mat out;
+			cv::merge(channels, out);
+			return out;
+		}
+
+		static float window_weight(BlendingWindow window, double distance_to_border, double ramp_size) {
+			if (window == BlendingWindow::constant || ramp_size <= 0)
+				return 1.0f;
+			double t = std::min(distance_to_border / ramp_size, 1.0);
+			if (window == BlendingWindow::feathered)
+				return static_cast<float>(t);
+			return static_cast<float>(0.5 - 0.5 * std::cos(CV_PI * t));
+		}
+
+		MosaicAccumulator::MosaicAccumulator(std::shared_ptr<GDALDataset> _dataset, const MosaicBlendingOptions& _options) :
+			dataset(_dataset), options(_options), band_row_start(0), band_rows(0), finalized(false) {
+
+			if (!dataset)
+				throw std::runtime_error("MosaicAccumulator requires an opened dataset!");
+
+			width = dataset->GetRasterXSize();
+			height = dataset->GetRasterYSize();
+			band_count = dataset->GetRasterCount();
+
+			KGDAL2CV kgdal2cv;
+			value_type = kgdal2cv.gdal2opencv(dataset->GetRasterBand(1)->GetRasterDataType(), band_count);
+			if (value_type == -1)
+				throw std::runtime_error("Dataset data type is not supported by MosaicAccumulator!");
+			buffer_type = KGDAL2CV::opencv2gdal(CV_MAKETYPE(CV_MAT_DEPTH(value_type), 1));
+		}
+
+		MosaicAccumulator::~MosaicAccumulator() {
+			try {
+				finalize();
+			}
+			catch (std::exception& e) {
+				BOOST_LOG_TRIVIAL(error) << "Mosaic finalization failed: " << e.what();
+			}
+		}
+
+		const cv::Mat& MosaicAccumulator::patch_weights(int rows, int cols) {
+			auto cache_it = weights_cache.find({ rows, cols });
+			if (cache_it != weights_cache.end())
+				return cache_it->second;
+
+			double ramp_size = (options.ramp_size > 0) ? options.ramp_size : std::min(rows, cols) / 2.0;
+			std::vector<float> row_weights(rows), col_weights(cols);
+			// distances are measured from pixel centers, thus border weights are never null
+			for (int y = 0; y < rows; y++)
+				row_weights[y] = window_weight(options.window, std::min(y + 0.5, rows - y - 0.5), ramp_size);
+			for (int x = 0; x < cols; x++)
+				col_weights[x] = window_weight(options.window, std::min(x + 0.5, cols - x - 0.5), ramp_size);
+
+			cv::Mat c_weights(rows, cols, CV_32FC1);
+			for (int y = 0; y < rows; y++) {
+				float* c_row = c_weights.ptr<float>(y);
+				for (int x = 0; x < cols; x++)
+					c_row[x] = row_weights[y] * col_weights[x];
+			}
+			return weights_cache.emplace(std::make_pair(rows, cols), c_weights).first->second;
+		}
+
+		void MosaicAccumulator::ensure_band_capacity(int rows) {
+			if (rows <= sums.rows)
+				return;
+			int new_rows = std::max(rows, 2 * sums.rows);
+			cv::Mat new_sums = cv::Mat::zeros(new_rows, width, CV_32FC(band_count));
+			cv::Mat new_weights = cv::Mat::zeros(new_rows, width, CV_32FC1);
+			if (band_rows > 0) {
+				sums.rowRange(0, band_rows).copyTo(new_sums.rowRange(0, band_rows));
+				weights.rowRange(0, band_rows).copyTo(new_weights.rowRange(0, band_rows));
+			}
+			sums = new_sums;
+			weights = new_weights;
+		}
+
+		void MosaicAccumulator::add_patch(int col_start, int row_start, const cv::Mat& image) {
+
+			std::lock_guard<std::mutex> lock(mtx);
+			if (finalized)
+				throw std::runtime_error("Cannot add a patch to a finalized MosaicAccumulator!");
+			if (image.channels() < band_count)
+				throw std::runtime_error("Patch channels count is lower than the sink dataset bands count!");
+
+			cv::Rect patch_rect(col_start, row_start, image.cols, image.rows);
+			cv::Rect sink_rect = patch_rect & cv::Rect(0, 0, width, height);
+			if (sink_rect.empty())
+				throw std::runtime_error("Patch is fully outside the sink dataset!");
+			if (sink_rect.y < band_row_start)
+				throw std::runtime_error("Patch overlaps rows already written! Patches should be added by non decreasing row start.");
+
+			// rows above the patch are complete
+			write_rows_before(sink_rect.y);
+
+			cv::Mat cropped = image(sink_rect - patch_rect.tl());
+			if (image.channels() > band_count) {
+				std::vector<cv::Mat> channels;
+				cv::split(cropped, channels);
+				channels.resize(band_count);
+				cv::merge(channels, cropped);
+			}
+			cv::Mat patch_values;
+			cropped.convertTo(patch_values, CV_32F);
+			cv::Mat c_weights = patch_weights(image.rows, image.cols)(sink_rect - patch_rect.tl());
+
+			int needed_rows = sink_rect.br().y - band_row_start;
+			ensure_band_capacity(needed_rows);
+			cv::Rect band_rect(sink_rect.x, sink_rect.y - band_row_start, sink_rect.width, sink_rect.height);
+
+			cv::Mat sums_roi = sums(band_rect), weights_roi = weights(band_rect);
+			cv::Mat weighted_values;
+			cv::multiply(patch_values, repeat_channels(c_weights, band_count), weighted_values);
+			sums_roi += weighted_values;
+			weights_roi += c_weights;
+			band_rows = std::max(band_rows, needed_rows);
+		}
+
+		void MosaicAccumulator::write_band_rows(int rows_count) {
+
+			cv::Mat out_values(rows_count, width, value_type);
+			CPLErr err = dataset->RasterIO(GF_Read, 0, band_row_start, width, rows_count, out_values.data, width, rows_count, buffer_type,
+				band_count, nullptr, static_cast<GSpacing>(out_values.elemSize()), static_cast<GSpacing>(out_values.step[0]), static_cast<GSpacing>(out_values.elemSize1()), nullptr);
+			if (err != CE_None)
+				throw std::runtime_error("Unable to read back rows of the sink dataset!");
+
+			cv::Mat c_weights = weights.rowRange(0, rows_count);
+			cv::Mat means, converted_means;
+			cv::divide(sums.rowRange(0, rows_count), repeat_channels(c_weights, band_count), means);
+			means.convertTo(converted_means, CV_MAT_DEPTH(value_type));
+			converted_means.copyTo(out_values, c_weights > 0);
+
+			err = dataset->RasterIO(GF_Write, 0, band_row_start, width, rows_count, out_values.data, width, rows_count, buffer_type,
+				band_count, nullptr, static_cast<GSpacing>(out_values.elemSize()), static_cast<GSpacing>(out_values.step[0]), static_cast<GSpacing>(out_values.elemSize1()), nullptr);
+			if (err != CE_None)
+				throw std::runtime_error("Unable to write rows of the sink dataset!");
+		}
+
+		void MosaicAccumulator::flush_rows(int row_end) {
+			std::lock_guard<std::mutex> lock(mtx);
+			if (finalized)
+				return;
+			write_rows_before(row_end);
+		}
+
+		void MosaicAccumulator::write_rows_before(int row_end) {
+
+			row_end = std::min(row_end, height);
+			if (row_end <= band_row_start)
+				return;
+
+			int written_rows = std::min(row_end - band_row_start, band_rows);
+			if (written_rows > 0)
+				write_band_rows(written_rows);
+
+			// move the remaining rows to the top of the band
+			int remaining_rows = band_rows - written_rows;
+			if (remaining_rows > 0) {
+				cv::Mat remaining_sums = sums.rowRange(written_rows, band_rows).clone();
+				cv::Mat remaining_weights = weights.rowRange(written_rows, band_rows).clone();
+				remaining_sums.copyTo(sums.rowRange(0, remaining_rows));
+				remaining_weights.copyTo(weights.rowRange(0, remaining_rows));
+			}
+			if (band_rows > 0) {
+				sums.rowRange(remaining_rows, band_rows).setTo(0);
+				weights.rowRange(remaining_rows, band_rows).setTo(0);
+			}
+			band_rows = remaining_rows;
+			band_row_start = row_end;
+		}
+
+		void MosaicAccumulator::finalize() {
+			std::lock_guard<std::mutex> lock(mtx);
+			if (finalized)
+				return;
+			write_rows_before(height);
+			dataset->FlushCache();
+			sums.release();
+			weights.release();
+			finalized = true;
+		}
+
+	}
+}
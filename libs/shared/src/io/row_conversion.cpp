@@ -0,0 +1,43 @@
+#include "row_conversion.h"
+#include <opencv2/core/core.hpp>
+
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+
+		namespace row_conversion
+		{
+
+			template <typename src_t>
+			static bool convert_row_to_depth(const src_t* src, int dst_depth, void* dst, size_t n, size_t dst_stride) {
+				switch (dst_depth) {
+				case CV_8U: convert_row(src, static_cast<uint8_t*>(dst), n, dst_stride); return true;
+				case CV_8S: convert_row(src, static_cast<int8_t*>(dst), n, dst_stride); return true;
+				case CV_16U: convert_row(src, static_cast<uint16_t*>(dst), n, dst_stride); return true;
+				case CV_16S: convert_row(src, static_cast<int16_t*>(dst), n, dst_stride); return true;
+				case CV_32S: convert_row(src, static_cast<int32_t*>(dst), n, dst_stride); return true;
+				case CV_32F: convert_row(src, static_cast<float*>(dst), n, dst_stride); return true;
+				case CV_64F: convert_row(src, static_cast<double*>(dst), n, dst_stride); return true;
+				default: return false;
+				}
+			}
+
+			bool convert_row(GDALDataType src_type, const void* src, int dst_depth, void* dst, size_t n, size_t dst_stride) {
+				switch (src_type) {
+				case GDT_Byte: return convert_row_to_depth(static_cast<const uint8_t*>(src), dst_depth, dst, n, dst_stride);
+				case GDT_UInt16: return convert_row_to_depth(static_cast<const uint16_t*>(src), dst_depth, dst, n, dst_stride);
+				case GDT_Int16: return convert_row_to_depth(static_cast<const int16_t*>(src), dst_depth, dst, n, dst_stride);
+				case GDT_UInt32: return convert_row_to_depth(static_cast<const uint32_t*>(src), dst_depth, dst, n, dst_stride);
+				case GDT_Int32: return convert_row_to_depth(static_cast<const int32_t*>(src), dst_depth, dst, n, dst_stride);
+				case GDT_Float32: return convert_row_to_depth(static_cast<const float*>(src), dst_depth, dst, n, dst_stride);
+				case GDT_Float64: return convert_row_to_depth(static_cast<const double*>(src), dst_depth, dst, n, dst_stride);
+				default: return false;
+				}
+			}
+
+		}
+	}
+}
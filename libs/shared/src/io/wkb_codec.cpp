@@ -0,0 +1,250 @@
+#include "wkb_codec.h"
+#include <array>
+#include <bit>
+#include <cstring>
+
+
+namespace LxGeo
+{
+
+	namespace IO_DATA
+	{
+
+		namespace wkb
+		{
+
+			enum : uint32_t { wkb_point = 1, wkb_linestring = 2, wkb_polygon = 3 };
+
+			// Extended (EWKB / OGR 2.5D) type flags
+			static constexpr uint32_t ewkb_z_flag = 0x80000000, ewkb_m_flag = 0x40000000, ewkb_srid_flag = 0x20000000;
+
+			template <typename T>
+			static T byte_swap(T value) {
+				T swapped = 0;
+				for (size_t byte_idx = 0; byte_idx < sizeof(T); byte_idx++) {
+					swapped = (swapped << 8) | (value & 0xFF);
+					value >>= 8;
+				}
+				return swapped;
+			}
+
+			class WKBReader {
+			public:
+				WKBReader(const unsigned char* _data, size_t _size) : data(_data), end(_data + _size) {};
+
+				// Reads the byte order and geometry type, returns the base type (0 on error)
+				uint32_t read_header() {
+					if (!has_bytes(5))
+						return 0;
+					swap_bytes = (*data++ == 0) == (std::endian::native == std::endian::little);
+					uint32_t type = read_uint32();
+					size_t dims = 2;
+					if (type & ewkb_z_flag) dims++;
+					if (type & ewkb_m_flag) dims++;
+					if (type & ewkb_srid_flag) {
+						if (!has_bytes(4)) return 0;
+						data += 4;
+					}
+					type &= 0x0FFFFFFF;
+					// ISO: 1000 Z, 2000 M, 3000 ZM
+					uint32_t iso_dims = type / 1000;
+					type %= 1000;
+					if (iso_dims == 1 || iso_dims == 2) dims++;
+					else if (iso_dims == 3) dims += 2;
+					point_size = dims * sizeof(double);
+					return type;
+				}
+
+				bool read_count(uint32_t& count) {
+					if (!has_bytes(4))
+						return false;
+					count = read_uint32();
+					return true;
+				}
+
+				// Checked before sizing containers from counts read in the blob
+				bool has_points(size_t count) const { return count <= remaining_bytes() / point_size; }
+
+				size_t remaining_bytes() const { return size_t(end - data); }
+
+				// Reads count points in a pre-sized range
+				template <typename point_iterator>
+				bool read_points(point_iterator out_begin, size_t count) {
+					if (!has_points(count))
+						return false;
+					for (size_t pt_idx = 0; pt_idx < count; pt_idx++, ++out_begin) {
+						out_begin->template set<0>(read_double(data));
+						out_begin->template set<1>(read_double(data + sizeof(double)));
+						data += point_size;
+					}
+					return true;
+				}
+
+			private:
+				bool has_bytes(size_t n) const { return remaining_bytes() >= n; }
+
+				uint32_t read_uint32() {
+					uint32_t value; std::memcpy(&value, data, sizeof(value));
+					data += sizeof(value);
+					return swap_bytes ? byte_swap(value) : value;
+				}
+
+				double read_double(const unsigned char* at) const {
+					uint64_t bits; std::memcpy(&bits, at, sizeof(bits));
+					if (swap_bytes) bits = byte_swap(bits);
+					double value; std::memcpy(&value, &bits, sizeof(value));
+					return value;
+				}
+
+			private:
+				const unsigned char* data;
+				const unsigned char* end;
+				bool swap_bytes = false;
+				size_t point_size = 2 * sizeof(double);
+			};
+
+			const unsigned char* gpkg_blob_wkb(const unsigned char* blob, size_t blob_size, size_t& wkb_size) {
+				if (blob_size < 8 || blob[0] != 'G' || blob[1] != 'P')
+					return nullptr;
+				unsigned char flags = blob[3];
+				bool empty_geometry = flags & 0x10;
+				static constexpr size_t envelope_sizes[8] = { 0, 32, 48, 48, 64, 0, 0, 0 };
+				size_t header_size = 8 + envelope_sizes[(flags >> 1) & 0x07];
+				if (empty_geometry || blob_size <= header_size)
+					return nullptr;
+				wkb_size = blob_size - header_size;
+				return blob + header_size;
+			}
+
+			bool decode(const unsigned char* data, size_t size, Boost_Point_2& out_point) {
+				WKBReader reader(data, size);
+				if (reader.read_header() != wkb_point)
+					return false;
+				return reader.read_points(&out_point, 1);
+			}
+
+			bool decode(const unsigned char* data, size_t size, Boost_LineString_2& out_linestring) {
+				WKBReader reader(data, size);
+				uint32_t points_count;
+				if (reader.read_header() != wkb_linestring || !reader.read_count(points_count) || !reader.has_points(points_count))
+					return false;
+				out_linestring.resize(points_count);
+				return reader.read_points(out_linestring.begin(), points_count);
+			}
+
+			bool decode(const unsigned char* data, size_t size, Boost_Polygon_2& out_polygon) {
+				WKBReader reader(data, size);
+				uint32_t rings_count;
+				if (reader.read_header() != wkb_polygon || !reader.read_count(rings_count))
+					return false;
+				out_polygon.clear();
+				if (rings_count == 0)
+					return true;
+				// a ring count can't exceed the remaining bytes (4 bytes per ring at least)
+				if (rings_count > reader.remaining_bytes() / 4)
+					return false;
+				out_polygon.inners().resize(rings_count - 1);
+				for (uint32_t ring_idx = 0; ring_idx < rings_count; ring_idx++) {
+					Boost_Ring_2& c_ring = (ring_idx == 0) ? out_polygon.outer() : out_polygon.inners()[ring_idx - 1];
+					uint32_t points_count;
+					if (!reader.read_count(points_count) || !reader.has_points(points_count))
+						return false;
+					c_ring.resize(points_count);
+					if (!reader.read_points(c_ring.begin(), points_count))
+						return false;
+				}
+				return true;
+			}
+
+			static constexpr size_t header_size = 1 + 4, point_size = 2 * sizeof(double);
+
+			size_t encoded_size(const Boost_Point_2& point) {
+				return header_size + point_size;
+			}
+
+			size_t encoded_size(const Boost_LineString_2& linestring) {
+				return header_size + 4 + linestring.size() * point_size;
+			}
+
+			size_t encoded_size(const Boost_Polygon_2& polygon) {
+				if (polygon.outer().empty())
+					return header_size + 4;
+				size_t size = header_size + 4 + 4 + polygon.outer().size() * point_size;
+				for (const auto& c_ring : polygon.inners())
+					size += 4 + c_ring.size() * point_size;
+				return size;
+			}
+
+			class WKBWriter {
+			public:
+				WKBWriter(unsigned char* _data) : data(_data) {};
+
+				void write_header(uint32_t type) {
+					*data++ = 1; // little endian
+					write_uint32(type);
+				}
+
+				void write_uint32(uint32_t value) {
+					if constexpr (std::endian::native == std::endian::big)
+						value = byte_swap(value);
+					std::memcpy(data, &value, sizeof(value));
+					data += sizeof(value);
+				}
+
+				template <typename point_range>
+				void write_points(const point_range& points) {
+					for (const Boost_Point_2& c_point : points) {
+						write_double(c_point.get<0>());
+						write_double(c_point.get<1>());
+					}
+				}
+
+			private:
+				void write_double(double value) {
+					uint64_t bits; std::memcpy(&bits, &value, sizeof(bits));
+					if constexpr (std::endian::native == std::endian::big)
+						bits = byte_swap(bits);
+					std::memcpy(data, &bits, sizeof(bits));
+					data += sizeof(bits);
+				}
+
+			private:
+				unsigned char* data;
+			};
+
+			void encode(const Boost_Point_2& point, std::vector<unsigned char>& out_data) {
+				out_data.resize(encoded_size(point));
+				WKBWriter writer(out_data.data());
+				writer.write_header(wkb_point);
+				writer.write_points(std::array<Boost_Point_2, 1>{ point });
+			}
+
+			void encode(const Boost_LineString_2& linestring, std::vector<unsigned char>& out_data) {
+				out_data.resize(encoded_size(linestring));
+				WKBWriter writer(out_data.data());
+				writer.write_header(wkb_linestring);
+				writer.write_uint32(static_cast<uint32_t>(linestring.size()));
+				writer.write_points(linestring);
+			}
+
+			void encode(const Boost_Polygon_2& polygon, std::vector<unsigned char>& out_data) {
+				out_data.resize(encoded_size(polygon));
+				WKBWriter writer(out_data.data());
+				writer.write_header(wkb_polygon);
+				// a polygon without exterior ring is written as an empty polygon
+				if (polygon.outer().empty()) {
+					writer.write_uint32(0);
+					return;
+				}
+				writer.write_uint32(static_cast<uint32_t>(1 + polygon.inners().size()));
+				writer.write_uint32(static_cast<uint32_t>(polygon.outer().size()));
+				writer.write_points(polygon.outer());
+				for (const auto& c_ring : polygon.inners()) {
+					writer.write_uint32(static_cast<uint32_t>(c_ring.size()));
+					writer.write_points(c_ring);
+				}
+			}
+
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#include "geometries_with_attributes/geometries_with_attributes.h"
+#include <thread>
+
+using namespace LxGeo::GeometryFactoryShared;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& message) {
+	if (!condition) {
+		std::cerr << "FAILED: " << message << std::endl;
+		failures++;
+	}
+}
+
+// Threads set attributes of interleaved rows (rows sharing validity words), adding fields and string values concurrently
+static void concurrent_row_setters() {
+	const size_t threads_count = 8, rows_count = 20000;
+	auto table = std::make_shared<AttributeTable>();
+	table->add_rows(rows_count);
+	std::vector<Geometries_with_attributes<Boost_Point_2>> geometries(rows_count);
+	for (size_t row = 0; row < rows_count; row++)
+		geometries[row].attach_attributes_row(table, row);
+
+	std::vector<std::thread> workers;
+	for (size_t thread_idx = 0; thread_idx < threads_count; thread_idx++) {
+		workers.emplace_back([&, thread_idx]() {
+			for (size_t row = thread_idx; row < rows_count; row += threads_count) {
+				geometries[row].set_int_attribute("row", int(row));
+				geometries[row].set_double_attribute("half_row_" + std::to_string(thread_idx % 2), row / 2.0);
+				geometries[row].set_string_attribute("label", "label_" + std::to_string(row % 97));
+				if (row % 3 == 0)
+					geometries[row].set_int_attribute("every_third", 1);
+			}
+			});
+	}
+	for (auto& worker : workers)
+		worker.join();
+
+	check(table->fields_count() == 5, "each field is added once");
+	for (size_t row = 0; row < rows_count; row++) {
+		const auto& gwa = geometries[row];
+		check(gwa.get_int_attribute("row") == int(row), "int value of row " + std::to_string(row));
+		size_t thread_idx = row % threads_count;
+		check(gwa.get_double_attribute("half_row_" + std::to_string(thread_idx % 2)) == row / 2.0, "double value of row " + std::to_string(row));
+		check(table->is_null(row, *table->find_field("half_row_" + std::to_string(1 - thread_idx % 2), AttributeType::real)), "field of other threads is null in row " + std::to_string(row));
+		check(gwa.get_string_attribute("label") == "label_" + std::to_string(row % 97), "string value of row " + std::to_string(row));
+		check(table->is_null(row, *table->find_field("every_third", AttributeType::int64)) == (row % 3 != 0), "validity bit of row " + std::to_string(row));
+	}
+	check(table->string_dictionary(*table->find_field("label", AttributeType::string)).size() == 97, "each string value is added once to the dictionary");
+}
+
+int main() {
+	concurrent_row_setters();
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,48 @@
+#include "gdal_dataset_pool.h"
+#include <filesystem>
+
+using namespace LxGeo::IO_DATA;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& message) {
+	if (!condition) {
+		std::cerr << "FAILED: " << message << std::endl;
+		failures++;
+	}
+}
+
+// A handle acquired before evict must not go back to the pool when released
+static void acquire_evict_release_reacquire(const std::string& raster_path) {
+	GDALDatasetPool& pool = GDALDatasetPool::instance();
+	pool.clear();
+	pool.reset_stats();
+
+	std::shared_ptr<GDALDataset> stale_dataset = pool.acquire(raster_path);
+	pool.evict(raster_path);
+	stale_dataset.reset();
+	check(pool.stats().idle_handles == 0, "released handle of an evicted file is not pooled");
+	check(pool.stats().open_handles == 0, "released handle of an evicted file is closed");
+
+	std::shared_ptr<GDALDataset> new_dataset = pool.acquire(raster_path);
+	check(pool.stats().misses == 2 && pool.stats().hits == 0, "acquire after evict opens a new handle");
+	new_dataset.reset();
+	check(pool.stats().idle_handles == 1, "handle acquired after evict goes back to the pool");
+
+	pool.acquire(raster_path).reset();
+	check(pool.stats().hits == 1, "pooled handle is reused");
+	pool.clear();
+}
+
+int main() {
+	GDALAllRegister();
+	std::string raster_path = (std::filesystem::temp_directory_path() / "gdal_dataset_pool_test.tif").string();
+	GDALDriver* gtiff_driver = GetGDALDriverManager()->GetDriverByName("GTiff");
+	GDALDataset* raster_dataset = gtiff_driver->Create(raster_path.c_str(), 8, 8, 1, GDT_Byte, NULL);
+	GDALClose((GDALDatasetH)raster_dataset);
+
+	acquire_evict_release_reacquire(raster_path);
+
+	std::filesystem::remove(raster_path);
+	return failures == 0 ? 0 : 1;
+}
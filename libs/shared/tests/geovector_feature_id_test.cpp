@@ -0,0 +1,84 @@
+#include "defs.h"
+#include "lightweight/geovector.h"
+#include <filesystem>
+#include <set>
+
+using namespace LxGeo::IO_DATA;
+using namespace LxGeo::GeometryFactoryShared;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& message) {
+	if (!condition) {
+		std::cerr << "FAILED: " << message << std::endl;
+		failures++;
+	}
+}
+
+static Boost_Polygon_2 square(double x, double y) {
+	Boost_Polygon_2 polygon;
+	bg::read_wkt(fmt::format("POLYGON(({0} {1},{0} {3},{2} {3},{2} {1},{0} {1}))", x, y, x + 1, y + 1), polygon);
+	return polygon;
+}
+
+// Layer of features_count unit squares with a "name" field (FIDs assigned by the driver)
+static void create_layer(const std::string& vector_path, int features_count) {
+	GDALDriver* gpkg_driver = GetGDALDriverManager()->GetDriverByName("GPKG");
+	GDALDataset* vector_dataset = gpkg_driver->Create(vector_path.c_str(), 0, 0, 0, GDT_Unknown, NULL);
+	OGRLayer* layer = vector_dataset->CreateLayer("squares", nullptr, wkbPolygon, NULL);
+	OGRFieldDefn name_field("name", OFTString);
+	layer->CreateField(&name_field);
+	for (int feature_idx = 0; feature_idx < features_count; feature_idx++) {
+		OGRFeatureUniquePtr feature(OGRFeature::CreateFeature(layer->GetLayerDefn()));
+		feature->SetField("name", fmt::format("loaded_{}", feature_idx).c_str());
+		feature->SetGeometryDirectly(transform_B2OGR_Polygon(square(feature_idx, 0)).clone());
+		layer->CreateFeature(feature.get());
+	}
+	GDALClose((GDALDatasetH)vector_dataset);
+}
+
+// Geometries added to a loaded GeoVector are new features when written back in update mode
+static void load_add_write_update(const std::string& vector_path) {
+	const int loaded_count = 3;
+	create_layer(vector_path, loaded_count);
+
+	GeoVector<Boost_Polygon_2> gvec = GeoVector<Boost_Polygon_2>::from_file(vector_path);
+	check(gvec.length() == loaded_count, "all features are loaded");
+	std::set<int> loaded_ids;
+	for (const auto& gwa : gvec.geometries_container)
+		loaded_ids.insert(gwa.get_int_attribute(GeoVector<Boost_Polygon_2>::ID_FIELD_NAME));
+
+	gvec.add_geometry(square(10, 10));
+	int added_id = gvec.geometries_container.back().get_int_attribute(GeoVector<Boost_Polygon_2>::ID_FIELD_NAME);
+	check(loaded_ids.count(added_id) == 0, "added geometry identifier differs from loaded FIDs");
+	check(added_id > *loaded_ids.rbegin(), "added geometry identifier follows the largest loaded FID");
+
+	{
+		auto vector_dataset = load_gdal_vector_dataset_shared_ptr(vector_path, GDAL_OF_UPDATE);
+		gvec.to_dataset(vector_dataset.get(), WriteMode::update);
+	}
+
+	GeoVector<Boost_Polygon_2> reloaded_gvec = GeoVector<Boost_Polygon_2>::from_file(vector_path);
+	check(reloaded_gvec.length() == loaded_count + 1, "added geometry is written as a new feature");
+	std::set<std::string> reloaded_names;
+	for (const auto& gwa : reloaded_gvec.geometries_container)
+		reloaded_names.insert(gwa.get_string_attribute("name"));
+	for (int feature_idx = 0; feature_idx < loaded_count; feature_idx++)
+		check(reloaded_names.count(fmt::format("loaded_{}", feature_idx)) == 1, fmt::format("loaded feature {} is not overwritten", feature_idx));
+
+	// a GeoVector loaded again continues after the written feature
+	reloaded_gvec.add_geometry(square(20, 20));
+	check(reloaded_gvec.geometries_container.back().get_int_attribute(GeoVector<Boost_Polygon_2>::ID_FIELD_NAME) > added_id,
+		"identifiers keep increasing across loads");
+}
+
+int main() {
+	GDALAllRegister();
+	std::string vector_path = (std::filesystem::temp_directory_path() / "geovector_feature_id_test.gpkg").string();
+	std::filesystem::remove(vector_path);
+
+	load_add_write_update(vector_path);
+
+	std::filesystem::remove(vector_path);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+#include "spatial_datasets/patchified_dataset.h"
+#include <fmt/format.h>
+#include <iostream>
+
+using namespace LxGeo::GeometryFactoryShared;
+using namespace LxGeo::IO_DATA;
+
+/**
+Block access report of patch grids over synthetic 10000x10000 rasters (tiled 256x256 and one row strips), for unaligned
+and block aligned grids in every patch ordering. Results only depend on the profiles below, no raster is read.
+Usage: patch_block_access_report [block_cache_capacity]
+*/
+
+static RProfile synthetic_profile(int block_width, int block_height) {
+	const double geotransform[6] = { 500000.5, 0.5, 0, 4000000.25, 0, -0.5 };
+	RProfile profile(10000, 10000, 1, geotransform, GDT_Byte);
+	profile.block_width = block_width;
+	profile.block_height = block_height;
+	return profile;
+}
+
+static void report_line(const std::string& profile_name, const RProfile& profile, double patch_px, double overlap_px, double pad_px,
+	PatchGridLayout layout, const std::string& layout_name, size_t block_cache_capacity) {
+	Boost_Polygon_2 boundary;
+	bg::assign(boundary, profile.to_box_extents());
+	ContinuousPatchifiedDataset cpd({ patch_px * profile.gsd(), overlap_px * profile.gsd(), pad_px * profile.gsd(), boundary }, profile, layout);
+	BlockAccessReport report = cpd.block_access_report(profile, block_cache_capacity);
+	double snapped_patch_px = cpd.patchified_dst_parameters.spatial_patch_size / profile.gsd();
+	double snapped_step_px = snapped_patch_px - cpd.patchified_dst_parameters.spatial_patch_overlap / profile.gsd();
+	std::cout << fmt::format("{:<10}{:>16}{:>26}{:>7.0f}{:>6.0f}{:>9}{:>10}{:>9.2f}{:>10}{:>10}",
+		profile_name, fmt::format("{}/{}/{}", patch_px, overlap_px, pad_px), layout_name, snapped_patch_px, snapped_step_px,
+		report.n_patches, report.n_block_reads, report.blocks_per_patch(), report.n_distinct_blocks, report.n_block_cache_misses) << std::endl;
+}
+
+int main(int argc, char** argv) {
+	size_t block_cache_capacity = (argc > 1) ? std::stoul(argv[1]) : 16;
+	std::vector<std::pair<std::string, RProfile>> profiles = { { "tiled256", synthetic_profile(256, 256) }, { "strip", synthetic_profile(10000, 1) } };
+	std::vector<std::pair<std::string, PatchGridLayout>> layouts = {
+		{ "unaligned grid", { false, PatchOrdering::grid } },
+		{ "aligned grid", { true, PatchOrdering::grid } },
+		{ "aligned block_major", { true, PatchOrdering::block_major } },
+		{ "aligned z_order", { true, PatchOrdering::z_order } },
+		{ "aligned row_major", { true, PatchOrdering::row_major } }
+	};
+	// patch / overlap / pad sizes in pixels
+	std::vector<std::array<double, 3>> patch_sizes = { { 512, 64, 0 }, { 500, 50, 30 }, { 200, 0, 0 } };
+
+	std::cout << fmt::format("{:<10}{:>16}{:>26}{:>7}{:>6}{:>9}{:>10}{:>9}{:>10}{:>10}",
+		"profile", "patch/ovl/pad", "layout", "patch", "step", "patches", "reads", "blk/pt", "distinct", fmt::format("miss({})", block_cache_capacity)) << std::endl;
+	for (const auto& [profile_name, profile] : profiles)
+		for (const auto& c_sizes : patch_sizes)
+			for (const auto& [layout_name, layout] : layouts)
+				report_line(profile_name, profile, c_sizes[0], c_sizes[1], c_sizes[2], layout, layout_name, block_cache_capacity);
+	return 0;
+}
@@ -0,0 +1,162 @@
+#include "geometry_rasterizer/polygon_scanline.h"
+#include <random>
+
+using namespace LxGeo::GeometryFactoryShared;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& message) {
+	if (!condition) {
+		std::cerr << "FAILED: " << message << std::endl;
+		failures++;
+	}
+}
+
+static Boost_Polygon_2 from_wkt(const std::string& wkt) {
+	Boost_Polygon_2 polygon;
+	bg::read_wkt(wkt, polygon);
+	bg::correct(polygon);
+	return polygon;
+}
+
+// Row major mask of the runs, false when runs are out of the raster, unsorted or overlapping (runs of a row may be adjacent)
+static bool runs_mask(const std::vector<PixelRun>& runs, int rows, int cols, std::vector<char>& mask) {
+	mask.assign(size_t(rows) * cols, 0);
+	for (size_t run_idx = 0; run_idx < runs.size(); run_idx++) {
+		const PixelRun& c_run = runs[run_idx];
+		if (c_run.row < 0 || c_run.row >= rows || c_run.col_begin < 0 || c_run.col_end > cols || c_run.length() <= 0)
+			return false;
+		if (run_idx > 0) {
+			const PixelRun& previous_run = runs[run_idx - 1];
+			if (previous_run.row > c_run.row || (previous_run.row == c_run.row && previous_run.col_end > c_run.col_begin))
+				return false;
+		}
+		for (int c_col = c_run.col_begin; c_col < c_run.col_end; c_col++)
+			mask[size_t(c_run.row) * cols + c_col] = 1;
+	}
+	return true;
+}
+
+/*
+Pixels whose center is inside the polygon, or (all_touched) whose square intersects the polygon interior.
+Centers on the boundary follow the scanline half open rule ([x_in, x_out) on each row, rows in [y_min, y_max)): the center is
+nudged toward increasing columns (and, far less, rows) before the inside test.
+*/
+static std::vector<char> reference_mask(const Boost_Polygon_2& polygon, int rows, int cols, bool all_touched) {
+	std::vector<char> mask(size_t(rows) * cols, 0);
+	for (int c_row = 0; c_row < rows; c_row++) {
+		for (int c_col = 0; c_col < cols; c_col++) {
+			if (!all_touched)
+				mask[size_t(c_row) * cols + c_col] = bg::within(Boost_Point_2(c_col + 0.5 + 1e-6, c_row + 0.5 + 1e-9), polygon);
+			else {
+				std::vector<Boost_Polygon_2> pixel_intersection;
+				bg::intersection(Boost_Box_2(Boost_Point_2(c_col, c_row), Boost_Point_2(c_col + 1, c_row + 1)), polygon, pixel_intersection);
+				double intersection_area = 0;
+				for (const Boost_Polygon_2& c_part : pixel_intersection)
+					intersection_area += bg::area(c_part);
+				mask[size_t(c_row) * cols + c_col] = intersection_area > 1e-12;
+			}
+		}
+	}
+	return mask;
+}
+
+static void check_against_reference(const Boost_Polygon_2& polygon, int rows, int cols, bool all_touched, const std::string& name) {
+	std::vector<PixelRun> runs = { { 1, 2, 3 } }; // cleared first
+	polygon_pixel_runs(polygon, rows, cols, all_touched, runs);
+	std::vector<char> mask;
+	check(runs_mask(runs, rows, cols, mask), name + ": runs are clipped, sorted and do not overlap");
+	check(mask == reference_mask(polygon, rows, cols, all_touched), name + (all_touched ? ": all touched pixels" : ": centered pixels"));
+}
+
+static void holes() {
+	Boost_Polygon_2 polygon = from_wkt("POLYGON((0 0,0 10,10 10,10 0,0 0),(3 3,7 3,7 7,3 7,3 3))");
+	std::vector<PixelRun> runs;
+	polygon_pixel_runs(polygon, 12, 12, false, runs);
+	size_t pixels_count = 0, hole_rows_runs = 0;
+	for (const PixelRun& c_run : runs) {
+		pixels_count += c_run.length();
+		hole_rows_runs += (c_run.row >= 3 && c_run.row < 7);
+	}
+	check(pixels_count == 100 - 16, "square with a hole: pixels of the hole are excluded");
+	check(hole_rows_runs == 8, "square with a hole: rows crossing the hole have two runs");
+
+	check_against_reference(from_wkt("POLYGON((0.3 0.6,1.2 19.4,18.7 17.2,19.6 0.9,0.3 0.6),(4.5 4.5,8.2 4.1,7.7 9.3,4.5 4.5),(11 11,15.5 11,15.5 14.5,11 14.5,11 11))"),
+		20, 20, false, "polygon with two holes");
+	check_against_reference(from_wkt("POLYGON((0.3 0.6,1.2 19.4,18.7 17.2,19.6 0.9,0.3 0.6),(4.5 4.5,8.2 4.1,7.7 9.3,4.5 4.5),(11 11,15.5 11,15.5 14.5,11 14.5,11 11))"),
+		20, 20, true, "polygon with two holes");
+}
+
+// Vertices and edges lying exactly on pixel borders (and centers) must not add or drop a row or a column
+static void vertices_on_pixel_borders() {
+	Boost_Polygon_2 square = from_wkt("POLYGON((2 2,2 4,5 4,5 2,2 2))");
+	for (bool all_touched : { false, true }) {
+		std::vector<PixelRun> runs;
+		polygon_pixel_runs(square, 8, 8, all_touched, runs);
+		bool exact = runs.size() == 2;
+		for (size_t run_idx = 0; exact && run_idx < runs.size(); run_idx++)
+			exact = runs[run_idx].row == 2 + int(run_idx) && runs[run_idx].col_begin == 2 && runs[run_idx].col_end == 5;
+		check(exact, std::string("pixel aligned square covers exactly its pixels") + (all_touched ? " (all touched)" : ""));
+	}
+	for (bool all_touched : { false, true }) {
+		check_against_reference(from_wkt("POLYGON((4 0,0 4,4 8,8 4,4 0))"), 9, 9, all_touched, "diamond with vertices on pixel corners");
+		check_against_reference(from_wkt("POLYGON((1.5 1.5,1.5 6.5,6.5 6.5,6.5 1.5,1.5 1.5))"), 9, 9, all_touched, "square with vertices on pixel centers");
+		check_against_reference(from_wkt("POLYGON((1 1,1 7,3 7,3 3,6 3,6 7,8 7,8 1,1 1))"), 9, 9, all_touched, "concave pixel aligned polygon");
+	}
+}
+
+static void clipping() {
+	std::vector<PixelRun> runs;
+	polygon_pixel_runs(from_wkt("POLYGON((-5 -5,-5 15,15 15,15 -5,-5 -5))"), 4, 6, false, runs);
+	bool full = runs.size() == 4;
+	for (size_t run_idx = 0; full && run_idx < runs.size(); run_idx++)
+		full = runs[run_idx].row == int(run_idx) && runs[run_idx].col_begin == 0 && runs[run_idx].col_end == 6;
+	check(full, "polygon covering the raster gives one full run per row");
+
+	polygon_pixel_runs(from_wkt("POLYGON((20 20,20 30,30 30,30 20,20 20))"), 4, 6, true, runs);
+	check(runs.empty(), "polygon outside the raster gives no run");
+	polygon_pixel_runs(from_wkt("POLYGON((-3 -3,-3 -1,-1 -1,-1 -3,-3 -3))"), 4, 6, true, runs);
+	check(runs.empty(), "polygon before the raster origin gives no run");
+
+	for (bool all_touched : { false, true }) {
+		check_against_reference(from_wkt("POLYGON((-2.5 3.2,4.1 -3.7,9.6 2.4,3.3 9.8,-2.5 3.2))"), 6, 7, all_touched, "polygon crossing every raster side");
+		check_against_reference(from_wkt("POLYGON((-4 -4,-4 12,12 12,12 -4,-4 -4),(1.5 1.5,4.5 1.5,4.5 4.5,1.5 4.5,1.5 1.5))"), 6, 7, all_touched, "clipped polygon with a hole");
+	}
+}
+
+// Random star polygons (some with a hole) partly outside the raster against the per pixel references
+static void random_polygons() {
+	std::mt19937 generator(5);
+	std::uniform_real_distribution<double> center(-5, 45), angle(0, 6.283), radius(3, 20);
+	const int rows = 37, cols = 41;
+	for (int polygon_idx = 0; polygon_idx < 100; polygon_idx++) {
+		Boost_Polygon_2 polygon;
+		double center_x = center(generator), center_y = center(generator);
+		std::vector<double> angles(3 + generator() % 12);
+		for (double& c_angle : angles)
+			c_angle = angle(generator);
+		std::sort(angles.begin(), angles.end());
+		for (double c_angle : angles) {
+			double c_radius = radius(generator);
+			bg::append(polygon.outer(), Boost_Point_2(center_x + c_radius * std::cos(c_angle), center_y + c_radius * std::sin(c_angle)));
+		}
+		if (polygon_idx % 3 == 0) {
+			polygon.inners().resize(1);
+			for (int vertex_idx = 0; vertex_idx < 4; vertex_idx++)
+				bg::append(polygon.inners()[0], Boost_Point_2(center_x + 2 * std::cos(vertex_idx * 1.57), center_y + 2 * std::sin(vertex_idx * 1.57)));
+		}
+		bg::correct(polygon);
+		if (!bg::is_valid(polygon))
+			continue;
+		for (bool all_touched : { false, true })
+			check_against_reference(polygon, rows, cols, all_touched, "random polygon " + std::to_string(polygon_idx));
+	}
+}
+
+int main() {
+	holes();
+	vertices_on_pixel_borders();
+	clipping();
+	random_polygons();
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#include "row_conversion.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace LxGeo::IO_DATA::row_conversion;
+
+/**
+Pixels per second of convert_row (vectorized prefix, compiled for the target: AVX2 else SSE2) against convert_row_scalar,
+for the pairs having a vectorized kernel.
+Usage: row_conversion_bench [row_pixels] [rows_count]
+*/
+
+template <typename src_t, typename dst_t>
+static void bench_pair(const std::string& pair_name, size_t row_pixels, size_t rows_count) {
+	std::vector<src_t> src(row_pixels);
+	for (size_t i = 0; i < row_pixels; ++i)
+		src[i] = src_t(i % 251);
+	std::vector<dst_t> dst(row_pixels);
+
+	double checksum = 0;
+	auto simd_start = std::chrono::steady_clock::now();
+	for (size_t row = 0; row < rows_count; ++row) {
+		convert_row<src_t, dst_t>(src.data(), dst.data(), row_pixels);
+		checksum += double(dst[row % row_pixels]);
+	}
+	auto scalar_start = std::chrono::steady_clock::now();
+	for (size_t row = 0; row < rows_count; ++row) {
+		convert_row_scalar<src_t, dst_t>(src.data(), dst.data(), row_pixels, 1);
+		checksum += double(dst[row % row_pixels]);
+	}
+	auto scalar_end = std::chrono::steady_clock::now();
+
+	double pixels_count = double(row_pixels) * double(rows_count);
+	double simd_seconds = std::chrono::duration<double>(scalar_start - simd_start).count();
+	double scalar_seconds = std::chrono::duration<double>(scalar_end - scalar_start).count();
+	std::cout << pair_name << ": vectorized " << pixels_count / simd_seconds / 1e6 << " Mpixels/s, scalar " << pixels_count / scalar_seconds / 1e6
+		<< " Mpixels/s, speedup " << scalar_seconds / simd_seconds << " (checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char** argv) {
+	size_t row_pixels = (argc > 1) ? std::stoull(argv[1]) : 4096;
+	size_t rows_count = (argc > 2) ? std::stoull(argv[2]) : 20000;
+#if defined(LX_GEO_ROW_CONVERSION_AVX2)
+	std::cout << "vectorized path: AVX2" << std::endl;
+#elif defined(LX_GEO_ROW_CONVERSION_SSE2)
+	std::cout << "vectorized path: SSE2" << std::endl;
+#else
+	std::cout << "vectorized path: none (scalar only)" << std::endl;
+#endif
+	bench_pair<uint8_t, uint16_t>("uint8 -> uint16", row_pixels, rows_count);
+	bench_pair<uint16_t, uint8_t>("uint16 -> uint8", row_pixels, rows_count);
+	bench_pair<int16_t, uint8_t>("int16 -> uint8", row_pixels, rows_count);
+	bench_pair<uint8_t, float>("uint8 -> float", row_pixels, rows_count);
+	bench_pair<uint16_t, float>("uint16 -> float", row_pixels, rows_count);
+	bench_pair<int16_t, float>("int16 -> float", row_pixels, rows_count);
+	bench_pair<float, double>("float -> double", row_pixels, rows_count);
+	bench_pair<double, float>("double -> float", row_pixels, rows_count);
+	return 0;
+}
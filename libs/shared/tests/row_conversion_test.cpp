@@ -0,0 +1,91 @@
+#include "row_conversion.h"
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace LxGeo::IO_DATA::row_conversion;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& message) {
+	if (!condition) {
+		std::cerr << "FAILED: " << message << std::endl;
+		failures++;
+	}
+}
+
+// Random row over the whole type range, floating rows also hold infinities, signed zeros and out of integer range values
+template <typename src_t>
+static std::vector<src_t> random_row(size_t n, std::mt19937& generator) {
+	std::vector<src_t> row(n);
+	if constexpr (std::is_integral_v<src_t>) {
+		std::uniform_int_distribution<int64_t> distribution(std::numeric_limits<src_t>::min(), std::numeric_limits<src_t>::max());
+		for (src_t& value : row)
+			value = src_t(distribution(generator));
+	}
+	else {
+		std::uniform_real_distribution<double> distribution(-70000.0, 70000.0);
+		const src_t specials[] = { src_t(0), -src_t(0), std::numeric_limits<src_t>::infinity(), -std::numeric_limits<src_t>::infinity(),
+			std::numeric_limits<src_t>::max(), std::numeric_limits<src_t>::lowest(), std::numeric_limits<src_t>::denorm_min(), src_t(255.5) };
+		for (size_t i = 0; i < n; ++i)
+			row[i] = (i % 11 == 0) ? specials[(i / 11) % std::size(specials)] : src_t(distribution(generator));
+	}
+	return row;
+}
+
+/*
+convert_row (vectorized prefix on contiguous rows) must write the same bytes as convert_row_scalar, for every length around the
+vector widths and for unaligned source and destination rows. The vectorized path under test is the one compiled for the target
+(LX_GEO_ROW_CONVERSION_AVX2, else LX_GEO_ROW_CONVERSION_SSE2).
+*/
+template <typename src_t, typename dst_t>
+static void simd_matches_scalar(const std::string& pair_name) {
+	std::mt19937 generator(uint32_t(sizeof(src_t) * 8 + sizeof(dst_t)));
+	const size_t max_length = 100, max_offset = 3;
+	bool matches = true;
+	for (size_t offset = 0; offset <= max_offset && matches; ++offset) {
+		for (size_t length = 0; length <= max_length && matches; ++length) {
+			std::vector<src_t> src = random_row<src_t>(length + offset, generator);
+			std::vector<dst_t> simd_dst(length + offset), scalar_dst(length + offset);
+			convert_row<src_t, dst_t>(src.data() + offset, simd_dst.data() + offset, length);
+			convert_row_scalar<src_t, dst_t>(src.data() + offset, scalar_dst.data() + offset, length, 1);
+			matches = std::memcmp(simd_dst.data(), scalar_dst.data(), simd_dst.size() * sizeof(dst_t)) == 0;
+			if (!matches)
+				check(false, pair_name + ": vectorized row of " + std::to_string(length) + " pixels at offset " + std::to_string(offset) + " differs from scalar");
+		}
+	}
+
+	// interleaved destination (scalar only) fills a single channel
+	std::vector<src_t> src = random_row<src_t>(max_length, generator);
+	std::vector<dst_t> contiguous_dst(max_length), interleaved_dst(max_length * 3, dst_t(0));
+	convert_row<src_t, dst_t>(src.data(), contiguous_dst.data(), max_length);
+	convert_row<src_t, dst_t>(src.data(), interleaved_dst.data() + 1, max_length, 3);
+	bool channel_matches = true;
+	for (size_t i = 0; i < max_length; ++i)
+		channel_matches &= std::memcmp(&interleaved_dst[i * 3 + 1], &contiguous_dst[i], sizeof(dst_t)) == 0 && interleaved_dst[i * 3] == dst_t(0) && interleaved_dst[i * 3 + 2] == dst_t(0);
+	check(channel_matches, pair_name + ": interleaved channel equals the contiguous row");
+}
+
+int main() {
+#if defined(LX_GEO_ROW_CONVERSION_AVX2) && defined(__GNUC__)
+	if (!__builtin_cpu_supports("avx2")) {
+		std::cout << "AVX2 not supported by this CPU, skipped" << std::endl;
+		return 0;
+	}
+#endif
+	// pairs with a vectorized kernel
+	simd_matches_scalar<uint8_t, uint16_t>("uint8 -> uint16");
+	simd_matches_scalar<uint16_t, uint8_t>("uint16 -> uint8");
+	simd_matches_scalar<int16_t, uint8_t>("int16 -> uint8");
+	simd_matches_scalar<uint8_t, float>("uint8 -> float");
+	simd_matches_scalar<uint16_t, float>("uint16 -> float");
+	simd_matches_scalar<int16_t, float>("int16 -> float");
+	simd_matches_scalar<float, double>("float -> double");
+	simd_matches_scalar<double, float>("double -> float");
+	// scalar only pairs
+	simd_matches_scalar<float, uint8_t>("float -> uint8");
+	simd_matches_scalar<int32_t, int16_t>("int32 -> int16");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#include "spatial_index/spatial_indexed_geometry_container.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace LxGeo::GeometryFactoryShared;
+
+/**
+Seconds to build the rtree of random points and boxes, packed (STR bulk loading, 1 thread and all threads computing envelopes)
+against incremental (one insertion per geometry), and seconds of 10000 window queries on each tree.
+Usage: rtree_build_bench [geometries_count ...] (default: 1000000 10000000)
+*/
+
+template <typename geom_type>
+struct BenchContainer : public SpatialIndexedGeometryContainer<geom_type> {
+	std::vector<geom_type> geometries;
+	size_t length() const override { return geometries.size(); }
+	geom_type& operator[](int offset) override { return geometries[offset]; }
+	const geom_type& operator[](int offset) const override { return geometries[offset]; }
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename geom_type>
+static double query_seconds(const BenchContainer<geom_type>& container, size_t& found_count) {
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<double> position(0.0, 10000.0);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t query_idx = 0; query_idx < 10000; query_idx++) {
+		double x = position(generator), y = position(generator);
+		std::vector<typename SpatialIndexedGeometryContainer<geom_type>::Boost_Value> results;
+		container.rtree.query(bgi::intersects(Boost_Box_2(Boost_Point_2(x, y), Boost_Point_2(x + 20, y + 20))), std::back_inserter(results));
+		found_count += results.size();
+	}
+	return seconds_since(start);
+}
+
+template <typename geom_type>
+static void bench_geometries(const std::string& geometries_name, size_t geometries_count) {
+	BenchContainer<geom_type> container;
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<double> position(0.0, 10000.0), size(0.0, 5.0);
+	container.geometries.reserve(geometries_count);
+	for (size_t idx = 0; idx < geometries_count; idx++) {
+		double x = position(generator), y = position(generator);
+		if constexpr (std::is_same_v<geom_type, Boost_Point_2>)
+			container.geometries.push_back(Boost_Point_2(x, y));
+		else
+			container.geometries.push_back(Boost_Box_2(Boost_Point_2(x, y), Boost_Point_2(x + size(generator), y + size(generator))));
+	}
+
+	for (auto [build_name, build_options] : { std::make_pair("packed, 1 thread", RTreeBuildOptions{ true, 1 }),
+		std::make_pair("packed, all threads", RTreeBuildOptions{ true, 0 }), std::make_pair("incremental", RTreeBuildOptions{ false, 1 }) }) {
+		auto start = std::chrono::steady_clock::now();
+		container.init_rtree(build_options);
+		double build_seconds = seconds_since(start);
+		size_t found_count = 0;
+		double queries_seconds = query_seconds(container, found_count);
+		std::cout << geometries_count << " " << geometries_name << ", " << build_name << ": build " << build_seconds << " s, 10000 queries "
+			<< queries_seconds << " s (" << found_count << " found)" << std::endl;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::vector<size_t> geometries_counts;
+	for (int arg_idx = 1; arg_idx < argc; arg_idx++)
+		geometries_counts.push_back(std::stoull(argv[arg_idx]));
+	if (geometries_counts.empty())
+		geometries_counts = { 1000000, 10000000 };
+	for (size_t geometries_count : geometries_counts) {
+		bench_geometries<Boost_Point_2>("points", geometries_count);
+		bench_geometries<Boost_Box_2>("boxes", geometries_count);
+	}
+	return 0;
+}
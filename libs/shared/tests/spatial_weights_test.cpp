@@ -0,0 +1,139 @@
+#include "graph_weights/spatial_weights.h"
+#include <numeric>
+#include <random>
+
+using namespace LxGeo::GeometryFactoryShared;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& message) {
+	if (!condition) {
+		std::cerr << "FAILED: " << message << std::endl;
+		failures++;
+	}
+}
+
+// Unique undirected edges (source < target) of a sparse random graph with islands and many small components
+static std::vector<WeightedEdge> random_edges(size_t n_rows, size_t edges_count, unsigned seed) {
+	std::mt19937 generator(seed);
+	std::uniform_int_distribution<size_t> row_distribution(0, n_rows - 1);
+	std::uniform_real_distribution<double> weight_distribution(0.1, 2.0);
+	std::set<std::pair<size_t, size_t>> pairs;
+	while (pairs.size() < edges_count) {
+		size_t source = row_distribution(generator), target = row_distribution(generator);
+		if (source != target)
+			pairs.insert({ std::min(source, target), std::max(source, target) });
+	}
+	std::vector<WeightedEdge> edges;
+	for (const auto& [source, target] : pairs)
+		edges.push_back({ source, target, weight_distribution(generator) });
+	return edges;
+}
+
+// Breadth first labeling, labels numbered by first vertex
+static std::vector<size_t> reference_components(size_t n_rows, const std::vector<WeightedEdge>& edges) {
+	std::vector<std::vector<size_t>> adjacency(n_rows);
+	for (const WeightedEdge& c_edge : edges) {
+		adjacency[c_edge.source].push_back(c_edge.target);
+		adjacency[c_edge.target].push_back(c_edge.source);
+	}
+	const size_t unlabeled = std::numeric_limits<size_t>::max();
+	std::vector<size_t> labels(n_rows, unlabeled);
+	size_t next_label = 0;
+	for (size_t root = 0; root < n_rows; root++) {
+		if (labels[root] != unlabeled)
+			continue;
+		std::vector<size_t> queue = { root };
+		labels[root] = next_label;
+		for (size_t queue_idx = 0; queue_idx < queue.size(); queue_idx++)
+			for (size_t neighbor : adjacency[queue[queue_idx]])
+				if (labels[neighbor] == unlabeled) {
+					labels[neighbor] = next_label;
+					queue.push_back(neighbor);
+				}
+		next_label++;
+	}
+	return labels;
+}
+
+// Dense row major weights matrix of the edges
+static std::vector<double> reference_matrix(size_t n_rows, const std::vector<WeightedEdge>& edges) {
+	std::vector<double> matrix(n_rows * n_rows, 0.0);
+	for (const WeightedEdge& c_edge : edges) {
+		matrix[c_edge.source * n_rows + c_edge.target] = c_edge.weight;
+		matrix[c_edge.target * n_rows + c_edge.source] = c_edge.weight;
+	}
+	return matrix;
+}
+
+static bool near(double a, double b) {
+	return std::abs(a - b) <= 1e-9 * std::max(1.0, std::abs(b));
+}
+
+static void csr_kernels_match_serial_references() {
+	const size_t n_rows = 600;
+	for (size_t edges_count : { size_t(0), size_t(150), size_t(450), size_t(2000) }) {
+		std::vector<WeightedEdge> edges = random_edges(n_rows, edges_count, unsigned(edges_count + 1));
+		WeightsCSR weights = weights_csr_from_edges(n_rows, edges);
+		std::string case_name = std::to_string(edges_count) + " edges";
+		check(weights.rows_count() == n_rows && weights.non_zeros_count() == 2 * edges.size(), case_name + ": CSR holds every edge in both rows");
+
+		std::vector<size_t> expected_labels = reference_components(n_rows, edges);
+		size_t expected_count = *std::max_element(expected_labels.begin(), expected_labels.end()) + 1;
+		for (size_t n_threads : { 1, 3, 8 }) {
+			std::vector<size_t> labels;
+			size_t components_count = connected_components(weights, labels, n_threads);
+			check(components_count == expected_count && labels == expected_labels, case_name + ": connected components with " + std::to_string(n_threads) + " threads");
+		}
+
+		std::vector<double> matrix = reference_matrix(n_rows, edges);
+		const size_t columns_count = 3;
+		std::vector<double> values(n_rows * columns_count);
+		for (size_t value_idx = 0; value_idx < values.size(); value_idx++)
+			values[value_idx] = double(value_idx % 17) - 8.5;
+		std::vector<double> expected_lag(values.size(), 0.0);
+		for (size_t row = 0; row < n_rows; row++)
+			for (size_t other = 0; other < n_rows; other++)
+				for (size_t column = 0; column < columns_count; column++)
+					expected_lag[row * columns_count + column] += matrix[row * n_rows + other] * values[other * columns_count + column];
+		for (size_t n_threads : { 1, 4 }) {
+			std::vector<double> lag(values.size());
+			spatial_lag(weights, values, columns_count, lag, n_threads);
+			bool lag_matches = true;
+			for (size_t value_idx = 0; value_idx < values.size(); value_idx++)
+				lag_matches &= near(lag[value_idx], expected_lag[value_idx]);
+			check(lag_matches, case_name + ": spatial lag with " + std::to_string(n_threads) + " threads");
+		}
+
+		WeightsCSR standardized = row_standardized(weights);
+		bool standardized_matches = standardized.rows_count() == n_rows;
+		for (size_t row = 0; row < n_rows && standardized_matches; row++) {
+			double row_sum = std::accumulate(matrix.begin() + row * n_rows, matrix.begin() + (row + 1) * n_rows, 0.0);
+			auto c_neighbors = standardized.neighbors(row);
+			auto c_weights = standardized.row_weights(row);
+			standardized_matches &= c_neighbors.size() == weights.degree(row);
+			for (size_t position = 0; position < c_neighbors.size(); position++)
+				standardized_matches &= near(c_weights[position], matrix[row * n_rows + c_neighbors[position]] / row_sum);
+		}
+		check(standardized_matches, case_name + ": row standardized weights");
+	}
+}
+
+// Before any fill_*, the weights have one empty row per geometry (every geometry is an island)
+static void reset_weights_match_geometries() {
+	std::vector<Boost_Point_2> points;
+	for (int point_idx = 0; point_idx < 5; point_idx++)
+		points.push_back(Boost_Point_2(point_idx, 0));
+	SpatialWeights<Boost_Point_2> weights(points);
+	check(weights.weights_csr.rows_count() == points.size(), "reset weights have a row per geometry");
+	weights.run_labeling(2);
+	check(weights.n_components == points.size(), "every geometry is its own component before fill");
+	std::vector<double> lag = weights.spatial_lag(std::vector<double>(points.size(), 1.0));
+	check(lag == std::vector<double>(points.size(), 0.0), "spatial lag of reset weights is null");
+}
+
+int main() {
+	csr_kernels_match_serial_references();
+	reset_weights_match_geometries();
+	return failures == 0 ? 0 : 1;
+}
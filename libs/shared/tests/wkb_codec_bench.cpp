@@ -0,0 +1,53 @@
+#include "wkb_codec.h"
+#include <chrono>
+#include <cmath>
+
+using namespace LxGeo::IO_DATA;
+
+/**
+Features per second of WKB decoding and encoding of polygons (one exterior ring and one hole).
+Usage: wkb_codec_bench [features_count] [ring_vertices]
+*/
+
+int main(int argc, char** argv) {
+	size_t features_count = (argc > 1) ? std::stoull(argv[1]) : 1000000;
+	size_t ring_vertices = (argc > 2) ? std::stoull(argv[2]) : 32;
+
+	Boost_Polygon_2 polygon;
+	for (size_t vertex_idx = 0; vertex_idx < ring_vertices; vertex_idx++) {
+		double angle = -2 * 3.14159265358979 * vertex_idx / ring_vertices;
+		polygon.outer().push_back(Boost_Point_2(100 * std::cos(angle), 100 * std::sin(angle)));
+	}
+	polygon.outer().push_back(polygon.outer().front());
+	polygon.inners().resize(1);
+	for (const Boost_Point_2& c_point : polygon.outer())
+		polygon.inners()[0].insert(polygon.inners()[0].begin(), Boost_Point_2(c_point.get<0>() / 2, c_point.get<1>() / 2));
+
+	std::vector<unsigned char> wkb_data;
+	wkb::encode(polygon, wkb_data);
+
+	// decoded into a new polygon per feature (as loaders do)
+	size_t checksum = 0;
+	auto decode_start = std::chrono::steady_clock::now();
+	for (size_t feature_idx = 0; feature_idx < features_count; feature_idx++) {
+		Boost_Polygon_2 decoded;
+		if (!wkb::decode(wkb_data.data(), wkb_data.size(), decoded))
+			return 1;
+		checksum += decoded.outer().size();
+	}
+	auto encode_start = std::chrono::steady_clock::now();
+	std::vector<unsigned char> encoded;
+	for (size_t feature_idx = 0; feature_idx < features_count; feature_idx++) {
+		wkb::encode(polygon, encoded);
+		checksum += encoded.size();
+	}
+	auto encode_end = std::chrono::steady_clock::now();
+
+	double decode_seconds = std::chrono::duration<double>(encode_start - decode_start).count();
+	double encode_seconds = std::chrono::duration<double>(encode_end - encode_start).count();
+	std::cout << features_count << " polygons of 2 x " << ring_vertices + 1 << " vertices (" << wkb_data.size() << " bytes)" << std::endl;
+	std::cout << "decode: " << features_count / decode_seconds << " features/s" << std::endl;
+	std::cout << "encode: " << features_count / encode_seconds << " features/s" << std::endl;
+	std::cout << "checksum: " << checksum << std::endl;
+	return 0;
+}
@@ -0,0 +1,99 @@
+#include "wkb_codec.h"
+
+using namespace LxGeo::IO_DATA;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& message) {
+	if (!condition) {
+		std::cerr << "FAILED: " << message << std::endl;
+		failures++;
+	}
+}
+
+template <typename geom_type>
+static geom_type from_wkt(const std::string& wkt) {
+	geom_type geometry;
+	bg::read_wkt(wkt, geometry);
+	return geometry;
+}
+
+template <typename geom_type>
+static void round_trip(const geom_type& geometry, const std::string& name) {
+	std::vector<unsigned char> wkb_data;
+	wkb::encode(geometry, wkb_data);
+	check(wkb_data.size() == wkb::encoded_size(geometry), name + ": encoded size");
+	geom_type decoded;
+	check(wkb::decode(wkb_data.data(), wkb_data.size(), decoded), name + ": decoded");
+	check(bg::equals(geometry, decoded), name + ": decoded geometry equals the encoded one");
+	// every truncation is rejected
+	for (size_t size = 0; size < wkb_data.size(); size++) {
+		geom_type truncated;
+		if (wkb::decode(wkb_data.data(), size, truncated))
+			check(false, name + ": blob truncated to " + std::to_string(size) + " bytes is rejected");
+	}
+}
+
+static void round_trips() {
+	round_trip(Boost_Point_2(3.5, -4.25), "point");
+	round_trip(from_wkt<Boost_LineString_2>("LINESTRING(0 0,1 1,2 0.5)"), "linestring");
+	round_trip(from_wkt<Boost_Polygon_2>("POLYGON((0 0,0 10,10 10,10 0,0 0),(2 2,3 2,3 3,2 2),(5 5,6 5,6 6,5 5))"), "polygon with holes");
+
+	Boost_Polygon_2 empty_polygon, decoded_polygon;
+	std::vector<unsigned char> wkb_data;
+	wkb::encode(empty_polygon, wkb_data);
+	check(wkb::decode(wkb_data.data(), wkb_data.size(), decoded_polygon) && decoded_polygon.outer().empty(), "empty polygon");
+}
+
+static void foreign_encodings() {
+	// big endian ISO linestring Z (type 1002) with a single point (1, 2, 3)
+	const unsigned char big_endian_z[] = { 0, 0, 0, 0x03, 0xEA, 0, 0, 0, 1,
+		0x3F, 0xF0, 0, 0, 0, 0, 0, 0, 0x40, 0, 0, 0, 0, 0, 0, 0, 0x40, 0x08, 0, 0, 0, 0, 0, 0 };
+	Boost_LineString_2 linestring;
+	check(wkb::decode(big_endian_z, sizeof(big_endian_z), linestring), "big endian linestring Z is decoded");
+	check(linestring.size() == 1 && linestring[0].get<0>() == 1 && linestring[0].get<1>() == 2, "Z coordinates are skipped");
+
+	// GeoPackage blob with an xy envelope
+	std::vector<unsigned char> point_wkb;
+	wkb::encode(Boost_Point_2(1, 2), point_wkb);
+	std::vector<unsigned char> gpkg_blob = { 'G', 'P', 0, (1 << 1) | 1 };
+	gpkg_blob.resize(8 + 32);
+	gpkg_blob.insert(gpkg_blob.end(), point_wkb.begin(), point_wkb.end());
+	size_t wkb_size = 0;
+	const unsigned char* wkb_data = wkb::gpkg_blob_wkb(gpkg_blob.data(), gpkg_blob.size(), wkb_size);
+	check(wkb_data == gpkg_blob.data() + 40 && wkb_size == point_wkb.size(), "GeoPackage header is skipped");
+}
+
+// Counts read from corrupt blobs are checked against the remaining bytes before any allocation
+static void corrupt_inputs() {
+	// linestring of 0xFFFFFFFF points in 9 bytes
+	const unsigned char huge_linestring[] = { 1, 2, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF };
+	Boost_LineString_2 linestring;
+	check(!wkb::decode(huge_linestring, sizeof(huge_linestring), linestring), "linestring points count over the blob size is rejected");
+
+	// polygon of 0xFFFFFFFF rings
+	const unsigned char huge_rings_count[] = { 1, 3, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF, 4, 0, 0, 0 };
+	Boost_Polygon_2 polygon;
+	check(!wkb::decode(huge_rings_count, sizeof(huge_rings_count), polygon), "rings count over the blob size is rejected");
+
+	// single ring of 0x7FFFFFFF points
+	const unsigned char huge_ring[] = { 1, 3, 0, 0, 0, 1, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0x7F };
+	check(!wkb::decode(huge_ring, sizeof(huge_ring), polygon), "ring points count over the blob size is rejected");
+
+	// ring counts fitting the whole blob but not the bytes left after the header
+	const unsigned char rings_after_header[] = { 1, 3, 0, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0 };
+	check(!wkb::decode(rings_after_header, sizeof(rings_after_header), polygon), "rings count over the remaining bytes is rejected");
+
+	// other geometry types
+	const unsigned char multipoint[] = { 1, 4, 0, 0, 0, 0, 0, 0, 0 };
+	Boost_Point_2 point;
+	check(!wkb::decode(multipoint, sizeof(multipoint), point), "multi geometries are rejected");
+	check(!wkb::decode(multipoint, 0, point), "empty blob is rejected");
+}
+
+int main() {
+	round_trips();
+	foreign_encodings();
+	corrupt_inputs();
+	return failures == 0 ? 0 : 1;
+}